@@ -55,6 +55,8 @@ private:
     virtual void prepared(PointTableRef table);
     virtual bool processOne(PointRef& point);
     virtual void filter(PointView& view);
+    virtual bool concurrentViews() const
+        { return true; }
 
     AssignFilter& operator=(const AssignFilter&) = delete;
     AssignFilter(const AssignFilter&) = delete;
@@ -79,6 +79,9 @@ struct CSArgs
     int m_iterations;
     std::vector<DimRange> m_ignored;
     StringList m_returns;
+    size_t m_threads;
+    double m_tileSize;
+    double m_tileBuffer;
 };
 
 CSFilter::CSFilter() : m_args(new CSArgs)
@@ -101,6 +104,13 @@ void CSFilter::addArgs(ProgramArgs& args)
     args.add("ignore", "Ignore values", m_args->m_ignored);
     args.add("returns", "Include last returns?", m_args->m_returns,
              {"last", "only"});
+    args.add("threads", "Number of tiles processed at once",
+        m_args->m_threads, (size_t)1);
+    args.add("tile_size", "Length of the sides of the tiles processed "
+        "separately (0 to process all points together)", m_args->m_tileSize,
+        0.0);
+    args.add("tile_buffer", "Distance by which tiles are extended",
+        m_args->m_tileBuffer, 50.0);
 }
 
 void CSFilter::addDimensions(PointLayoutPtr layout)
@@ -141,6 +151,10 @@ void CSFilter::prepared(PointTableRef table)
             m_args->m_returns.clear();
         }
     }
+    if (m_args->m_tileSize < 0)
+        throwError("Option 'tile_size' must not be negative.");
+    if (m_args->m_tileBuffer < 0)
+        throwError("Option 'tile_buffer' must not be negative.");
 }
 
 PointViewSet CSFilter::run(PointViewPtr view)
@@ -202,8 +216,30 @@ PointViewSet CSFilter::run(PointViewPtr view)
     if (!firstView->size())
         throwError("No returns to process.");
 
+    if (m_args->m_tileSize > 0)
+    {
+        // Each tile is classified by a filter of its own so that it logs
+        // separately.
+        Segmentation::classifyTiles(firstView, m_args->m_tileSize,
+            m_args->m_tileBuffer, m_args->m_threads, log(),
+            [this](PointViewPtr tile, LogPtr tileLog)
+            {
+                CSFilter f;
+                *f.m_args = *m_args;
+                f.setLog(tileLog);
+                f.classifyGround(tile);
+            });
+    }
+    else
+        classifyGround(firstView);
+
+    return viewSet;
+}
+
+void CSFilter::classifyGround(PointViewPtr view)
+{
     csf::PointCloud csfPC;
-    for (PointRef point : *firstView)
+    for (PointRef point : *view)
     {
         csf::Point p;
         p.x = point.getFieldAs<double>(Id::X);
@@ -232,11 +268,9 @@ PointViewSet CSFilter::run(PointViewPtr view)
     }
 
     for (auto const& i : groundIdx)
-        firstView->setField(Id::Classification, i, 2);
+        view->setField(Id::Classification, i, 2);
     for (auto const& i : offGroundIdx)
-        firstView->setField(Id::Classification, i, 1);
-
-    return viewSet;
+        view->setField(Id::Classification, i, 1);
 }
 
 } // namespace pdal
@@ -59,7 +59,7 @@ private:
     virtual void prepared(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
 
-    void classifyGround(PointViewPtr, std::vector<double>&);
+    void classifyGround(PointViewPtr view);
 };
 
 } // namespace pdal
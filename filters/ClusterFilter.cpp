@@ -65,6 +65,14 @@ void ClusterFilter::addArgs(ProgramArgs& args)
         (std::numeric_limits<uint64_t>::max)());
     args.add("tolerance", "Radius", m_tolerance, 1.0);
     args.add("is3d", "Perform cluster extraction in 3D?", m_is3d, true);
+    args.add("threads", "Number of threads used to run this filter",
+        m_threads, (size_t)1);
+}
+
+void ClusterFilter::initialize()
+{
+    if (!(m_tolerance > 0))
+        throwError("Option 'tolerance' must be greater than 0.");
 }
 
 void ClusterFilter::addDimensions(PointLayoutPtr layout)
@@ -75,7 +83,10 @@ void ClusterFilter::addDimensions(PointLayoutPtr layout)
 void ClusterFilter::filter(PointView& view)
 {
     std::deque<PointIdList> clusters;
-    if (m_is3d)
+    if (m_threads > 1)
+        clusters = Segmentation::extractClusters(view, m_minPoints,
+            m_maxPoints, m_tolerance, m_is3d, m_threads);
+    else if (m_is3d)
         clusters = Segmentation::extractClusters<KD3Index>(view, m_minPoints,
             m_maxPoints, m_tolerance);
     else
@@ -58,8 +58,10 @@ private:
     uint64_t m_maxPoints;
     double m_tolerance;
     bool m_is3d;
+    size_t m_threads;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void filter(PointView& view);
 };
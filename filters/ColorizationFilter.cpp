@@ -38,6 +38,7 @@
 #include <pdal/util/ProgramArgs.hpp>
 #include <pdal/private/gdal/Raster.hpp>
 
+#include <algorithm>
 #include <array>
 
 namespace pdal
@@ -136,6 +137,8 @@ void ColorizationFilter::addArgs(ProgramArgs& args)
 {
     args.add("raster", "Raster filename", m_rasterFilename);
     args.add("dimensions", "Dimensions to use for colorization", m_dimSpec);
+    args.add("sampling", "Raster sampling method ('nearest' or 'bilinear')",
+        m_sampling, gdal::Sampling::Nearest);
 }
 
 
@@ -201,18 +204,19 @@ void ColorizationFilter::ready(PointTableRef table)
 
 bool ColorizationFilter::processOne(PointRef& point)
 {
-    static std::vector<double> data;
-
     double x = point.getFieldAs<double>(Dimension::Id::X);
     double y = point.getFieldAs<double>(Dimension::Id::Y);
 
-    if (m_raster->read(x, y, data) == gdal::GDALError::None)
+    if (m_raster->read(&x, &y, 1, m_data, m_valid, m_sampling) !=
+            gdal::GDALError::None)
+        throwError(m_raster->errorMsg());
+    if (m_valid[0])
     {
         int i(0);
         for (auto bi = m_bands.begin(); bi != m_bands.end(); ++bi)
         {
             BandInfo& b = *bi;
-            point.setField(b.m_dim, data[i] * b.m_scale);
+            point.setField(b.m_dim, m_data[i] * b.m_scale);
             ++i;
         }
     }
@@ -225,11 +229,35 @@ bool ColorizationFilter::processOne(PointRef& point)
 
 void ColorizationFilter::filter(PointView& view)
 {
-    PointRef point = view.point(0);
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Points are looked up in the raster in blocks so that raster blocks
+    // are read once for many points.
+    const point_count_t BlockSize = 4096;
+    for (PointId begin = 0; begin < view.size(); begin += BlockSize)
+        colorize(view, begin, (std::min)(BlockSize, view.size() - begin));
+}
+
+
+void ColorizationFilter::colorize(PointView& view, PointId begin,
+    point_count_t count)
+{
+    std::vector<double> x(count);
+    std::vector<double> y(count);
+    view.getFieldsAs(Dimension::Id::X, begin, count, x.data());
+    view.getFieldsAs(Dimension::Id::Y, begin, count, y.data());
+
+    if (m_raster->read(x.data(), y.data(), count, m_data, m_valid,
+            m_sampling) != gdal::GDALError::None)
+        throwError(m_raster->errorMsg());
+
+    const size_t numBands = m_raster->bandCount();
+    for (point_count_t i = 0; i < count; ++i)
     {
-        point.setPointId(idx);
-        processOne(point);
+        if (!m_valid[i])
+            continue;
+        const double *data = m_data.data() + i * numBands;
+        for (size_t b = 0; b < m_bands.size(); ++b)
+            view.setField(m_bands[b].m_dim, begin + i,
+                data[b] * m_bands[b].m_scale);
     }
 }
 
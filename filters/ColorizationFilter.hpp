@@ -42,7 +42,11 @@
 namespace pdal
 {
 
-namespace gdal { class Raster; }
+namespace gdal
+{
+    class Raster;
+    enum class Sampling;
+}
 
 // Provides GDAL-based raster overlay that places output data in
 // specified dimensions. It also supports scaling the data by a multiplier
@@ -86,8 +90,13 @@ private:
     StringList m_dimSpec;
     std::string m_rasterFilename;
     std::vector<BandInfo> m_bands;
+    gdal::Sampling m_sampling;
 
     std::unique_ptr<gdal::Raster> m_raster;
+    std::vector<double> m_data;
+    std::vector<char> m_valid;
+
+    void colorize(PointView& view, PointId begin, point_count_t count);
 };
 
 } // namespace pdal
@@ -173,7 +173,7 @@ void CovarianceFeaturesFilter::prepared(PointTableRef table)
 
 void CovarianceFeaturesFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
+    KD3Index& kdi = view.build3dIndex(true, m_threads);
 
     point_count_t nloops = view.size();
     std::vector<std::thread> threadList(m_threads);
@@ -44,8 +44,10 @@
 #include "private/Point.hpp"
 #include "private/pnp/GridPnp.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <cstdarg>
+#include <vector>
 
 namespace pdal
 {
@@ -59,6 +61,14 @@ static StaticPluginInfo const s_info
 
 CREATE_STATIC_STAGE(CropFilter, s_info)
 
+namespace
+{
+
+// Number of points whose coordinates are read at a time.
+const point_count_t BlockSize = 4096;
+
+} // unnamed namespace
+
 struct CropArgs
 {
     bool m_cropOutside;
@@ -281,25 +291,45 @@ void CropFilter::crop(const Bounds& box, PointView& input, PointView& output)
 
 }
 
+// Boxes are tested against blocks of coordinates, which avoids a
+// dimension lookup for each coordinate of each point.
 void CropFilter::crop(const BOX3D& box, PointView& input, PointView& output)
 {
-    PointRef point = input.point(0);
-    for (PointId idx = 0; idx < input.size(); ++idx)
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<double> z(BlockSize);
+    std::vector<char> keep(BlockSize);
+    const bool outside = m_args->m_cropOutside;
+    for (PointId begin = 0; begin < input.size(); begin += BlockSize)
     {
-        point.setPointId(idx);
-        if (crop(point, box))
-            output.appendPoint(input, idx);
+        point_count_t count = (std::min)(BlockSize, input.size() - begin);
+        input.getFieldsAs(Dimension::Id::X, begin, count, x.data());
+        input.getFieldsAs(Dimension::Id::Y, begin, count, y.data());
+        input.getFieldsAs(Dimension::Id::Z, begin, count, z.data());
+        for (point_count_t i = 0; i < count; ++i)
+            keep[i] = (outside != box.contains(x[i], y[i], z[i]));
+        for (point_count_t i = 0; i < count; ++i)
+            if (keep[i])
+                output.appendPoint(input, begin + i);
     }
 }
 
 void CropFilter::crop(const BOX2D& box, PointView& input, PointView& output)
 {
-    PointRef point = input.point(0);
-    for (PointId idx = 0; idx < input.size(); ++idx)
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<char> keep(BlockSize);
+    const bool outside = m_args->m_cropOutside;
+    for (PointId begin = 0; begin < input.size(); begin += BlockSize)
     {
-        point.setPointId(idx);
-        if (crop(point, box))
-            output.appendPoint(input, idx);
+        point_count_t count = (std::min)(BlockSize, input.size() - begin);
+        input.getFieldsAs(Dimension::Id::X, begin, count, x.data());
+        input.getFieldsAs(Dimension::Id::Y, begin, count, y.data());
+        for (point_count_t i = 0; i < count; ++i)
+            keep[i] = (outside != box.contains(x[i], y[i]));
+        for (point_count_t i = 0; i < count; ++i)
+            if (keep[i])
+                output.appendPoint(input, begin + i);
     }
 }
 
@@ -39,8 +39,12 @@
 
 #include <pdal/KDIndex.hpp>
 
+#include "private/UnionFind.hpp"
+
+#include <algorithm>
+#include <limits>
 #include <string>
-#include <unordered_set>
+#include <thread>
 
 namespace pdal
 {
@@ -69,6 +73,8 @@ void DBSCANFilter::addArgs(ProgramArgs& args)
     args.add("eps", "Epsilon", m_eps, 1.0);
     args.add("dimensions", "Dimensions to cluster", m_dimStringList,
              {"X", "Y", "Z"});
+    args.add("threads", "Number of threads used to run this filter",
+             m_threads, 1);
 }
 
 void DBSCANFilter::addDimensions(PointLayoutPtr layout)
@@ -94,80 +100,89 @@ void DBSCANFilter::prepared(PointTableRef table)
     }
 }
 
+void DBSCANFilter::parallel(point_count_t count,
+    const std::function<void(PointId)>& f)
+{
+    const int threads = (std::max)(m_threads, 1);
+    std::vector<std::thread> threadList(threads);
+    for (int t = 0; t < threads; t++)
+    {
+        threadList[t] = std::thread(std::bind(
+            [&f](const PointId start, const PointId end) {
+                for (PointId i = start; i < end; i++)
+                    f(i);
+            },
+            t * count / threads,
+            (t + 1) == threads ? count : (t + 1) * count / threads));
+    }
+    for (auto& t : threadList)
+        t.join();
+}
+
 void DBSCANFilter::filter(PointView& view)
 {
     // Construct KDFlexIndex for radius search.
     KDFlexIndex kdfi(view, m_dimIdList);
     kdfi.build();
 
-    // First pass through point cloud precomputes neighbor indices and
-    // initializes ClusterID to -2.
-    std::vector<PointIdList> neighbors(view.size());
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Neighbor lists aren't kept, since they can take much more memory
+    // than the points.  Each pass finds the neighbors it needs again.
+
+    // First pass finds the core points, whose neighborhoods meet the
+    // minimum number of points constraint.
+    std::vector<char> core(view.size());
+    parallel(view.size(), [&](PointId idx)
     {
-        neighbors[idx] = kdfi.radius(idx, m_eps);
-        view.setField(Id::ClusterID, idx, -2);
-    }
+        core[idx] = kdfi.radius(idx, m_eps).size() >= m_minPoints;
+    });
 
-    // Second pass through point cloud performs DBSCAN clustering.
+    // Second pass merges neighboring core points into clusters.  Each
+    // cluster is identified by its smallest core PointId.
+    UnionFind clusters(view.size());
+    parallel(view.size(), [&](PointId idx)
+    {
+        if (!core[idx])
+            return;
+        for (PointId q : kdfi.radius(idx, m_eps))
+            if (q < idx && core[q])
+                clusters.unite(idx, q);
+    });
+
+    // Third pass assigns points that aren't core points to the neighboring
+    // cluster with the smallest identifier, if any.  This is the cluster
+    // that would have reached the point first when clusters are expanded in
+    // order of PointId.  Their unused entries in the union-find hold the
+    // result, and points that stay their own parent are noise.
+    parallel(view.size(), [&](PointId idx)
+    {
+        if (core[idx])
+            return;
+        PointId cluster = (std::numeric_limits<PointId>::max)();
+        for (PointId q : kdfi.radius(idx, m_eps))
+            if (core[q])
+                cluster = (std::min)(cluster, clusters.find(q));
+        if (cluster != (std::numeric_limits<PointId>::max)())
+            clusters.setParent(idx, cluster);
+    });
+
+    // Number the clusters in order of their identifiers, then label the
+    // points.
     int64_t cluster_label = 0;
+    for (PointId idx = 0; idx < view.size(); ++idx)
+        if (core[idx] && clusters.find(idx) == idx)
+            view.setField(Id::ClusterID, idx, cluster_label++);
     for (PointId idx = 0; idx < view.size(); ++idx)
     {
-        // Point has already been labeled, so move on to next.
-        if (view.getFieldAs<int64_t>(Id::ClusterID, idx) != -2)
-            continue;
-
-        // Density of the neighborhood does not meet minimum number of points
-        // constraint, label as noise.
-        if (neighbors[idx].size() < m_minPoints)
+        PointId cluster =
+            core[idx] ? clusters.find(idx) : clusters.parent(idx);
+        if (cluster == idx)
         {
-            view.setField(Id::ClusterID, idx, -1);
+            if (!core[idx])
+                view.setField(Id::ClusterID, idx, -1);
             continue;
         }
-
-        // Initialize some bookkeeping to track which neighbors have been
-        // considered for addition to the current cluster.
-        std::unordered_set<PointId> neighbors_next(neighbors[idx].begin(),
-                                                   neighbors[idx].end());
-        std::unordered_set<PointId> neighbors_visited;
-        neighbors_visited.insert(idx);
-
-        // Unlabeled point encountered; assign cluster label.
-        view.setField(Id::ClusterID, idx, cluster_label);
-
-        // Consider all neighbors.
-        while (!neighbors_next.empty())
-        {
-            // Select first neighbor and move it to the visited set.
-            PointId p = *neighbors_next.begin();
-            neighbors_next.erase(neighbors_next.begin());
-            neighbors_visited.insert(p);
-
-            // Reassign cluster label to neighbor previously marked as noise.
-            if (view.getFieldAs<int64_t>(Id::ClusterID, p) == -1)
-                view.setField(Id::ClusterID, p, cluster_label);
-
-            // Neighbor has already been labeled, so move on to next.
-            if (view.getFieldAs<int64_t>(Id::ClusterID, p) != -2)
-                continue;
-
-            // Assign cluster label to neighbor.
-            view.setField(Id::ClusterID, p, cluster_label);
-
-            // If density of neighbor's neighborhood is sufficient, add it's
-            // neighbors to the set of neighbors to consider if they are not
-            // already.
-            if (neighbors[p].size() >= m_minPoints)
-            {
-                for (PointId q : neighbors[p])
-                {
-                    if (neighbors_visited.count(q) == 0)
-                        neighbors_next.insert(q);
-                }
-            }
-        }
-
-        cluster_label++;
+        view.setField(Id::ClusterID, idx,
+            view.getFieldAs<int64_t>(Id::ClusterID, cluster));
     }
 }
 
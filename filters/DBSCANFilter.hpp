@@ -36,7 +36,9 @@
 
 #include <pdal/Filter.hpp>
 
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace pdal
 {
@@ -58,11 +60,14 @@ private:
     double m_eps;
     StringList m_dimStringList;
     Dimension::IdList m_dimIdList;
+    int m_threads;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void prepared(PointTableRef table);
     virtual void filter(PointView& view);
+
+    void parallel(point_count_t count, const std::function<void(PointId)>& f);
 };
 
 } // namespace pdal
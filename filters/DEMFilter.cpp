@@ -34,6 +34,7 @@
 
 #include "DEMFilter.hpp"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -59,6 +60,7 @@ struct DEMArgs
     DimRange m_range;
     std::string m_raster;
     int32_t m_band;
+    gdal::Sampling m_sampling;
 };
 
 
@@ -83,6 +85,8 @@ void DEMFilter::addArgs(ProgramArgs& args)
     args.add("limits", "Dimension limits for filtering", m_args->m_range).setPositional();
     args.add("raster", "GDAL-readable raster to use for DEM", m_args->m_raster).setPositional();
     args.add("band", "Band number to filter (count from 1)", m_args->m_band, 1);
+    args.add("sampling", "Raster sampling method ('nearest' or 'bilinear')",
+        m_args->m_sampling, gdal::Sampling::Nearest);
 
 }
 
@@ -106,27 +110,30 @@ void DEMFilter::prepared(PointTableRef table)
 }
 
 
-bool DEMFilter::processOne(PointRef& point)
+// Check a point against the raster value read for position 'idx' of the
+// last batch.
+bool DEMFilter::passes(double z, size_t idx) const
 {
-    static std::vector<double> data;
+    if (!m_valid[idx])
+        return false;
+
+    double v = m_data[idx * m_raster->bandCount() + m_args->m_band - 1];
+    double lb = v - m_args->m_range.m_lower_bound;
+    double ub = v + m_args->m_range.m_upper_bound;
+    return (z >= lb && z <= ub);
+}
 
+
+bool DEMFilter::processOne(PointRef& point)
+{
     double x = point.getFieldAs<double>(Dimension::Id::X);
     double y = point.getFieldAs<double>(Dimension::Id::Y);
     double z = point.getFieldAs<double>(m_args->m_dim);
 
-    bool passes(false);
-
-    if (m_raster->read(x, y, data) == gdal::GDALError::None)
-    {
-        double v = data[m_args->m_band-1];
-        double lb = v - m_args->m_range.m_lower_bound;
-        double ub = v + m_args->m_range.m_upper_bound;
-
-
-        if ( z >= lb && z <= ub)
-            passes = true;
-    }
-    return passes;
+    if (m_raster->read(&x, &y, 1, m_data, m_valid, m_args->m_sampling) !=
+            gdal::GDALError::None)
+        throwError(m_raster->errorMsg());
+    return passes(z, 0);
 }
 
 PointViewSet DEMFilter::run(PointViewPtr inView)
@@ -137,11 +144,23 @@ PointViewSet DEMFilter::run(PointViewPtr inView)
 
     PointViewPtr outView = inView->makeNew();
 
-    for (PointId i = 0; i < inView->size(); ++i)
+    // Look up blocks of points in the raster at a time.
+    const point_count_t BlockSize = 4096;
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<double> z(BlockSize);
+    for (PointId begin = 0; begin < inView->size(); begin += BlockSize)
     {
-        PointRef point = inView->point(i);
-        if (processOne(point))
-            outView->appendPoint(*inView, i);
+        point_count_t count = (std::min)(BlockSize, inView->size() - begin);
+        inView->getFieldsAs(Dimension::Id::X, begin, count, x.data());
+        inView->getFieldsAs(Dimension::Id::Y, begin, count, y.data());
+        inView->getFieldsAs(m_args->m_dim, begin, count, z.data());
+        if (m_raster->read(x.data(), y.data(), count, m_data, m_valid,
+                m_args->m_sampling) != gdal::GDALError::None)
+            throwError(m_raster->errorMsg());
+        for (point_count_t i = 0; i < count; ++i)
+            if (passes(z[i], i))
+                outView->appendPoint(*inView, begin + i);
     }
 
     viewSet.insert(outView);
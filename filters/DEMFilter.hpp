@@ -40,13 +40,18 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace pdal
 {
 
 struct DEMArgs;
 
-namespace gdal { class Raster; }
+namespace gdal
+{
+    class Raster;
+    enum class Sampling;
+}
 class Options;
 class PointLayout;
 class PointView;
@@ -63,6 +68,8 @@ private:
 
     std::unique_ptr<DEMArgs> m_args;
     std::unique_ptr<gdal::Raster> m_raster;
+    std::vector<double> m_data;
+    std::vector<char> m_valid;
 
     virtual void ready(PointTableRef table);
     virtual void addArgs(ProgramArgs& args);
@@ -70,6 +77,7 @@ private:
     virtual void prepared(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
     virtual bool processOne(PointRef& point);
+    bool passes(double z, size_t idx) const;
 
     DEMFilter& operator=(const DEMFilter&); // not implemented
     DEMFilter(const DEMFilter&); // not implemented
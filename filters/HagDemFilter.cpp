@@ -34,8 +34,11 @@
 
 #include "HagDemFilter.hpp"
 
+#include <pdal/PointView.hpp>
 #include <pdal/private/gdal/Raster.hpp>
 
+#include <algorithm>
+
 namespace pdal
 {
 
@@ -66,6 +69,8 @@ void HagDemFilter::addArgs(ProgramArgs& args)
     args.add("zero_ground", "If true, set HAG of ground-classified points "
         "to 0 rather than comparing Z value to raster DEM",
         m_zeroGround, true);
+    args.add("sampling", "Raster sampling method ('nearest' or 'bilinear')",
+        m_sampling, gdal::Sampling::Nearest);
 }
 
 
@@ -89,18 +94,45 @@ void HagDemFilter::prepared(PointTableRef table)
 
 void HagDemFilter::filter(PointView& view)
 {
-    PointRef point(view, 0);
-    for (PointId i = 0; i < view.size(); ++i)
+    using namespace pdal::Dimension;
+
+    // Look up blocks of points in the raster at a time.
+    const point_count_t BlockSize = 4096;
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<double> z(BlockSize);
+    const bool hasClass = view.hasDim(Id::Classification);
+    const size_t numBands = m_raster->bandCount();
+    for (PointId begin = 0; begin < view.size(); begin += BlockSize)
     {
-        point.setPointId(i);
-        processOne(point);
+        point_count_t count = (std::min)(BlockSize, view.size() - begin);
+        view.getFieldsAs(Id::X, begin, count, x.data());
+        view.getFieldsAs(Id::Y, begin, count, y.data());
+        view.getFieldsAs(Id::Z, begin, count, z.data());
+        if (m_raster->read(x.data(), y.data(), count, m_data, m_valid,
+                m_sampling) != gdal::GDALError::None)
+            throwError(m_raster->errorMsg());
+
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            const PointId idx = begin + i;
+            // If "zero_ground" option is set, all ground points get HAG of 0
+            if (m_zeroGround && hasClass &&
+                view.getFieldAs<uint8_t>(Id::Classification, idx) ==
+                    ClassLabel::Ground)
+                view.setField(Id::HeightAboveGround, idx, 0);
+            // If raster has a point at X, Y of pointcloud point, use it.
+            // Otherwise the HAG value is not set.
+            else if (m_valid[i])
+                view.setField(Id::HeightAboveGround, idx,
+                    z[i] - m_data[i * numBands + m_band - 1]);
+        }
     }
 }
 
 bool HagDemFilter::processOne(PointRef& point)
 {
     using namespace pdal::Dimension;
-    std::vector<double> data;
 
     // If "zero_ground" option is set, all ground points get HAG of 0
     if (m_zeroGround &&
@@ -115,10 +147,13 @@ bool HagDemFilter::processOne(PointRef& point)
 
         // If raster has a point at X, Y of pointcloud point, use it.
         // Otherwise the HAG value is not set.
-        if (m_raster->read(x, y, data) == gdal::GDALError::None)
+        if (m_raster->read(&x, &y, 1, m_data, m_valid, m_sampling) !=
+                gdal::GDALError::None)
+            throwError(m_raster->errorMsg());
+        if (m_valid[0])
         {
             double z = point.getFieldAs<double>(Id::Z);
-            double hag = z - data[m_band - 1];
+            double hag = z - m_data[m_band - 1];
             point.setField(Dimension::Id::HeightAboveGround, hag);
         }
     }
@@ -40,11 +40,16 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace pdal
 {
 
-namespace gdal { class Raster; }
+namespace gdal
+{
+    class Raster;
+    enum class Sampling;
+}
 class Options;
 class PointLayout;
 class PointView;
@@ -70,6 +75,9 @@ private:
     std::string m_rasterName;
     bool m_zeroGround;
     int32_t m_band;
+    gdal::Sampling m_sampling;
+    std::vector<double> m_data;
+    std::vector<char> m_valid;
 };
 
 } // namespace pdal
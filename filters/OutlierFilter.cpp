@@ -67,6 +67,8 @@ void OutlierFilter::addArgs(ProgramArgs& args)
     args.add("mean_k", "Mean number of neighbors", m_meanK, 8);
     args.add("multiplier", "Standard deviation threshold", m_multiplier, 2.0);
     args.add("class", "Class to use for noise points", m_class, ClassLabel::LowPoint);
+    args.add("threads", "Number of threads used to find neighbors",
+        m_threads, (size_t)1);
 }
 
 void OutlierFilter::addDimensions(PointLayoutPtr layout)
@@ -74,22 +76,43 @@ void OutlierFilter::addDimensions(PointLayoutPtr layout)
     layout->registerDim(Dimension::Id::Classification);
 }
 
+namespace
+{
+
+// Number of points whose neighbors are found in one batch.
+const point_count_t BatchSize = 65536;
+
+PointIdList batchIds(PointId start, point_count_t np)
+{
+    PointIdList ids((std::min)(BatchSize, np - start));
+    for (size_t i = 0; i < ids.size(); ++i)
+        ids[i] = start + i;
+    return ids;
+}
+
+} // unnamed namespace
+
 Indices OutlierFilter::processRadius(PointViewPtr inView)
 {
     KD3Index index(*inView);
-    index.build();
+    index.build(true, m_threads);
 
     point_count_t np = inView->size();
 
     PointIdList inliers, outliers;
 
-    for (PointId i = 0; i < np; ++i)
+    for (PointId start = 0; start < np; start += BatchSize)
     {
-        auto ids = index.radius(i, m_radius);
-        if (ids.size() > size_t(m_minK))
-            inliers.push_back(i);
-        else
-            outliers.push_back(i);
+        PointIdList ids = batchIds(start, np);
+        std::vector<PointIdList> neighbors =
+            index.radius(ids, m_radius, m_threads);
+        for (size_t j = 0; j < ids.size(); ++j)
+        {
+            if (neighbors[j].size() > size_t(m_minK))
+                inliers.push_back(ids[j]);
+            else
+                outliers.push_back(ids[j]);
+        }
     }
 
     return Indices{inliers, outliers};
@@ -98,7 +121,7 @@ Indices OutlierFilter::processRadius(PointViewPtr inView)
 Indices OutlierFilter::processStatistical(PointViewPtr inView)
 {
     KD3Index index(*inView);
-    index.build();
+    index.build(true, m_threads);
 
     point_count_t np = inView->size();
 
@@ -109,20 +132,23 @@ Indices OutlierFilter::processStatistical(PointViewPtr inView)
     // we increase the count by one because the query point itself will
     // be included with a distance of 0
     point_count_t count = m_meanK + 1;
-    PointIdList indices(count);
-    std::vector<double> sqr_dists(count);
-    for (PointId i = 0; i < np; ++i)
+    std::vector<PointIdList> indices;
+    std::vector<std::vector<double>> sqr_dists;
+    for (PointId start = 0; start < np; start += BatchSize)
     {
+        PointIdList ids = batchIds(start, np);
+        index.knnSearch(ids, count, &indices, &sqr_dists, m_threads);
 
-        index.knnSearch(i, count, &indices, &sqr_dists);
-
-        for (size_t j = 1; j < count; ++j)
+        for (size_t b = 0; b < ids.size(); ++b)
         {
-            double delta = std::sqrt(sqr_dists[j]) - distances[i];
-            distances[i] += (delta / j);
+            PointId i = ids[b];
+            const std::vector<double>& dists = sqr_dists[b];
+            for (size_t j = 1; j < dists.size(); ++j)
+            {
+                double delta = std::sqrt(dists[j]) - distances[i];
+                distances[i] += (delta / j);
+            }
         }
-        indices.clear(); indices.resize(count);
-        sqr_dists.clear(); sqr_dists.resize(count);
     }
 
     size_t n(0);
@@ -67,6 +67,7 @@ private:
     int m_meanK;
     double m_multiplier;
     uint8_t m_class;
+    size_t m_threads;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
@@ -34,6 +34,9 @@
 
 #include "OverlayFilter.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 #include <ogr_api.h>
@@ -122,11 +125,73 @@ void OverlayFilter::ready(PointTableRef table)
         int32_t fieldVal = OGR_F_GetFieldAsInteger(feature.get(), field_index);
 
         m_polygons.push_back(
-            { Polygon(geom, table.anySpatialReference()), fieldVal} );
+            { Polygon(geom, table.anySpatialReference()), fieldVal, BOX2D()} );
 
         feature = OGRFeaturePtr(OGR_L_GetNextFeature(m_lyr), featureDeleter);
     }
     while (feature);
+    buildIndex();
+}
+
+
+// Build a grid over the bounds of the polygons so that only the polygons
+// that may contain a point need to be tested.
+void OverlayFilter::buildIndex()
+{
+    m_extent.clear();
+    for (auto& poly : m_polygons)
+    {
+        poly.bounds = poly.geom.bounds().to2d();
+        m_extent.grow(poly.bounds);
+    }
+
+    m_cells.clear();
+    m_gridSize = 0;
+    if (m_polygons.empty())
+        return;
+
+    // Use about one cell per polygon.
+    m_gridSize = (size_t)std::ceil(std::sqrt((double)m_polygons.size()));
+    m_gridSize = Utils::clamp(m_gridSize, (size_t)1, (size_t)4096);
+    m_cellWidth = (m_extent.maxx - m_extent.minx) / m_gridSize;
+    m_cellHeight = (m_extent.maxy - m_extent.miny) / m_gridSize;
+    if (m_cellWidth <= 0)
+        m_cellWidth = 1;
+    if (m_cellHeight <= 0)
+        m_cellHeight = 1;
+    m_cells.resize(m_gridSize * m_gridSize);
+
+    auto pos = [this](double v, double min, double width)
+    {
+        return (std::min)((size_t)((v - min) / width), m_gridSize - 1);
+    };
+
+    for (uint32_t i = 0; i < m_polygons.size(); ++i)
+    {
+        const BOX2D& b = m_polygons[i].bounds;
+        size_t x0 = pos(b.minx, m_extent.minx, m_cellWidth);
+        size_t x1 = pos(b.maxx, m_extent.minx, m_cellWidth);
+        size_t y0 = pos(b.miny, m_extent.miny, m_cellHeight);
+        size_t y1 = pos(b.maxy, m_extent.miny, m_cellHeight);
+        for (size_t y = y0; y <= y1; ++y)
+            for (size_t x = x0; x <= x1; ++x)
+                m_cells[y * m_gridSize + x].push_back(i);
+    }
+}
+
+
+// Find the grid cell of a position. Returns false if the position is
+// outside of all polygons' bounds.
+bool OverlayFilter::cellIndex(double x, double y, size_t& cell) const
+{
+    if (!m_gridSize || !m_extent.contains(x, y))
+        return false;
+    size_t xpos = (std::min)((size_t)((x - m_extent.minx) / m_cellWidth),
+        m_gridSize - 1);
+    size_t ypos = (std::min)((size_t)((y - m_extent.miny) / m_cellHeight),
+        m_gridSize - 1);
+    cell = ypos * m_gridSize + xpos;
+    return true;
 }
 
 
@@ -140,32 +205,73 @@ void OverlayFilter::spatialReferenceChanged(const SpatialReference& srs)
         if (!ok)
             throwError(ok.what());
     }
+    buildIndex();
 }
 
 
-bool OverlayFilter::processOne(PointRef& point)
+// Set the dimension value from the first candidate polygon that contains
+// the point.
+void OverlayFilter::overlay(PointRef& point, double x, double y,
+    const std::vector<uint32_t>& candidates)
 {
-    for (const auto& poly : m_polygons)
+    for (uint32_t i : candidates)
     {
-        double x = point.getFieldAs<double>(Dimension::Id::X);
-        double y = point.getFieldAs<double>(Dimension::Id::Y);
-        if (poly.geom.contains(x, y))
+        const PolyVal& poly = m_polygons[i];
+        if (poly.bounds.contains(x, y) && poly.geom.contains(x, y))
         {
             point.setField(m_dim, poly.val);
             break;
         }
     }
+}
+
+
+bool OverlayFilter::processOne(PointRef& point)
+{
+    double x = point.getFieldAs<double>(Dimension::Id::X);
+    double y = point.getFieldAs<double>(Dimension::Id::Y);
+    size_t cell;
+    if (cellIndex(x, y, cell))
+        overlay(point, x, y, m_cells[cell]);
     return true;
 }
 
 
 void OverlayFilter::filter(PointView& view)
 {
-    PointRef point(view, 0);
+    // Bin the points by grid cell so that the points of a cell are tested
+    // against its polygons together.
+    const uint32_t outside = (std::numeric_limits<uint32_t>::max)();
+    std::vector<uint32_t> cells(view.size());
+    std::vector<PointId> start(m_cells.size() + 1);
     for (PointId id = 0; id < view.size(); ++id)
+    {
+        double x = view.getFieldAs<double>(Dimension::Id::X, id);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, id);
+        size_t cell;
+        if (cellIndex(x, y, cell))
+        {
+            cells[id] = (uint32_t)cell;
+            start[cell + 1]++;
+        }
+        else
+            cells[id] = outside;
+    }
+    for (size_t i = 1; i < start.size(); ++i)
+        start[i] += start[i - 1];
+
+    std::vector<PointId> order(start.back());
+    for (PointId id = 0; id < view.size(); ++id)
+        if (cells[id] != outside)
+            order[start[cells[id]]++] = id;
+
+    PointRef point(view, 0);
+    for (PointId id : order)
     {
         point.setPointId(id);
-        processOne(point);
+        double x = point.getFieldAs<double>(Dimension::Id::X);
+        double y = point.getFieldAs<double>(Dimension::Id::Y);
+        overlay(point, x, y, m_cells[cells[id]]);
     }
 }
 
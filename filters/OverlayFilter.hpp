@@ -64,10 +64,11 @@ class PDAL_DLL OverlayFilter : public Filter, public Streamable
     {
         Polygon geom;
         int32_t val;
+        BOX2D bounds;
     };
 
 public:
-    OverlayFilter() : m_ds(0), m_lyr(0)
+    OverlayFilter() : m_ds(0), m_lyr(0), m_gridSize(0)
     {}
 
     std::string getName() const { return "filters.overlay"; }
@@ -81,6 +82,11 @@ private:
     virtual void ready(PointTableRef table);
     virtual void filter(PointView& view);
 
+    void buildIndex();
+    bool cellIndex(double x, double y, size_t& cell) const;
+    void overlay(PointRef& point, double x, double y,
+        const std::vector<uint32_t>& candidates);
+
     OverlayFilter& operator=(const OverlayFilter&) = delete;
     OverlayFilter(const OverlayFilter&) = delete;
 
@@ -95,6 +101,14 @@ private:
     std::string m_layer;
     Dimension::Id m_dim;
     std::vector<PolyVal> m_polygons;
+
+    // Grid over the polygons. Each cell lists, in order, the polygons whose
+    // bounds overlap the cell.
+    BOX2D m_extent;
+    size_t m_gridSize;
+    double m_cellWidth;
+    double m_cellHeight;
+    std::vector<std::vector<uint32_t>> m_cells;
 };
 
 } // namespace pdal
@@ -65,6 +65,9 @@ struct PMFArgs
     double m_maxDistance;
     double m_maxWindowSize;
     double m_slope;
+    size_t m_threads;
+    double m_tileSize;
+    double m_tileBuffer;
 };
 
 CREATE_STATIC_STAGE(PMFFilter, s_info)
@@ -92,6 +95,13 @@ void PMFFilter::addArgs(ProgramArgs& args)
     args.add("max_window_size", "Maximum window size", m_args->m_maxWindowSize,
              33.0);
     args.add("slope", "Slope", m_args->m_slope, 1.0);
+    args.add("threads", "Number of threads used for raster operations "
+        "or tiles", m_args->m_threads, (size_t)1);
+    args.add("tile_size", "Length of the sides of the tiles processed "
+        "separately (0 to process all points together)", m_args->m_tileSize,
+        0.0);
+    args.add("tile_buffer", "Distance by which tiles are extended",
+        m_args->m_tileBuffer, 50.0);
 }
 
 void PMFFilter::addDimensions(PointLayoutPtr layout)
@@ -133,6 +143,10 @@ void PMFFilter::prepared(PointTableRef table)
             m_args->m_returns.clear();
         }
     }
+    if (m_args->m_tileSize < 0)
+        throwError("Option 'tile_size' must not be negative.");
+    if (m_args->m_tileBuffer < 0)
+        throwError("Option 'tile_buffer' must not be negative.");
 }
 
 PointViewSet PMFFilter::run(PointViewPtr input)
@@ -194,19 +208,35 @@ PointViewSet PMFFilter::run(PointViewPtr input)
     if (!inlierView->size())
         throwError("No returns to process.");
 
-    // Classify remaining points with value of 1. processGround will mark ground
-    // returns as 2.
-    for (PointRef p : *inlierView)
-        p.setField(Id::Classification, ClassLabel::Unclassified);
-
-    // Run the actual PMF algorithm.
-    processGround(inlierView);
+    if (m_args->m_tileSize > 0)
+    {
+        // Each tile is classified by a filter of its own so that it logs
+        // separately.  Raster operations aren't split over threads when the
+        // tiles are.
+        Segmentation::classifyTiles(inlierView, m_args->m_tileSize,
+            m_args->m_tileBuffer, m_args->m_threads, log(),
+            [this](PointViewPtr tile, LogPtr tileLog)
+            {
+                PMFFilter f;
+                *f.m_args = *m_args;
+                f.m_args->m_threads = 1;
+                f.setLog(tileLog);
+                f.processGround(tile);
+            });
+    }
+    else
+        processGround(inlierView);
 
     return viewSet;
 }
 
 void PMFFilter::processGround(PointViewPtr view)
 {
+    // Classify points with value of 1. The PMF algorithm will mark ground
+    // returns as 2.
+    for (PointRef p : *view)
+        p.setField(Id::Classification, ClassLabel::Unclassified);
+
     // initialize bounds, rows, columns, and surface
     BOX2D bounds;
     view->calculateBounds(bounds);
@@ -322,8 +352,8 @@ void PMFFilter::processGround(PointViewPtr view)
             << ", window size = " << wsvec[j] << ")...\n";
 
         int iters = static_cast<int>(0.5 * (wsvec[j] - 1));
-        math::erodeDiamond(ZImin, rows, cols, iters);
-        math::dilateDiamond(ZImin, rows, cols, iters);
+        math::erodeDiamond(ZImin, rows, cols, iters, m_args->m_threads);
+        math::dilateDiamond(ZImin, rows, cols, iters, m_args->m_threads);
 
         PointIdList groundNewIdx;
         for (PointId const& p_idx : groundIdx)
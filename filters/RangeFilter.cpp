@@ -39,6 +39,7 @@
 
 #include "private/DimRange.hpp"
 
+#include <algorithm>
 #include <cctype>
 #include <limits>
 #include <map>
@@ -110,11 +111,30 @@ PointViewSet RangeFilter::run(PointViewPtr inView)
 
     PointViewPtr outView = inView->makeNew();
 
-    for (PointId i = 0; i < inView->size(); ++i)
+    // Test the ranges against a block of values of a dimension at a time.
+    // This applies the same logic as processOne().
+    const point_count_t BlockSize = 4096;
+    std::vector<double> values(BlockSize);
+    std::vector<char> passes(BlockSize);
+    std::vector<char> keep(BlockSize);
+    for (PointId begin = 0; begin < inView->size(); begin += BlockSize)
     {
-        PointRef point = inView->point(i);
-        if (processOne(point))
-            outView->appendPoint(*inView, i);
+        point_count_t count = (std::min)(BlockSize, inView->size() - begin);
+        std::fill(keep.begin(), keep.begin() + count, 1);
+        for (auto r = m_ranges.begin(); r != m_ranges.end();)
+        {
+            const Dimension::Id id = r->m_id;
+            inView->getFieldsAs(id, begin, count, values.data());
+            std::fill(passes.begin(), passes.begin() + count, 0);
+            for (; r != m_ranges.end() && r->m_id == id; ++r)
+                for (point_count_t i = 0; i < count; ++i)
+                    passes[i] |= (char)r->valuePasses(values[i]);
+            for (point_count_t i = 0; i < count; ++i)
+                keep[i] &= passes[i];
+        }
+        for (point_count_t i = 0; i < count; ++i)
+            if (keep[i])
+                outView->appendPoint(*inView, begin + i);
     }
 
     viewSet.insert(outView);
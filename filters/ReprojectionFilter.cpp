@@ -34,6 +34,9 @@
 
 #include "ReprojectionFilter.hpp"
 
+#include <exception>
+#include <thread>
+
 #include <pdal/PointView.hpp>
 #include <pdal/private/SrsTransform.hpp>
 #include <pdal/util/ProgramArgs.hpp>
@@ -43,6 +46,18 @@
 namespace pdal
 {
 
+namespace
+{
+
+// Points transformed per call to the transform.
+const point_count_t BlockSize = 4096;
+
+// Creating a transform is expensive, so don't start a thread for
+// fewer points than this.
+const point_count_t MinThreadPoints = 100000;
+
+} // unnamed namespace
+
 static StaticPluginInfo const s_info
 {
     "filters.reprojection",
@@ -54,7 +69,8 @@ CREATE_STATIC_STAGE(ReprojectionFilter, s_info)
 
 std::string ReprojectionFilter::getName() const { return s_info.name; }
 
-ReprojectionFilter::ReprojectionFilter() : m_inferInputSRS(true)
+ReprojectionFilter::ReprojectionFilter() : m_inferInputSRS(true),
+    m_errorOnFailure(false), m_threads(1)
 {}
 
 
@@ -70,6 +86,8 @@ void ReprojectionFilter::addArgs(ProgramArgs& args)
     args.add("out_axis_ordering", "Axis ordering override for out_srs", m_outAxisOrderingArg, {} );
     args.add("error_on_failure", "Throw an exception if we can't reproject any point",
         m_errorOnFailure);
+    args.add("threads", "Number of threads used to transform points",
+        m_threads, 1);
 }
 
 
@@ -148,17 +166,17 @@ void ReprojectionFilter::createTransform(const SpatialReference& srsSRS)
     }
 
 
+    m_transform.reset(makeTransform());
+}
+
+
+SrsTransform *ReprojectionFilter::makeTransform() const
+{
     // If either vector is empty, GDAL's default ordering is used.
     if (m_inAxisOrdering.size() || m_outAxisOrdering.size())
-    {
-
-        m_transform.reset(new SrsTransform(m_inSRS,
-                                           m_inAxisOrdering,
-                                           m_outSRS,
-                                           m_outAxisOrdering));
-    } else {
-        m_transform.reset(new SrsTransform(m_inSRS, m_outSRS));
-    }
+        return new SrsTransform(m_inSRS, m_inAxisOrdering,
+            m_outSRS, m_outAxisOrdering);
+    return new SrsTransform(m_inSRS, m_outSRS);
 }
 
 
@@ -169,12 +187,56 @@ PointViewSet ReprojectionFilter::run(PointViewPtr view)
 
     createTransform(view->spatialReference());
 
-    PointRef point(*view, 0);
-    for (PointId id = 0; id < view->size(); ++id)
+    // Transforms can't be shared between threads, so each thread other
+    // than this one transforms its range of points with its own transform.
+    const point_count_t size = view->size();
+    const point_count_t maxThreads =
+        (std::max)(size / MinThreadPoints, (point_count_t)1);
+    const int threads = (int)(std::min)(
+        (point_count_t)(std::max)(m_threads, 1), maxThreads);
+
+    std::vector<char> ok(size);
+    std::vector<std::thread> threadList;
+    std::vector<std::exception_ptr> errors(threads);
+    for (int t = 1; t < threads; ++t)
     {
-        point.setPointId(id);
-        if (processOne(point))
+        const PointId begin = t * size / threads;
+        const PointId end = (t + 1) * size / threads;
+        threadList.emplace_back([this, &view, &ok, &errors, t, begin, end]()
+        {
+            try
+            {
+                std::unique_ptr<SrsTransform> transform(makeTransform());
+                transformRange(*view, *transform, begin, end, ok);
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    try
+    {
+        transformRange(*view, *m_transform, 0, size / threads, ok);
+    }
+    catch (...)
+    {
+        errors[0] = std::current_exception();
+    }
+    for (std::thread& t : threadList)
+        t.join();
+    for (std::exception_ptr& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+
+    for (PointId id = 0; id < size; ++id)
+    {
+        if (ok[id])
             outView->appendPoint(*view, id);
+        else if (m_errorOnFailure)
+            transformError(view->getFieldAs<double>(Dimension::Id::X, id),
+                view->getFieldAs<double>(Dimension::Id::Y, id),
+                view->getFieldAs<double>(Dimension::Id::Z, id));
     }
 
     viewSet.insert(outView);
@@ -182,6 +244,92 @@ PointViewSet ReprojectionFilter::run(PointViewPtr view)
 }
 
 
+// Transform the points [begin, end) of a view a block at a time, noting
+// in 'ok' the points that were transformed.  Points that can't be
+// transformed are left as they were.
+void ReprojectionFilter::transformRange(PointView& view,
+    const SrsTransform& transform, PointId begin, PointId end,
+    std::vector<char>& ok) const
+{
+    using namespace Dimension;
+
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<double> z(BlockSize);
+    std::vector<int> success(BlockSize);
+    for (PointId idx = begin; idx < end; idx += BlockSize)
+    {
+        point_count_t count = (std::min)(BlockSize, end - idx);
+        view.getFieldsAs(Id::X, idx, count, x.data());
+        view.getFieldsAs(Id::Y, idx, count, y.data());
+        view.getFieldsAs(Id::Z, idx, count, z.data());
+        if (!transform.transform(count, x.data(), y.data(), z.data(),
+                success.data()))
+        {
+            for (point_count_t i = 0; i < count; ++i)
+                if (!success[i])
+                {
+                    x[i] = view.getFieldAs<double>(Id::X, idx + i);
+                    y[i] = view.getFieldAs<double>(Id::Y, idx + i);
+                    z[i] = view.getFieldAs<double>(Id::Z, idx + i);
+                }
+        }
+        view.setFields(Id::X, idx, count, x.data());
+        view.setFields(Id::Y, idx, count, y.data());
+        view.setFields(Id::Z, idx, count, z.data());
+        for (point_count_t i = 0; i < count; ++i)
+            ok[idx + i] = (success[i] != 0);
+    }
+}
+
+
+void ReprojectionFilter::processBatch(StreamPointTable& table,
+    point_count_t count, const std::vector<char> *pass)
+{
+    using namespace Dimension;
+
+    m_ids.clear();
+    for (PointId idx = 0; idx < count; ++idx)
+        if (!table.skip(idx) && (!pass || (*pass)[idx]))
+            m_ids.push_back(idx);
+
+    const size_t size = m_ids.size();
+    m_x.resize(size);
+    m_y.resize(size);
+    m_z.resize(size);
+    m_success.resize(size);
+
+    PointRef point(table, 0);
+    for (size_t i = 0; i < size; ++i)
+    {
+        point.setPointId(m_ids[i]);
+        m_x[i] = point.getFieldAs<double>(Id::X);
+        m_y[i] = point.getFieldAs<double>(Id::Y);
+        m_z[i] = point.getFieldAs<double>(Id::Z);
+    }
+
+    m_transform->transform(size, m_x.data(), m_y.data(), m_z.data(),
+        m_success.data());
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        point.setPointId(m_ids[i]);
+        if (m_success[i])
+        {
+            point.setField(Id::X, m_x[i]);
+            point.setField(Id::Y, m_y[i]);
+            point.setField(Id::Z, m_z[i]);
+        }
+        else if (m_errorOnFailure)
+            transformError(point.getFieldAs<double>(Id::X),
+                point.getFieldAs<double>(Id::Y),
+                point.getFieldAs<double>(Id::Z));
+        else
+            table.setSkip(m_ids[i]);
+    }
+}
+
+
 bool ReprojectionFilter::processOne(PointRef& point)
 {
     double x(point.getFieldAs<double>(Dimension::Id::X));
@@ -196,11 +344,18 @@ bool ReprojectionFilter::processOne(PointRef& point)
         point.setField(Dimension::Id::Z, z);
     }
     else if (m_errorOnFailure)
-        throwError("Couldn't reproject point with X/Y/Z coordinates of (" +
-            std::to_string(point.getFieldAs<double>(Dimension::Id::X)) + ", " +
-            std::to_string(point.getFieldAs<double>(Dimension::Id::Y)) + ", " +
-            std::to_string(point.getFieldAs<double>(Dimension::Id::Z)) + ").");
+        transformError(point.getFieldAs<double>(Dimension::Id::X),
+            point.getFieldAs<double>(Dimension::Id::Y),
+            point.getFieldAs<double>(Dimension::Id::Z));
     return ok;
 }
 
+
+void ReprojectionFilter::transformError(double x, double y, double z) const
+{
+    throwError("Couldn't reproject point with X/Y/Z coordinates of (" +
+        std::to_string(x) + ", " + std::to_string(y) + ", " +
+        std::to_string(z) + ").");
+}
+
 } // namespace pdal
@@ -60,10 +60,16 @@ private:
     virtual void initialize();
     virtual PointViewSet run(PointViewPtr view);
     virtual bool processOne(PointRef& point);
+    virtual void processBatch(StreamPointTable& table, point_count_t count,
+        const std::vector<char> *pass);
     virtual void spatialReferenceChanged(const SpatialReference& srs);
     virtual void prepared(PointTableRef table);
 
     void createTransform(const SpatialReference& srs);
+    SrsTransform *makeTransform() const;
+    void transformRange(PointView& view, const SrsTransform& transform,
+        PointId begin, PointId end, std::vector<char>& ok) const;
+    void transformError(double x, double y, double z) const;
 
     SpatialReference m_inSRS;
     SpatialReference m_outSRS;
@@ -74,6 +80,14 @@ private:
     std::vector<int> m_inAxisOrdering;
     std::vector<int> m_outAxisOrdering;
     bool m_errorOnFailure;
+    int m_threads;
+
+    // Buffers for streaming batches.
+    PointIdList m_ids;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_z;
+    std::vector<int> m_success;
 };
 
 } // namespace pdal
@@ -92,6 +92,9 @@ struct SMRArgs
     StringList m_returns;
     Segmentation::PointClasses m_classbits;
     Arg *m_windowArg;
+    size_t m_threads;
+    double m_tileSize;
+    double m_tileBuffer;
 };
 
 SMRFilter::SMRFilter() : m_args(new SMRArgs) {}
@@ -118,6 +121,13 @@ void SMRFilter::addArgs(ProgramArgs& args)
         "classification bits?", m_args->m_classbits);
     m_args->m_windowArg = &args.add("window", "Max window size?",
         m_args->m_window);
+    args.add("threads", "Number of threads used for raster operations "
+        "or tiles", m_args->m_threads, (size_t)1);
+    args.add("tile_size", "Length of the sides of the tiles processed "
+        "separately (0 to process all points together)", m_args->m_tileSize,
+        0.0);
+    args.add("tile_buffer", "Distance by which tiles are extended",
+        m_args->m_tileBuffer, 50.0);
 }
 
 void SMRFilter::addDimensions(PointLayoutPtr layout)
@@ -160,6 +170,10 @@ void SMRFilter::prepared(PointTableRef table)
     }
     if (!m_args->m_windowArg->set())
         m_args->m_window = 18 * m_args->m_cell;
+    if (m_args->m_tileSize < 0)
+        throwError("Option 'tile_size' must not be negative.");
+    if (m_args->m_tileBuffer < 0)
+        throwError("Option 'tile_buffer' must not be negative.");
 }
 
 void SMRFilter::ready(PointTableRef table)
@@ -234,6 +248,31 @@ PointViewSet SMRFilter::run(PointViewPtr view)
     if (!inlierView->size())
         throwError("No returns to process.");
 
+    if (m_args->m_tileSize > 0)
+    {
+        // Each tile is classified by a filter of its own, which holds the
+        // rasters of the tile.  Raster operations aren't split over threads
+        // when the tiles are, and the rasters of tiles aren't written.
+        Segmentation::classifyTiles(inlierView, m_args->m_tileSize,
+            m_args->m_tileBuffer, m_args->m_threads, log(),
+            [this](PointViewPtr tile, LogPtr tileLog)
+            {
+                SMRFilter f;
+                *f.m_args = *m_args;
+                f.m_args->m_threads = 1;
+                f.m_args->m_dir.clear();
+                f.setLog(tileLog);
+                f.classify(tile);
+            });
+    }
+    else
+        classify(inlierView);
+
+    return viewSet;
+}
+
+void SMRFilter::classify(PointViewPtr inlierView)
+{
     // Classify remaining points with value of 1. SMRF processing will mark
     // ground returns as 2.
     for (PointRef p : *inlierView)
@@ -277,8 +316,6 @@ PointViewSet SMRFilter::run(PointViewPtr view)
     // Classify ground returns by comparing elevation values to the provisional
     // DEM.
     classifyGround(inlierView, ZIpro);
-
-    return viewSet;
 }
 
 void SMRFilter::classifyGround(PointViewPtr view, std::vector<double>& ZIpro)
@@ -522,8 +559,9 @@ std::vector<double> SMRFilter::createZInet(std::vector<double> const& ZImin,
     {
         std::vector<double> dilated = ZImin;
         int v = ceil<int>(m_args->m_cut / m_args->m_cell);
-        math::erodeDiamond(dilated, m_rows, m_cols, 2 * v);
-        math::dilateDiamond(dilated, m_rows, m_cols, 2 * v);
+        math::erodeDiamond(dilated, m_rows, m_cols, 2 * v, m_args->m_threads);
+        math::dilateDiamond(dilated, m_rows, m_cols, 2 * v,
+            m_args->m_threads);
         for (auto c = 0; c < m_cols; ++c)
         {
             for (auto r = 0; r < m_rows; ++r)
@@ -672,9 +710,10 @@ std::vector<int> SMRFilter::progressiveFilter(std::vector<double> const& ZImin,
     {
         // "On the first iteration, the minimum surface (ZImin) is opened using
         // a disk-shaped structuring element with a radius of one pixel."
-        math::erodeDiamond(erosion, m_rows, m_cols, 1);
+        math::erodeDiamond(erosion, m_rows, m_cols, 1, m_args->m_threads);
         std::vector<double> curOpening = erosion;
-        math::dilateDiamond(curOpening, m_rows, m_cols, radius);
+        math::dilateDiamond(curOpening, m_rows, m_cols, radius,
+            m_args->m_threads);
 
         // "An elevation threshold is then calculated, where the value is equal
         // to the supplied slope tolerance parameter multiplied by the product
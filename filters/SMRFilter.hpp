@@ -67,6 +67,7 @@ private:
     virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
 
+    void classify(PointViewPtr view);
     void classifyGround(PointViewPtr, std::vector<double>&);
     std::vector<int> createLowMask(std::vector<double> const&);
     std::vector<int> createNetMask();
@@ -70,6 +70,8 @@ private:
     virtual void addArgs(ProgramArgs& args);
     virtual void prepared(PointTableRef table);
     virtual void filter(PointView& view);
+    virtual bool concurrentViews() const
+        { return true; }
 
     SortFilter& operator=(const SortFilter&) = delete;
     SortFilter(const SortFilter&) = delete;
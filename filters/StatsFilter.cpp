@@ -34,7 +34,9 @@
 
 #include "StatsFilter.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <unordered_map>
 
 #include <pdal/Options.hpp>
@@ -59,6 +61,162 @@ std::string StatsFilter::getName() const { return s_info.name; }
 namespace stats
 {
 
+namespace
+{
+
+// Ratio of the capacity of a sketch level to that of the level above it.
+const double CapacityRatio = 2.0 / 3.0;
+
+} // unnamed namespace
+
+QuantileSketch::QuantileSketch(double error) : m_error(error)
+{
+    // The rank error of the sketch is roughly 1.7 / k.
+    m_k = (size_t)(std::max)(8.0, std::ceil(1.7 / error));
+    reset();
+}
+
+
+void QuantileSketch::reset()
+{
+    m_levels.clear();
+    m_size = 0;
+    m_count = 0;
+    m_random = 0;
+    grow();
+}
+
+
+// Levels lower in the stack hold fewer values.  The top level holds k.
+size_t QuantileSketch::capacity(size_t level) const
+{
+    size_t depth = m_levels.size() - level - 1;
+    size_t cap = (size_t)std::ceil(m_k * std::pow(CapacityRatio, depth));
+    return (std::max)(cap, (size_t)2);
+}
+
+
+void QuantileSketch::setCapacity()
+{
+    m_maxSize = 0;
+    for (size_t level = 0; level < m_levels.size(); ++level)
+        m_maxSize += capacity(level);
+}
+
+
+void QuantileSketch::grow()
+{
+    m_levels.push_back(Level());
+    setCapacity();
+}
+
+
+// Promote every other value of full levels until the sketch is below
+// its capacity.
+void QuantileSketch::compress()
+{
+    for (size_t h = 0; h < m_levels.size(); ++h)
+    {
+        if (m_levels[h].size() < capacity(h))
+            continue;
+        if (h + 1 == m_levels.size())
+            grow();
+
+        Level& level = m_levels[h];
+        Level& above = m_levels[h + 1];
+        std::sort(level.begin(), level.end());
+
+        // Randomly promote either the even or the odd values so that the
+        // rank errors tend to cancel.  Alternating between the two instead
+        // biases the result for sorted input.  With an odd number of values,
+        // the largest stays at this level.
+        m_random = m_random * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t pairs = level.size() / 2;
+        for (size_t i = (size_t)(m_random >> 63); i < pairs * 2; i += 2)
+            above.push_back(level[i]);
+        level.erase(level.begin(), level.begin() + pairs * 2);
+        m_size -= pairs;
+
+        if (m_size < m_maxSize)
+            break;
+    }
+}
+
+
+void QuantileSketch::merge(const QuantileSketch& s)
+{
+    if (s.m_k < m_k)
+    {
+        m_k = s.m_k;
+        m_error = s.m_error;
+    }
+    while (m_levels.size() < s.m_levels.size())
+        grow();
+    setCapacity();
+
+    for (size_t h = 0; h < s.m_levels.size(); ++h)
+        m_levels[h].insert(m_levels[h].end(), s.m_levels[h].begin(),
+            s.m_levels[h].end());
+    m_size += s.m_size;
+    m_count += s.m_count;
+    while (m_size >= m_maxSize)
+        compress();
+}
+
+
+// Get the values of the sketch with the number of input values that
+// each represents, sorted by value.
+QuantileSketch::WeightedValues QuantileSketch::weightedValues() const
+{
+    WeightedValues values;
+    values.reserve(m_size);
+    for (size_t h = 0; h < m_levels.size(); ++h)
+        for (double d : m_levels[h])
+            values.push_back(std::make_pair(d, (uint64_t)1 << h));
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+
+double QuantileSketch::weightedQuantile(const WeightedValues& values,
+    double q)
+{
+    if (values.empty())
+        return 0;
+
+    uint64_t total = 0;
+    for (auto& v : values)
+        total += v.second;
+
+    // Find the first value whose cumulative weight passes the rank
+    // of the quantile.
+    const double rank = Utils::clamp(q, 0.0, 1.0) * total;
+    uint64_t cumulative = 0;
+    for (auto& v : values)
+    {
+        cumulative += v.second;
+        if (cumulative > rank)
+            return v.first;
+    }
+    return values.back().first;
+}
+
+
+double QuantileSketch::quantile(double q) const
+{
+    return weightedQuantile(weightedValues(), q);
+}
+
+
+double QuantileSketch::deviation(double center) const
+{
+    WeightedValues values = weightedValues();
+    for (auto& v : values)
+        v.first = std::fabs(v.first - center);
+    std::sort(values.begin(), values.end());
+    return weightedQuantile(values, .5);
+}
+
 
 void Summary::extractMetadata(MetadataNode &m)
 {
@@ -93,11 +251,17 @@ void Summary::extractMetadata(MetadataNode &m)
         for (auto& v : m_values)
             m.addList("values", v.first);
     }
-    else if (m_enumerate == Global)
+    else if (m_enumerate == Global || m_enumerate == Sketch)
     {
         computeGlobalStats();
         m.add("median", m_median);
         m.add("mad", m_mad);
+        for (double q : m_quantiles)
+        {
+            MetadataNode n = m.addList("quantiles");
+            n.add("quantile", q);
+            n.add("value", quantile(q));
+        }
     }
     else if (m_enumerate == Count)
     {
@@ -112,17 +276,60 @@ void Summary::extractMetadata(MetadataNode &m)
 
 void Summary::computeGlobalStats()
 {
-    auto compute_median = [](std::vector<double> vals)
+    if (m_enumerate == Sketch)
     {
-        std::nth_element(vals.begin(), vals.begin() + vals.size() / 2, vals.end());
-        return *(vals.begin() + vals.size() / 2);
-    };
-
-    // TODO add quantiles
-    m_median = compute_median(m_data);
-    std::transform(m_data.begin(), m_data.end(), m_data.begin(),
-       [this](double v) { return std::fabs(v - this->m_median); });
-    m_mad = compute_median(m_data);
+        m_median = m_sketch.quantile(.5);
+        m_mad = m_sketch.deviation(m_median);
+        return;
+    }
+    if (m_data.empty())
+        return;
+
+    // Sort the data so that quantiles can be looked up.  The deviations
+    // from the median increase moving away from it in either direction, so
+    // the median deviation is found by merging the two sides rather than
+    // making a copy of the data.
+    std::sort(m_data.begin(), m_data.end());
+    const size_t n = m_data.size();
+    const size_t mid = n / 2;
+    m_median = m_data[mid];
+
+    // The median itself has the smallest deviation, zero.  The median
+    // deviation is the one at position 'mid' once they're sorted.
+    size_t lo = mid;      // One past the next value below the median.
+    size_t hi = mid + 1;  // Next value above the median.
+    double dev = 0;
+    for (size_t i = 1; i <= mid; ++i)
+    {
+        double dlo = lo ? m_median - m_data[lo - 1] :
+            (std::numeric_limits<double>::max)();
+        double dhi = hi < n ? m_data[hi] - m_median :
+            (std::numeric_limits<double>::max)();
+        if (dlo <= dhi)
+        {
+            dev = dlo;
+            lo--;
+        }
+        else
+        {
+            dev = dhi;
+            hi++;
+        }
+    }
+    m_mad = dev;
+}
+
+
+double Summary::quantile(double q) const
+{
+    if (m_enumerate == Sketch)
+        return m_sketch.quantile(q);
+    if (m_data.empty())
+        return 0;
+
+    // m_data is sorted by computeGlobalStats().
+    size_t pos = (size_t)(Utils::clamp(q, 0.0, 1.0) * m_data.size());
+    return m_data[(std::min)(pos, m_data.size() - 1)];
 }
 
 // Math comes from https://prod.sandia.gov/techlib-noauth/access-control.cgi/2008/086212.pdf
@@ -162,6 +369,7 @@ bool Summary::merge(const Summary& s)
     m_max = (std::max)(m_max, s.m_max);
     m_cnt = s.m_cnt + m_cnt;
     m_data.insert(m_data.begin(), s.m_data.begin(), s.m_data.end());
+    m_sketch.merge(s.m_sketch);
     for (auto p : s.m_values)
         m_values[p.first] += p.second;
 
@@ -186,11 +394,19 @@ bool StatsFilter::processOne(PointRef& point)
 
 void StatsFilter::filter(PointView& view)
 {
-    PointRef point(view, 0);
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Read a block of each dimension at a time rather than point by point.
+    const point_count_t BlockSize = 4096;
+    std::vector<double> values(BlockSize);
+    for (PointId begin = 0; begin < view.size(); begin += BlockSize)
     {
-        point.setPointId(idx);
-        processOne(point);
+        point_count_t count = (std::min)(BlockSize, view.size() - begin);
+        for (auto& p : m_stats)
+        {
+            Summary& c = p.second;
+            view.getFieldsAs(p.first, begin, count, values.data());
+            for (point_count_t i = 0; i < count; ++i)
+                c.insert(values[i]);
+        }
     }
 }
 
@@ -209,6 +425,12 @@ void StatsFilter::addArgs(ProgramArgs& args)
         m_enums);
     args.add("global", "Dimensions to compute global stats (median, mad, mode)",
         m_global);
+    args.add("sketch", "Dimensions to compute approximate global stats "
+        "(median, mad, quantiles) using bounded memory", m_sketch);
+    args.add("sketch_error", "Approximate rank error of quantiles computed "
+        "for 'sketch' dimensions", m_sketchError, .01);
+    args.add("quantiles", "Quantiles ([0, 1]) to report for 'global' and "
+        "'sketch' dimensions", m_quantiles);
     args.add("count", "Dimensions whose values should be counted", m_counts);
     args.add("advanced", "Calculate skewness and kurtosis", m_advanced);
 }
@@ -216,6 +438,14 @@ void StatsFilter::addArgs(ProgramArgs& args)
 
 void StatsFilter::prepared(PointTableRef table)
 {
+    if (m_sketchError <= 0 || m_sketchError >= 1)
+        throwError("Option 'sketch_error' must be greater than 0 and less "
+            "than 1.");
+    for (double q : m_quantiles)
+        if (q < 0 || q > 1)
+            throwError("Values of option 'quantiles' must be between 0 "
+                "and 1.");
+
     PointLayoutPtr layout(table.layout());
     std::unordered_map<std::string, Summary::EnumType> dims;
 
@@ -271,10 +501,24 @@ void StatsFilter::prepared(PointTableRef table)
         else
             dims[s] = Summary::Global;
     }
+
+    // Set the sketch flag for those dimensions specified.
+    for (auto& s : m_sketch)
+    {
+        if (dims.find(s) == dims.end())
+            getWarn() << "Dimension '" << s << "' listed in --sketch option "
+                "does not exist.  Ignoring." << std::endl;
+        else
+            dims[s] = Summary::Sketch;
+    }
+
     // Create the summary objects.
     for (auto& dv : dims)
-        m_stats.insert(std::make_pair(layout->findDim(dv.first),
-            Summary(dv.first, dv.second, m_advanced)));
+    {
+        Summary summary(dv.first, dv.second, m_advanced, m_sketchError);
+        summary.setQuantiles(m_quantiles);
+        m_stats.insert(std::make_pair(layout->findDim(dv.first), summary));
+    }
 }
 
 
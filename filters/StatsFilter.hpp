@@ -42,6 +42,58 @@ namespace pdal
 namespace stats
 {
 
+// Approximates the quantiles of a stream of values in bounded memory using
+// a KLL sketch (Karnin, Lang & Liberty, "Optimal Quantile Approximation in
+// Streams", 2016).  Values are held in a stack of levels.  Each value at
+// level h stands for 2^h values of the input.  When a level is full it's
+// sorted and every other value is promoted to the level above.  Sketches
+// built from different parts of the input can be merged.
+class PDAL_DLL QuantileSketch
+{
+public:
+    // 'error' is the approximate rank error of a quantile, as a fraction of
+    // the number of values.
+    QuantileSketch(double error = .01);
+
+    void insert(double value)
+    {
+        m_levels[0].push_back(value);
+        m_count++;
+        if (++m_size >= m_maxSize)
+            compress();
+    }
+    // Sketches with different error are merged using the larger error.
+    void merge(const QuantileSketch& s);
+    void reset();
+    point_count_t count() const
+        { return m_count; }
+    double error() const
+        { return m_error; }
+    // Get the value at quantile 'q' ([0, 1]).
+    double quantile(double q) const;
+    // Get the median absolute deviation of the values from 'center'.
+    double deviation(double center) const;
+
+private:
+    using Level = std::vector<double>;
+    using WeightedValues = std::vector<std::pair<double, uint64_t>>;
+
+    double m_error;
+    size_t m_k;
+    std::vector<Level> m_levels;
+    size_t m_size;
+    size_t m_maxSize;
+    point_count_t m_count;
+    uint64_t m_random;
+
+    size_t capacity(size_t level) const;
+    void setCapacity();
+    void grow();
+    void compress();
+    WeightedValues weightedValues() const;
+    static double weightedQuantile(const WeightedValues& values, double q);
+};
+
 class PDAL_DLL Summary
 {
 public:
@@ -50,15 +102,18 @@ public:
         NoEnum,
         Enumerate,
         Count,
-        Global
+        Global,
+        Sketch
     };
 
 typedef std::map<double, point_count_t> EnumMap;
 typedef std::vector<double> DataVector;
 
 public:
-    Summary(std::string name, EnumType enumerate, bool advanced = true) :
-        m_name(name), m_enumerate(enumerate), m_advanced(advanced)
+    Summary(std::string name, EnumType enumerate, bool advanced = true,
+            double sketchError = .01) :
+        m_name(name), m_enumerate(enumerate), m_advanced(advanced),
+        m_sketch(sketchError)
     { reset(); }
 
     // Merge another summary with this one. 'name', 'enumerate' and 'advanced' must match
@@ -133,6 +188,12 @@ public:
         { return m_median; }
     double mad() const
         { return m_mad; }
+    // Get the value at quantile 'q' ([0, 1]).  Only available for global
+    // stats once computeGlobalStats() has been called.
+    double quantile(double q) const;
+    // Set the quantiles to be reported in metadata.
+    void setQuantiles(const std::vector<double>& quantiles)
+        { m_quantiles = quantiles; }
     point_count_t count() const
         { return m_cnt; }
     std::string name() const
@@ -151,6 +212,7 @@ public:
         m_median = 0.0;
         m_mad = 0.0;
         M1 = M2 = M3 = M4 = 0.0;
+        m_sketch.reset();
     }
 
     void insert(double value)
@@ -167,6 +229,8 @@ public:
                 m_data.reserve(m_data.capacity() + m_cnt);
             m_data.push_back(value);
         }
+        else if (m_enumerate == Sketch)
+            m_sketch.insert(value);
 
         // stolen from http://www.johndcook.com/blog/skewness_kurtosis/
 
@@ -205,6 +269,8 @@ private:
     double m_median;
     EnumMap m_values;
     DataVector m_data;
+    QuantileSketch m_sketch;
+    std::vector<double> m_quantiles;
     point_count_t m_cnt;
     double M1, M2, M3, M4;
 };
@@ -238,6 +304,9 @@ private:
     StringList m_enums;
     StringList m_counts;
     StringList m_global;
+    StringList m_sketch;
+    double m_sketchError;
+    std::vector<double> m_quantiles;
     bool m_advanced;
     std::map<Dimension::Id, stats::Summary> m_stats;
 };
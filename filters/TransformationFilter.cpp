@@ -37,7 +37,9 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 namespace pdal
 {
@@ -217,11 +219,36 @@ void TransformationFilter::filter(PointView& view)
         log()->get(LogLevel::Warning) << getName() <<
             ": overriding input spatial reference." << std::endl;
 
-    PointRef point(view, 0);
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Transform blocks of points so that the arithmetic runs in simple
+    // loops over columns of coordinates.
+    const point_count_t BlockSize = 4096;
+    std::vector<double> x(BlockSize);
+    std::vector<double> y(BlockSize);
+    std::vector<double> z(BlockSize);
+    double m[Transform::Size];
+    for (size_t i = 0; i < Transform::Size; ++i)
+        m[i] = (*m_matrix)[i];
+
+    for (PointId begin = 0; begin < view.size(); begin += BlockSize)
     {
-        point.setPointId(idx);
-        processOne(point);
+        point_count_t count = (std::min)(BlockSize, view.size() - begin);
+        view.getFieldsAs(Dimension::Id::X, begin, count, x.data());
+        view.getFieldsAs(Dimension::Id::Y, begin, count, y.data());
+        view.getFieldsAs(Dimension::Id::Z, begin, count, z.data());
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            double xi = x[i];
+            double yi = y[i];
+            double zi = z[i];
+            double s = xi * m[12] + yi * m[13] + zi * m[14] + m[15];
+
+            x[i] = (xi * m[0] + yi * m[1] + zi * m[2] + m[3]) / s;
+            y[i] = (xi * m[4] + yi * m[5] + zi * m[6] + m[7]) / s;
+            z[i] = (xi * m[8] + yi * m[9] + zi * m[10] + m[11]) / s;
+        }
+        view.setFields(Dimension::Id::X, begin, count, x.data());
+        view.setFields(Dimension::Id::Y, begin, count, y.data());
+        view.setFields(Dimension::Id::Z, begin, count, z.data());
     }
     view.invalidateProducts();
 }
@@ -41,7 +41,17 @@
 
 #include "DimRange.hpp"
 #include "Segmentation.hpp"
+#include "UnionFind.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 namespace pdal
@@ -88,6 +98,139 @@ std::ostream& operator<<(std::ostream& out, const PointClasses& classes)
     return out;
 }
 
+std::deque<PointIdList> extractClusters(PointView& view, uint64_t min_points,
+    uint64_t max_points, double tolerance, bool is3d, size_t threads)
+{
+    using Cell = std::array<int64_t, 3>;
+    if (!(tolerance > 0))
+        throw pdal_error("Cluster tolerance must be greater than 0.");
+    const point_count_t count = view.size();
+    const double tol2 = tolerance * tolerance;
+
+    std::vector<double> xyz(3 * count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        xyz[3 * i] = view.getFieldAs<double>(Dimension::Id::X, i);
+        xyz[3 * i + 1] = view.getFieldAs<double>(Dimension::Id::Y, i);
+        xyz[3 * i + 2] =
+            is3d ? view.getFieldAs<double>(Dimension::Id::Z, i) : 0.0;
+    }
+    auto cellOf = [&xyz, tolerance](PointId i)
+    {
+        return Cell { (int64_t)std::floor(xyz[3 * i] / tolerance),
+            (int64_t)std::floor(xyz[3 * i + 1] / tolerance),
+            (int64_t)std::floor(xyz[3 * i + 2] / tolerance) };
+    };
+
+    // Sort the points by cell and note where the points of each cell start.
+    PointIdList order(count);
+    std::vector<Cell> keys(count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        order[i] = i;
+        keys[i] = cellOf(i);
+    }
+    std::sort(order.begin(), order.end(),
+        [&keys](PointId a, PointId b)
+        { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+    std::vector<Cell> cells;
+    std::vector<size_t> starts;
+    for (size_t pos = 0; pos < count; ++pos)
+        if (pos == 0 || keys[order[pos]] != keys[order[pos - 1]])
+        {
+            cells.push_back(keys[order[pos]]);
+            starts.push_back(pos);
+        }
+    starts.push_back(count);
+    std::vector<Cell>().swap(keys);
+
+    // Join the points of each cell with those of the cell itself and its
+    // neighbors that follow it in order, so that each pair of cells is
+    // compared once.
+    UnionFind sets(count);
+    auto join = [&](size_t c)
+    {
+        const Cell& cell = cells[c];
+        const int64_t kMax = is3d ? 1 : 0;
+        for (int64_t i = 0; i <= 1; ++i)
+        for (int64_t j = -1; j <= 1; ++j)
+        for (int64_t k = -kMax; k <= kMax; ++k)
+        {
+            const Cell other { cell[0] + i, cell[1] + j, cell[2] + k };
+            if (other < cell)
+                continue;
+            auto it = std::lower_bound(cells.begin(), cells.end(), other);
+            if (it == cells.end() || *it != other)
+                continue;
+            const size_t o = it - cells.begin();
+            for (size_t a = starts[c]; a < starts[c + 1]; ++a)
+            {
+                const PointId p = order[a];
+                for (size_t b = (o == c ? a + 1 : starts[o]);
+                    b < starts[o + 1]; ++b)
+                {
+                    const PointId q = order[b];
+                    double dx = xyz[3 * p] - xyz[3 * q];
+                    double dy = xyz[3 * p + 1] - xyz[3 * q + 1];
+                    double dz = xyz[3 * p + 2] - xyz[3 * q + 2];
+                    if (dx * dx + dy * dy + dz * dz < tol2)
+                        sets.unite(p, q);
+                }
+            }
+        }
+    };
+
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        const size_t chunk = 64;
+        while (true)
+        {
+            size_t begin = next.fetch_add(chunk);
+            if (begin >= cells.size())
+                return;
+            size_t end = (std::min)(begin + chunk, cells.size());
+            for (size_t c = begin; c < end; ++c)
+                join(c);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < (std::max)(threads, (size_t)1); ++i)
+        workers.emplace_back(work);
+    work();
+    for (std::thread& t : workers)
+        t.join();
+
+    // Count the points of each set, then replace the count at each root
+    // with the position of its cluster, if it's kept.
+    const size_t skip = (std::numeric_limits<size_t>::max)();
+    std::vector<size_t> slots(count);
+    for (PointId i = 0; i < count; ++i)
+        slots[sets.find(i)]++;
+    std::deque<PointIdList> clusters;
+    for (PointId i = 0; i < count; ++i)
+    {
+        if (sets.find(i) != i)
+            continue;
+        const size_t size = slots[i];
+        if (size >= min_points && size <= max_points)
+        {
+            slots[i] = clusters.size();
+            clusters.push_back(PointIdList());
+            clusters.back().reserve(size);
+        }
+        else
+            slots[i] = skip;
+    }
+    for (PointId i = 0; i < count; ++i)
+    {
+        const size_t slot = slots[sets.find(i)];
+        if (slot != skip)
+            clusters[slot].push_back(i);
+    }
+    return clusters;
+}
+
 void ignoreDimRange(DimRange dr, PointViewPtr input, PointViewPtr keep,
                     PointViewPtr ignore)
 {
@@ -250,5 +393,128 @@ PointIdList farthestPointSampling(PointView& view, point_count_t count)
     return ids;
 }
 
+void classifyTiles(PointViewPtr view, double length, double buffer,
+    size_t threads, LogPtr log,
+    const std::function<void(PointViewPtr, LogPtr)>& classify)
+{
+    BOX2D bounds;
+    view->calculateBounds(bounds);
+    auto tileCount = [length](double min, double max)
+    {
+        return (std::max)((size_t)std::ceil((max - min) / length),
+            (size_t)1);
+    };
+    const size_t cols = tileCount(bounds.minx, bounds.maxx);
+    const size_t rows = tileCount(bounds.miny, bounds.maxy);
+    auto tileIndex = [length](double pos, double min, size_t count)
+        { return (std::min)((size_t)((pos - min) / length), count - 1); };
+
+    // Sort the points into the tiles that contain them.
+    std::vector<PointIdList> tiles(cols * rows);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        size_t c = tileIndex(view->getFieldAs<double>(Dimension::Id::X, i),
+            bounds.minx, cols);
+        size_t r = tileIndex(view->getFieldAs<double>(Dimension::Id::Y, i),
+            bounds.miny, rows);
+        tiles[r * cols + c].push_back(i);
+    }
+
+    // Number of tiles on each side of a tile that its buffer may reach.
+    const size_t reach = (size_t)std::ceil(buffer / length);
+    const std::string leader(log->leader());
+    const LogLevel level(log->getLevel());
+
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto process = [&](size_t t)
+    {
+        const size_t c = t % cols;
+        const size_t r = t / cols;
+        const BOX2D box(
+            bounds.minx + c * length - buffer,
+            bounds.miny + r * length - buffer,
+            bounds.minx + (c + 1) * length + buffer,
+            bounds.miny + (r + 1) * length + buffer);
+
+        PointTable table;
+        table.layout()->registerDims({ Dimension::Id::X, Dimension::Id::Y,
+            Dimension::Id::Z, Dimension::Id::Classification });
+        table.finalize();
+        PointViewPtr tile(new PointView(table, view->spatialReference()));
+
+        // The points inside the tile come first so that their results
+        // can be found by position.
+        auto add = [&view, &tile, &box](PointId id, bool check)
+        {
+            double x = view->getFieldAs<double>(Dimension::Id::X, id);
+            double y = view->getFieldAs<double>(Dimension::Id::Y, id);
+            if (check && !box.contains(x, y))
+                return;
+            PointId n = tile->size();
+            tile->setField(Dimension::Id::X, n, x);
+            tile->setField(Dimension::Id::Y, n, y);
+            tile->setField(Dimension::Id::Z, n,
+                view->getFieldAs<double>(Dimension::Id::Z, id));
+        };
+        const PointIdList& inside = tiles[t];
+        for (PointId id : inside)
+            add(id, false);
+        for (size_t rr = r - (std::min)(r, reach);
+            rr <= (std::min)(r + reach, rows - 1); ++rr)
+            for (size_t cc = c - (std::min)(c, reach);
+                cc <= (std::min)(c + reach, cols - 1); ++cc)
+                if (rr != r || cc != c)
+                    for (PointId id : tiles[rr * cols + cc])
+                        add(id, true);
+
+        std::ostringstream out;
+        LogPtr tileLog(Log::makeLog(leader, &out));
+        tileLog->setLevel(level);
+        tileLog->get(LogLevel::Debug) << "Tile " << c << "/" << r << ": " <<
+            inside.size() << " points, " << tile->size() <<
+            " with buffer.\n";
+        classify(tile, tileLog);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (PointId n = 0; n < inside.size(); ++n)
+            view->setField(Dimension::Id::Classification, inside[n],
+                tile->getFieldAs<uint8_t>(Dimension::Id::Classification, n));
+        *log->getLogStream() << out.str();
+    };
+    auto work = [&]()
+    {
+        while (true)
+        {
+            size_t t = next++;
+            if (t >= tiles.size())
+                return;
+            if (tiles[t].empty())
+                continue;
+            try
+            {
+                process(t);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                next = tiles.size();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < (std::max)(threads, (size_t)1); ++i)
+        workers.emplace_back(work);
+    work();
+    for (std::thread& t : workers)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
 } // namespace Segmentation
 } // namespace pdal
@@ -34,11 +34,13 @@
 
 #pragma once
 
+#include <pdal/Log.hpp>
 #include <pdal/pdal_export.hpp>
 #include <pdal/pdal_types.hpp>
 
 #include "DimRange.hpp"
 
+#include <functional>
 #include <vector>
 
 namespace pdal
@@ -154,6 +156,32 @@ PDAL_DLL std::deque<PointIdList> extractClusters(PointView& view, uint64_t min_p
     return clusters;
 }
 
+/**
+  Extract clusters of points from input PointView, in parallel.
+
+  Clusters are the same as those of the serial version: points are in the
+  same cluster when they are joined by a chain of points, each closer than
+  the tolerance to the next.  Points are sorted into a grid with a cell size
+  equal to the tolerance, so that only points in neighboring cells need to
+  be compared.  Cells are compared on many threads at once, and points
+  found to be close are merged into clusters with a concurrent union-find.
+
+  Clusters are ordered by their smallest PointId, as with the serial
+  version, but the PointIds of a cluster are in increasing order.
+
+  \param[in] view the input PointView.
+  \param[in] min_points the minimum number of points in a cluster.
+  \param[in] max_points the maximum number of points in a cluster.
+  \param[in] tolerance the tolerance for adding points to a cluster.
+  \param[in] is3d whether the Z dimension is used.
+  \param[in] threads the number of threads used.
+  \returns a deque of clusters (themselves vectors of PointIds).
+  \throws pdal_error if the tolerance isn't greater than 0.
+*/
+PDAL_DLL std::deque<PointIdList> extractClusters(PointView& view,
+    uint64_t min_points, uint64_t max_points, double tolerance, bool is3d,
+    size_t threads);
+
 PDAL_DLL void ignoreDimRange(DimRange dr, PointViewPtr input, PointViewPtr keep,
                              PointViewPtr ignore);
 PDAL_DLL void ignoreDimRanges(std::vector<DimRange>& ranges,
@@ -171,5 +199,27 @@ PDAL_DLL void segmentReturns(PointViewPtr input, PointViewPtr first,
 
 PDAL_DLL PointIdList farthestPointSampling(PointView& view, point_count_t count);
 
+/**
+  Classify the points of a view tile by tile.
+
+  The view is split into square tiles in X and Y.  Each tile is classified
+  along with the points within a buffer distance of it, so that features
+  near its edges are seen whole.  The points of a tile are copied to a table
+  of its own, which lets tiles be processed in parallel.  Only the
+  classification of the points inside a tile is copied back to the view.
+
+  \param view  View whose points are classified.
+  \param length  Length of the sides of the tiles.
+  \param buffer  Distance by which tiles are extended.
+  \param threads  Number of tiles processed at once.
+  \param log  Log to which the messages of each tile are written.
+  \param classify  Function that sets the Classification of the points of
+    a tile.  It's called with a view of X, Y, Z and Classification for the
+    tile and a log to use.
+*/
+PDAL_DLL void classifyTiles(PointViewPtr view, double length, double buffer,
+    size_t threads, LogPtr log,
+    const std::function<void(PointViewPtr, LogPtr)>& classify);
+
 } // namespace Segmentation
 } // namespace pdal
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_types.hpp>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace pdal
+{
+
+// Sets of points whose roots are the smallest PointId of the set.  Parents
+// are updated with compare-and-swap, so that sets can be found and merged
+// from many threads at once.
+class UnionFind
+{
+public:
+    UnionFind(point_count_t count) : m_parents(count)
+    {
+        for (PointId i = 0; i < count; ++i)
+            m_parents[i] = i;
+    }
+
+    PointId find(PointId i)
+    {
+        while (true)
+        {
+            PointId parent = m_parents[i].load();
+            if (parent == i)
+                return i;
+
+            // Point to the grandparent to shorten later searches.
+            PointId grandparent = m_parents[parent].load();
+            if (grandparent != parent)
+                m_parents[i].compare_exchange_weak(parent, grandparent);
+            i = grandparent;
+        }
+    }
+
+    void unite(PointId a, PointId b)
+    {
+        while (true)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            // Link the larger root to the smaller one.  This fails if the
+            // larger root was linked by another thread, in which case we
+            // start again from the new roots.
+            PointId expected = a;
+            if (m_parents[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+
+    PointId parent(PointId i) const
+    {
+        return m_parents[i].load();
+    }
+
+    void setParent(PointId i, PointId parent)
+    {
+        m_parents[i].store(parent);
+    }
+
+private:
+    std::vector<std::atomic<PointId>> m_parents;
+};
+
+} // namespace pdal
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <limits>
+
+#include "BatchProgram.hpp"
+
+namespace pdal
+{
+namespace expr
+{
+
+namespace
+{
+
+bool isBinary(NodeType type)
+{
+    switch (type)
+    {
+    case NodeType::And:
+    case NodeType::Or:
+    case NodeType::Add:
+    case NodeType::Subtract:
+    case NodeType::Multiply:
+    case NodeType::Divide:
+    case NodeType::Equal:
+    case NodeType::NotEqual:
+    case NodeType::Greater:
+    case NodeType::GreaterEqual:
+    case NodeType::Less:
+    case NodeType::LessEqual:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Keep these loops free of branches and calls so that they vectorize.
+template<typename F>
+void unary(const double *a, double *r, size_t count, F f)
+{
+    for (size_t i = 0; i < count; ++i)
+        r[i] = f(a[i]);
+}
+
+template<typename F>
+void binary(const double *a, const double *b, double v, bool immediate,
+    double *r, size_t count, F f)
+{
+    if (immediate)
+        for (size_t i = 0; i < count; ++i)
+            r[i] = f(a[i], v);
+    else
+        for (size_t i = 0; i < count; ++i)
+            r[i] = f(a[i], b[i]);
+}
+
+} // unnamed namespace
+
+BatchProgram::BatchProgram() : m_depth(0), m_maxDepth(0)
+{}
+
+void BatchProgram::clear()
+{
+    m_ops.clear();
+    m_dims.clear();
+    m_depth = 0;
+    m_maxDepth = 0;
+}
+
+bool BatchProgram::empty() const
+{
+    return m_ops.empty();
+}
+
+void BatchProgram::compile(const Node& root)
+{
+    clear();
+    root.compile(*this);
+}
+
+void BatchProgram::load(Dimension::Id id)
+{
+    auto it = std::find(m_dims.begin(), m_dims.end(), id);
+    size_t column = it - m_dims.begin();
+    if (it == m_dims.end())
+        m_dims.push_back(id);
+    m_ops.push_back({ NodeType::Identifier, column, 0, false });
+    m_maxDepth = (std::max)(m_maxDepth, ++m_depth);
+}
+
+void BatchProgram::constant(double d)
+{
+    m_ops.push_back({ NodeType::Value, 0, d, false });
+    m_maxDepth = (std::max)(m_maxDepth, ++m_depth);
+}
+
+void BatchProgram::op(NodeType type)
+{
+    if (!isBinary(type))
+    {
+        m_ops.push_back({ type, 0, 0, false });
+        return;
+    }
+
+    // A constant right operand is always the last instruction.  Fold it
+    // into the operation rather than filling a column with it.
+    Op& last = m_ops.back();
+    if (last.m_type == NodeType::Value)
+        last = { type, 0, last.m_value, true };
+    else
+        m_ops.push_back({ type, 0, 0, false });
+    m_depth--;
+}
+
+void BatchProgram::eval(PointContainer& c, PointId begin, point_count_t count,
+    double *out) const
+{
+    if (empty())
+        return;
+
+    std::vector<double> columns(m_dims.size() * BlockSize);
+    std::vector<double> stack(m_maxDepth * BlockSize);
+    std::vector<const double *> in(m_maxDepth);
+
+    PointRef point(c, begin);
+    for (point_count_t done = 0; done < count; done += BlockSize)
+    {
+        size_t n = (size_t)(std::min)((point_count_t)BlockSize, count - done);
+        for (size_t d = 0; d < m_dims.size(); ++d)
+        {
+            double *col = columns.data() + d * BlockSize;
+            for (size_t i = 0; i < n; ++i)
+            {
+                point.setPointId(begin + done + i);
+                col[i] = point.getFieldAs<double>(m_dims[d]);
+            }
+        }
+        evalBlock(columns.data(), stack.data(), in, out + done, n);
+    }
+}
+
+// Run the instructions over a block of points.  'in' holds the operand
+// columns on the stack of the machine.  Operation results are written to the
+// stack slot of the first operand.  Loads just point at the dimension column.
+void BatchProgram::evalBlock(const double *columns, double *stack,
+    std::vector<const double *>& in, double *out, size_t count) const
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    size_t depth = 0;
+    for (const Op& op : m_ops)
+    {
+        if (op.m_type == NodeType::Identifier)
+        {
+            in[depth++] = columns + op.m_column * BlockSize;
+            continue;
+        }
+        if (op.m_type == NodeType::Value)
+        {
+            double *r = stack + depth * BlockSize;
+            std::fill(r, r + count, op.m_value);
+            in[depth++] = r;
+            continue;
+        }
+
+        size_t pos = (isBinary(op.m_type) && !op.m_immediate) ?
+            depth - 2 : depth - 1;
+        const double *a = in[pos];
+        const double *b = op.m_immediate ? nullptr : in[depth - 1];
+        double *r = stack + pos * BlockSize;
+        const double v = op.m_value;
+        const bool imm = op.m_immediate;
+
+        switch (op.m_type)
+        {
+        case NodeType::Negative:
+            unary(a, r, count, [](double x){ return -x; });
+            break;
+        case NodeType::Not:
+            unary(a, r, count, [](double x){ return (double)(x == 0); });
+            break;
+        case NodeType::Add:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return x + y; });
+            break;
+        case NodeType::Subtract:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return x - y; });
+            break;
+        case NodeType::Multiply:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return x * y; });
+            break;
+        case NodeType::Divide:
+            binary(a, b, v, imm, r, count,
+                [nan](double x, double y){ return y == 0 ? nan : x / y; });
+            break;
+        case NodeType::Equal:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x == y); });
+            break;
+        case NodeType::NotEqual:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x != y); });
+            break;
+        case NodeType::Greater:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x > y); });
+            break;
+        case NodeType::GreaterEqual:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x >= y); });
+            break;
+        case NodeType::Less:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x < y); });
+            break;
+        case NodeType::LessEqual:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y){ return (double)(x <= y); });
+            break;
+        case NodeType::And:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y)
+                    { return (double)((x != 0) & (y != 0)); });
+            break;
+        case NodeType::Or:
+            binary(a, b, v, imm, r, count,
+                [](double x, double y)
+                    { return (double)((x != 0) | (y != 0)); });
+            break;
+        default:
+            break;
+        }
+        in[pos] = r;
+        depth = pos + 1;
+    }
+    std::copy(in[0], in[0] + count, out);
+}
+
+} // namespace expr
+} // namespace pdal
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <pdal/PointContainer.hpp>
+
+#include "Expression.hpp"
+
+namespace pdal
+{
+namespace expr
+{
+
+// Flat (postfix) form of an expression tree that is evaluated for a block
+// of points at a time.  Each instruction works on a column of values so
+// that the loops are simple enough to be vectorized by the compiler.
+// Boolean results are represented as 0 and 1.
+class BatchProgram
+{
+public:
+    // Number of points evaluated per block.
+    static const size_t BlockSize = 256;
+
+    BatchProgram();
+
+    void clear();
+    bool empty() const;
+
+    // Compile a prepared expression tree.
+    void compile(const Node& root);
+
+    // Emit instructions.  Called by nodes when compiling.
+    void load(Dimension::Id id);
+    void constant(double d);
+    void op(NodeType type);
+
+    // Evaluate the program for the points [begin, begin + count) of a
+    // container, storing a result for each point in 'out'.
+    void eval(PointContainer& c, PointId begin, point_count_t count,
+        double *out) const;
+
+private:
+    struct Op
+    {
+        NodeType m_type;   // Operation, Value (constant) or Identifier (load)
+        size_t m_column;   // Column to load (Identifier)
+        double m_value;    // Constant value (Value or immediate operand)
+        bool m_immediate;  // Right operand is m_value.
+    };
+
+    std::vector<Op> m_ops;
+    Dimension::IdList m_dims;
+    size_t m_depth;
+    size_t m_maxDepth;
+
+    void evalBlock(const double *columns, double *stack,
+        std::vector<const double *>& in, double *out, size_t count) const;
+};
+
+} // namespace expr
+} // namespace pdal
@@ -7,6 +7,7 @@ namespace expr
 
 Utils::StatusWithReason ConditionalExpression::prepare(PointLayoutPtr layout)
 {
+    m_program.clear();
     Node *top = topNode();
     if (top)
     {
@@ -28,6 +29,8 @@ Utils::StatusWithReason ConditionalExpression::prepare(PointLayoutPtr layout)
                 }
             }
         }
+        if (status)
+            m_program.compile(*top);
         return status;
     }
     return true;
@@ -39,6 +42,22 @@ bool ConditionalExpression::eval(PointRef& p) const
     return n ? n->eval(p).m_bval : true;
 }
 
+void ConditionalExpression::eval(PointContainer& c, PointId begin,
+    point_count_t count, std::vector<char>& pass) const
+{
+    pass.resize(count);
+    if (m_program.empty())
+    {
+        std::fill(pass.begin(), pass.end(), 1);
+        return;
+    }
+
+    std::vector<double> result(count);
+    m_program.eval(c, begin, count, result.data());
+    for (point_count_t i = 0; i < count; ++i)
+        pass[i] = (result[i] != 0);
+}
+
 } // namespace expr
 } // namespace pdal
 
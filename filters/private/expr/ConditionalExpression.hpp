@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BatchProgram.hpp"
 #include "Expression.hpp"
 #include "Lexer.hpp"
 #include "ConditionalParser.hpp"
@@ -14,6 +15,15 @@ class ConditionalExpression : public Expression
 public:
     Utils::StatusWithReason prepare(PointLayoutPtr layout);
     bool eval(PointRef& p) const;
+
+    // Evaluate the expression for the points [begin, begin + count) of a
+    // container.  pass[i] is set to 1 for point begin + i if the
+    // expression is true, otherwise 0.
+    void eval(PointContainer& c, PointId begin, point_count_t count,
+        std::vector<char>& pass) const;
+
+private:
+    BatchProgram m_program;
 };
 
 } // namespace expr
@@ -1,4 +1,5 @@
 #include "Expression.hpp"
+#include "BatchProgram.hpp"
 
 namespace pdal
 {
@@ -37,6 +38,12 @@ Result NotNode::eval(PointRef& p) const
     return !(m_sub->eval(p).m_bval);
 }
 
+void NotNode::compile(BatchProgram& prog) const
+{
+    m_sub->compile(prog);
+    prog.op(type());
+}
+
 
 //
 // UnMathNode
@@ -60,6 +67,12 @@ Result UnMathNode::eval(PointRef& p) const
     return -(m_sub->eval(p).m_dval);
 }
 
+void UnMathNode::compile(BatchProgram& prog) const
+{
+    m_sub->compile(prog);
+    prog.op(type());
+}
+
 
 //
 // BinMathNode
@@ -125,6 +138,13 @@ Result BinMathNode::eval(PointRef& p) const
     return 0.0;
 }
 
+void BinMathNode::compile(BatchProgram& prog) const
+{
+    m_left->compile(prog);
+    m_right->compile(prog);
+    prog.op(type());
+}
+
 //
 // Bool node
 //
@@ -176,6 +196,13 @@ Result BoolNode::eval(PointRef& p) const
 
 }
 
+void BoolNode::compile(BatchProgram& prog) const
+{
+    m_left->compile(prog);
+    m_right->compile(prog);
+    prog.op(type());
+}
+
 //
 // CompareNode
 //
@@ -245,6 +272,13 @@ Result CompareNode::eval(PointRef& p) const
     return false;
 }
 
+void CompareNode::compile(BatchProgram& prog) const
+{
+    m_left->compile(prog);
+    m_right->compile(prog);
+    prog.op(type());
+}
+
 //
 // ConstValueNode
 //
@@ -267,6 +301,11 @@ Result ConstValueNode::eval(PointRef&) const
     return m_val;
 }
 
+void ConstValueNode::compile(BatchProgram& prog) const
+{
+    prog.constant(m_val);
+}
+
 double ConstValueNode::value() const
 {
     return m_val;
@@ -295,6 +334,11 @@ Result ConstLogicalNode::eval(PointRef&) const
     return m_val;
 }
 
+void ConstLogicalNode::compile(BatchProgram& prog) const
+{
+    prog.constant(m_val ? 1 : 0);
+}
+
 bool ConstLogicalNode::value() const
 {
     return m_val;
@@ -317,6 +361,11 @@ Result VarNode::eval(PointRef& p) const
     return p.getFieldAs<double>(m_id);
 }
 
+void VarNode::compile(BatchProgram& prog) const
+{
+    prog.load(m_id);
+}
+
 Dimension::Id VarNode::eval() const
 {
     return m_id;
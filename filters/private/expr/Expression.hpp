@@ -14,6 +14,8 @@ namespace pdal
 namespace expr
 {
 
+class BatchProgram;
+
 enum class NodeType
 {
     And,
@@ -66,6 +68,7 @@ public:
     virtual std::string print() const = 0;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l) = 0;
     virtual Result eval(PointRef& p) const = 0;
+    virtual void compile(BatchProgram& prog) const = 0;
     virtual bool isBool() const = 0;
     virtual bool isValue() const
     { return !isBool(); }
@@ -107,6 +110,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
 
 private:
     NodePtr m_left;
@@ -121,6 +125,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
 
 private:
     NodePtr m_sub;
@@ -134,6 +139,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
 
 private:
     NodePtr m_sub;
@@ -147,6 +153,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
 
 private:
     NodePtr m_left;
@@ -161,6 +168,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
 
 private:
     NodePtr m_left;
@@ -175,6 +183,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef&) const;
+    virtual void compile(BatchProgram& prog) const;
 
     double value() const;
 
@@ -190,6 +199,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef&) const;
+    virtual void compile(BatchProgram& prog) const;
 
     bool value() const;
 
@@ -205,6 +215,7 @@ public:
     virtual std::string print() const;
     virtual Utils::StatusWithReason prepare(PointLayoutPtr l);
     virtual Result eval(PointRef& p) const;
+    virtual void compile(BatchProgram& prog) const;
     Dimension::Id eval() const;
 
 private:
@@ -7,6 +7,7 @@ namespace expr
 
 Utils::StatusWithReason MathExpression::prepare(PointLayoutPtr layout)
 {
+    m_program.clear();
     Node *top = topNode();
     if (top)
     {
@@ -16,6 +17,8 @@ Utils::StatusWithReason MathExpression::prepare(PointLayoutPtr layout)
             if (!top->isValue())
                 status = { -1, "Expression doesn't evaluate to a value." };
         }
+        if (status)
+            m_program.compile(*top);
         return status;
     }
     return true;
@@ -27,6 +30,13 @@ double MathExpression::eval(PointRef& p) const
     return n ? n->eval(p).m_dval : 0;
 }
 
+void MathExpression::eval(PointContainer& c, PointId begin,
+    point_count_t count, std::vector<double>& out) const
+{
+    out.assign(count, 0);
+    m_program.eval(c, begin, count, out.data());
+}
+
 } // namespace expr
 } // namespace pdal
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BatchProgram.hpp"
 #include "Expression.hpp"
 
 namespace pdal
@@ -12,6 +13,14 @@ class MathExpression : public Expression
 public:
     Utils::StatusWithReason prepare(PointLayoutPtr layout);
     double eval(PointRef& p) const;
+
+    // Evaluate the expression for the points [begin, begin + count) of a
+    // container, storing the value for point begin + i in out[i].
+    void eval(PointContainer& c, PointId begin, point_count_t count,
+        std::vector<double>& out) const;
+
+private:
+    BatchProgram m_program;
 };
 
 } // namespace expr
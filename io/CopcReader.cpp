@@ -51,6 +51,7 @@
 #include <pdal/private/gdal/GDALUtils.hpp>
 #include <pdal/private/SrsTransform.hpp>
 
+#include "private/ContentCache.hpp"
 #include "private/copc/Connector.hpp"
 #include "private/copc/Entry.hpp"
 #include "private/copc/Tile.hpp"
@@ -94,6 +95,9 @@ public:
     double resolution = 0;
     std::vector<Polygon> polys;
     bool fixNames;
+    std::size_t memoryLimit;
+    std::string cacheDir;
+    std::size_t cacheSize;
 
     NL::json query;
     NL::json headers;
@@ -112,7 +116,6 @@ public:
     las::LoaderDriver loader;
     std::mutex mutex;
     std::condition_variable contentsCv;
-    std::condition_variable consumedCv;
     std::vector<PolyXform> polys;
     BoxXform clip;
     int depthEnd;
@@ -123,6 +126,12 @@ public:
     int32_t tilePointNum;
     lazperf::header14 header;
     lazperf::copc_info_vlr copc_info;
+    // Entries to load in file order, the next one to load and the memory
+    // held by tiles that have been loaded or queued for loading but not
+    // yet consumed.
+    std::vector<copc::Entry> entries;
+    size_t nextEntry;
+    uint64_t pendingBytes;
 };
 
 CopcReader::CopcReader() : m_args(new CopcReader::Args), m_p(new CopcReader::Private)
@@ -150,6 +159,13 @@ void CopcReader::addArgs(ProgramArgs& args)
     args.add("header", "Header fields to forward with HTTP requests", m_args->headers);
     args.add("query", "Query parameters to forward with HTTP requests", m_args->query);
     args.add("ogr", "OGR filter geometries", m_args->ogr);
+    args.add("memory_limit", "Approximate memory (in MB) used to hold tiles "
+        "that have been fetched but not yet read", m_args->memoryLimit,
+        (size_t)1024);
+    args.add("cache_dir", "Directory of a persistent cache of remote data",
+        m_args->cacheDir);
+    args.add("cache_size", "Maximum size (in MB) of the cache of remote data",
+        m_args->cacheSize, (size_t)1024);
     args.add("fix_dims", "Make invalid dimension names valid by changing invalid "
         "characters to '_'", m_args->fixNames, true);
 }
@@ -190,7 +206,11 @@ void CopcReader::initialize()
     StringMap headers;
     StringMap query;
     setForwards(headers, query);
-    m_p->connector =  copc::Connector(m_filename, headers, query);
+    std::shared_ptr<ContentCache> cache;
+    if (m_args->cacheDir.size())
+        cache.reset(new ContentCache(m_args->cacheDir,
+            (uint64_t)m_args->cacheSize * 1024 * 1024));
+    m_p->connector =  copc::Connector(m_filename, headers, query, cache);
 
     fetchHeader();
 
@@ -434,9 +454,16 @@ void CopcReader::ready(PointTableRef table)
 
     m_p->tileCount = m_p->hierarchy.size();
 
+    // Queue up requests for data until the memory limit is reached.  Other
+    // requests are queued as the results are handled.
     m_p->pool.reset(new ThreadPool(m_p->pool->numThreads()));
-    for (const copc::Entry& entry : m_p->hierarchy)
-        load(entry);
+    m_p->entries.assign(m_p->hierarchy.begin(), m_p->hierarchy.end());
+    std::sort(m_p->entries.begin(), m_p->entries.end(),
+        [](const copc::Entry& a, const copc::Entry& b)
+        { return a.m_offset < b.m_offset; });
+    m_p->nextEntry = 0;
+    m_p->pendingBytes = 0;
+    loadMore();
 }
 
 
@@ -572,21 +599,102 @@ bool CopcReader::hasSpatialFilter() const
 }
 
 
-void CopcReader::load(const copc::Entry& entry)
+// Estimate of the memory used by the points of a tile once it's been read.
+uint64_t CopcReader::tileBytes(point_count_t count) const
+{
+    return (uint64_t)count * m_p->header.point_record_length;
+}
+
+
+// Queue loads for tiles until the tiles that haven't been consumed would
+// use more than the memory limit.  At least one tile is always pending
+// so that large tiles are still read.  Tiles of a remote file whose data is
+// near each other are loaded together so that they can be fetched with a
+// single request.  Tiles of local files are loaded one at a time so that
+// they're read in parallel.  Only called from the reading thread.
+void CopcReader::loadMore()
 {
-    m_p->pool->add([this, entry]()
+    const uint64_t limit = (uint64_t)m_args->memoryLimit * 1024 * 1024;
+    const bool remote = m_p->connector.isRemote();
+    std::vector<copc::Entry> group;
+    uint64_t groupEnd = 0;
+    while (m_p->nextEntry < m_p->entries.size())
+    {
+        const copc::Entry& entry = m_p->entries[m_p->nextEntry];
+        uint64_t bytes = tileBytes(entry.m_pointCount);
+        if (m_p->pendingBytes && m_p->pendingBytes + bytes > limit)
+            break;
+
+        const uint64_t end = entry.m_offset + (std::max)(entry.m_byteSize, 0);
+        if (group.size() && (!remote ||
+             entry.m_offset > groupEnd + copc::Connector::MaxGap ||
+             end - group.front().m_offset > copc::Connector::MaxRead))
         {
-            // Read the tile.
-            copc::Tile tile(entry, m_p->connector, m_p->header);
-            tile.read();
+            load(group);
+            group.clear();
+        }
+        group.push_back(entry);
+        groupEnd = end;
+        m_p->pendingBytes += bytes;
+        m_p->nextEntry++;
+    }
+    if (group.size())
+        load(group);
+}
 
-            // Put the tile on the output queue.
-            std::unique_lock<std::mutex> l(m_p->mutex);
-            while (m_p->contents.size() >= (std::max)((size_t)10, m_p->pool->numThreads()))
-                m_p->consumedCv.wait(l);
-            m_p->contents.push(std::move(tile));
-            l.unlock();
-            m_p->contentsCv.notify_one();
+
+// Note that a tile has been consumed.  Wait until there's room for a good
+// number of tiles to queue more loads so that nearby tiles can be grouped.
+void CopcReader::consumed(const copc::Tile& tile)
+{
+    m_p->pendingBytes -= tileBytes(tile.size());
+    if (m_p->pendingBytes <= (uint64_t)m_args->memoryLimit * 1024 * 1024 / 2)
+        loadMore();
+}
+
+
+// Start a thread to read a group of tiles.  As each tile is read, stick it
+// on the queue and notify the main thread.
+void CopcReader::load(const std::vector<copc::Entry>& entries)
+{
+    m_p->pool->add([this, entries]()
+        {
+            // Fetch the data for all the tiles.  If that fails, each tile
+            // fetches its own data so that errors are reported with the tile.
+            std::vector<std::vector<char>> bufs;
+            if (entries.size() > 1)
+            {
+                std::vector<copc::ByteRange> ranges;
+                for (const copc::Entry& entry : entries)
+                    ranges.push_back({ entry.m_offset, entry.m_byteSize });
+                try
+                {
+                    bufs = m_p->connector.getBinary(ranges);
+                }
+                catch (...)
+                {
+                    bufs.clear();
+                }
+            }
+
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                // Read the tile.
+                copc::Tile tile(entries[i], m_p->connector, m_p->header);
+                if (bufs.size())
+                {
+                    tile.read(bufs[i]);
+                    std::vector<char>().swap(bufs[i]);
+                }
+                else
+                    tile.read();
+
+                // Put the tile on the output queue.
+                std::unique_lock<std::mutex> l(m_p->mutex);
+                m_p->contents.push(std::move(tile));
+                l.unlock();
+                m_p->contentsCv.notify_one();
+            }
         }
     );
 }
@@ -661,12 +769,13 @@ point_count_t CopcReader::read(PointViewPtr view, point_count_t count)
         {
             copc::Tile tile = std::move(m_p->contents.front());
             m_p->contents.pop();
-            m_p->consumedCv.notify_one();
             l.unlock();
             checkTile(tile);
             process(view, tile, count - numRead);
             numRead += tile.size();
             m_p->tileCount--;
+            if (m_p->tileCount && numRead <= count)
+                consumed(tile);
         }
         else
             m_p->contentsCv.wait(l);
@@ -725,7 +834,6 @@ top:
             else
                 m_p->contentsCv.wait(l);
         } while (true);
-        m_p->consumedCv.notify_one();
         checkTile(*m_p->currentTile);
         m_p->tilePointNum = 0;
     }
@@ -739,6 +847,7 @@ top:
     if ((size_t)m_p->tilePointNum == m_p->currentTile->size())
     {
         m_p->tilePointNum = 0;
+        consumed(*m_p->currentTile);
         m_p->currentTile.reset();
         --m_p->tileCount;
     }
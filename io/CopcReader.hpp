@@ -104,7 +104,10 @@ private:
     bool passesSpatialFilter(const copc::Key& key) const;
     void process(PointViewPtr dstView, const copc::Tile& tile, point_count_t count);
     bool processPoint(const char *inbuf, PointRef& dst);
-    void load(const copc::Entry& entry);
+    void load(const std::vector<copc::Entry>& entries);
+    void loadMore();
+    void consumed(const copc::Tile& tile);
+    uint64_t tileBytes(point_count_t count) const;
     void checkTile(const copc::Tile& tile);
 
     struct Args;
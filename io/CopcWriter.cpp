@@ -0,0 +1,695 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+
+#include "CopcWriter.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+
+#include <lazperf/filestream.hpp>
+#include <lazperf/vlr.hpp>
+#include <lazperf/writers.hpp>
+
+#include <pdal/Scaling.hpp>
+#include <pdal/util/Algorithm.hpp>
+#include <pdal/util/Extractor.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/Inserter.hpp>
+#include <pdal/util/OStream.hpp>
+#include <pdal/util/ThreadPool.hpp>
+
+#include "LasHeader.hpp"
+#include "LasVLR.hpp"
+#include "private/copc/Entry.hpp"
+#include "private/copc/OctreeBuilder.hpp"
+#include "private/las/Utils.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+const StaticPluginInfo s_info
+{
+    "writers.copc",
+    "COPC Writer",
+    "http://pdal.io/stages/writers.copc.html",
+    { "copc" }
+};
+
+const uint16_t WKT_MASK = (1 << 4);
+const size_t COPC_INFO_SIZE = 160;
+const size_t HIERARCHY_ENTRY_SIZE = 32;
+
+// A node of the tree waiting to be (or being) compressed on the pool.
+struct Node
+{
+    copc::Key key;
+    std::vector<char> items;
+    int32_t count;
+    std::vector<unsigned char> compressed;
+    double gpsMin;
+    double gpsMax;
+    std::array<uint64_t, LasHeader::RETURN_COUNT> returns;
+    bool done;
+    std::string error;
+};
+using NodePtr = std::shared_ptr<Node>;
+
+// Convert the items of a node to LAS point records using the final scaling
+// and compress them as a single LAZ chunk.
+void compressNode(Node& node, const Scaling& scaling, int pdrf, int pointLen)
+{
+    const size_t itemSize = 3 * sizeof(double) + pointLen;
+    const int ebCount = pointLen - lazperf::baseCount(pdrf);
+
+    node.count = (int32_t)(node.items.size() / itemSize);
+    node.gpsMin = (std::numeric_limits<double>::max)();
+    node.gpsMax = (std::numeric_limits<double>::lowest)();
+    node.returns.fill(0);
+
+    lazperf::writer::chunk_compressor compressor(pdrf, ebCount);
+    for (char *p = node.items.data(); p < node.items.data() + node.items.size();
+        p += itemSize)
+    {
+        double pos[3];
+        std::memcpy(pos, p, sizeof(pos));
+        char *record = p + sizeof(pos);
+
+        LeInserter inserter(record, 3 * sizeof(int32_t));
+        inserter << (int32_t)std::lround(scaling.m_xXform.toScaled(pos[0]));
+        inserter << (int32_t)std::lround(scaling.m_yXform.toScaled(pos[1]));
+        inserter << (int32_t)std::lround(scaling.m_zXform.toScaled(pos[2]));
+
+        // The return number is in the low bits of byte 14 and GPS time
+        // starts at byte 22 of PDRF 6-8 records.
+        int returnNum = record[14] & 0x0F;
+        if (returnNum)
+            node.returns[returnNum - 1]++;
+        double gpsTime;
+        LeExtractor extractor(record + 22, sizeof(double));
+        extractor >> gpsTime;
+        node.gpsMin = (std::min)(node.gpsMin, gpsTime);
+        node.gpsMax = (std::max)(node.gpsMax, gpsTime);
+
+        compressor.compress(record);
+    }
+    node.compressed = compressor.done();
+}
+
+} // unnamed namespace
+
+CREATE_STATIC_STAGE(CopcWriter, s_info);
+
+struct CopcWriter::Args
+{
+public:
+    std::string filename;
+    Scaling scaling;
+    int pdrf;
+    StringList extraDimSpec;
+    SpatialReference aSrs;
+    size_t threads;
+    size_t memoryLimit;
+    std::string tempDir;
+};
+
+struct CopcWriter::Private
+{
+public:
+    std::unique_ptr<copc::OctreeBuilder> builder;
+    las::LoaderDriver loader;
+    las::ExtraDims extraDims;
+    int pdrf;
+    int pointLen;
+    std::vector<char> pointBuf;
+    SpatialReference srs;
+    int srsCnt;
+
+    std::ostream *out;
+    BOX3D bounds;
+    BOX3D cube;
+    std::vector<LasVLR> vlrs;
+    uint16_t vlrOffset;
+    uint64_t pointOffset;
+    uint64_t chunkTableOffset;
+    uint64_t evlrOffset;
+    uint64_t hierarchySize;
+    std::vector<lazperf::chunk> chunks;
+    std::map<copc::Key, copc::Entry> hierarchy;
+    uint64_t pointCount;
+    std::array<uint64_t, LasHeader::RETURN_COUNT> returns;
+    double gpsMin;
+    double gpsMax;
+
+    std::unique_ptr<ThreadPool> pool;
+    std::deque<NodePtr> pending;
+    std::mutex mutex;
+    std::condition_variable doneCv;
+};
+
+CopcWriter::CopcWriter() : m_args(new CopcWriter::Args),
+    m_p(new CopcWriter::Private)
+{
+    m_p->srsCnt = 0;
+    m_p->out = nullptr;
+}
+
+
+CopcWriter::~CopcWriter()
+{
+    // Make sure no task refers to our state after we're gone.
+    if (m_p->pool)
+        m_p->pool->stop();
+    if (m_p->out)
+        Utils::closeFile(m_p->out);
+}
+
+
+std::string CopcWriter::getName() const
+{
+    return s_info.name;
+}
+
+
+void CopcWriter::addArgs(ProgramArgs& args)
+{
+    Scaling& s = m_args->scaling;
+
+    args.add("filename", "Output filename", m_args->filename).setPositional();
+    args.add("a_srs", "Spatial reference to use to write output",
+        m_args->aSrs);
+    args.add("pdrf", "Point data record format (6, 7 or 8). Default is "
+        "chosen from the dimensions of the input", m_args->pdrf, 0);
+    args.add("extra_dims", "Dimensions to write above those in point format",
+        m_args->extraDimSpec);
+    s.m_xScaleArg = &args.add("scale_x", "X scale", s.m_xXform.m_scale,
+        XForm::XFormComponent(.01));
+    s.m_yScaleArg = &args.add("scale_y", "Y scale", s.m_yXform.m_scale,
+        XForm::XFormComponent(.01));
+    s.m_zScaleArg = &args.add("scale_z", "Z scale", s.m_zXform.m_scale,
+        XForm::XFormComponent(.01));
+    s.m_xOffArg = &args.add("offset_x", "X offset. Default is the center "
+        "of the data", s.m_xXform.m_offset);
+    s.m_yOffArg = &args.add("offset_y", "Y offset. Default is the center "
+        "of the data", s.m_yXform.m_offset);
+    s.m_zOffArg = &args.add("offset_z", "Z offset. Default is the center "
+        "of the data", s.m_zXform.m_offset);
+    args.add("threads", "Number of threads used to compress nodes",
+        m_args->threads, (size_t)4);
+    args.add("memory_limit", "Approximate memory (in MB) used to hold points "
+        "before spilling to temporary files", m_args->memoryLimit,
+        (size_t)1024);
+    args.add("temp_dir", "Directory for temporary files. Default is the "
+        "directory of the output file", m_args->tempDir);
+}
+
+
+void CopcWriter::initialize()
+{
+    if (m_args->pdrf != 0 && (m_args->pdrf < 6 || m_args->pdrf > 8))
+        throwError("Option 'pdrf' must be 6, 7 or 8.");
+    if (m_args->threads == 0)
+        throwError("Option 'threads' must be greater than 0.");
+    if (m_args->memoryLimit == 0)
+        throwError("Option 'memory_limit' must be greater than 0.");
+
+    Scaling& s = m_args->scaling;
+    if ((!s.m_xXform.m_scale.m_auto && s.m_xXform.m_scale.m_val == 0) ||
+        (!s.m_yXform.m_scale.m_auto && s.m_yXform.m_scale.m_val == 0) ||
+        (!s.m_zXform.m_scale.m_auto && s.m_zXform.m_scale.m_val == 0))
+        throwError("Scale values must be non-zero.");
+
+    // Offsets default to the center of the data.
+    if (!s.m_xOffArg->set())
+        s.m_xXform.m_offset.m_auto = true;
+    if (!s.m_yOffArg->set())
+        s.m_yXform.m_offset.m_auto = true;
+    if (!s.m_zOffArg->set())
+        s.m_zXform.m_offset.m_auto = true;
+
+    try
+    {
+        m_p->extraDims = las::parse(m_args->extraDimSpec, true);
+    }
+    catch (const las::error& err)
+    {
+        throwError(err.what());
+    }
+
+    if (!m_args->aSrs.empty())
+        setSpatialReference(m_args->aSrs);
+}
+
+
+void CopcWriter::prepared(PointTableRef table)
+{
+    PointLayoutPtr layout = table.layout();
+
+    int pdrf = m_args->pdrf;
+    if (pdrf == 0)
+    {
+        if (layout->hasDim(Dimension::Id::Infrared))
+            pdrf = 8;
+        else if (layout->hasDim(Dimension::Id::Red) ||
+                layout->hasDim(Dimension::Id::Green) ||
+                layout->hasDim(Dimension::Id::Blue))
+            pdrf = 7;
+        else
+            pdrf = 6;
+    }
+    m_p->pdrf = pdrf;
+
+    // If we've asked for all dimensions, add to extraDims all dimensions
+    // in the layout that aren't already destined for LAS output.
+    las::ExtraDims& extraDims = m_p->extraDims;
+    if (extraDims.size() == 1 && extraDims[0].m_name == "all")
+    {
+        extraDims.clear();
+        Dimension::IdList ids = las::pdrfDims(pdrf);
+        for (auto& dt : layout->dimTypes())
+            if (!Utils::contains(ids, dt.m_id))
+                extraDims.push_back(
+                    las::ExtraDim(layout->dimName(dt.m_id), dt.m_type, 0));
+    }
+
+    // Extra bytes follow the standard fields of the point record.
+    int byteOffset = lazperf::baseCount(pdrf);
+    for (auto& dim : extraDims)
+    {
+        dim.m_dimType.m_id = layout->findDim(dim.m_name);
+        if (dim.m_dimType.m_id == Dimension::Id::Unknown)
+            throwError("Dimension '" + dim.m_name + "' specified in "
+                "'extra_dim' option not found.");
+        dim.m_byteOffset = byteOffset;
+        byteOffset += Dimension::size(dim.m_dimType.m_type);
+    }
+    m_p->pointLen = byteOffset;
+}
+
+
+void CopcWriter::ready(PointTableRef table)
+{
+    m_p->srs = getSpatialReference().empty() ?
+        table.anySpatialReference() : getSpatialReference();
+
+    // X, Y and Z are packed unscaled here. They're replaced when the nodes
+    // are written, once the final scaling is known.
+    m_p->loader.init(m_p->pdrf, Scaling(), m_p->extraDims);
+    m_p->pointBuf.resize(m_p->pointLen);
+
+    std::string tempBase = m_args->filename;
+    if (m_args->tempDir.size())
+        tempBase = FileUtils::toAbsolutePath(
+            FileUtils::getFilename(m_args->filename), m_args->tempDir);
+    const size_t itemSize = 3 * sizeof(double) + m_p->pointLen;
+    const point_count_t memoryPoints =
+        (point_count_t)(m_args->memoryLimit * 1024 * 1024 / itemSize);
+    m_p->builder.reset(new copc::OctreeBuilder(tempBase, m_p->pointLen,
+        memoryPoints));
+}
+
+
+void CopcWriter::spatialReferenceChanged(const SpatialReference&)
+{
+    if (++m_p->srsCnt > 1 && m_args->aSrs.empty())
+        log()->get(LogLevel::Error) << getName() <<
+            ": Attempting to write '" << m_args->filename << "' with multiple "
+            "point spatial references." << std::endl;
+}
+
+
+void CopcWriter::write(const PointViewPtr view)
+{
+    PointRef point(*view, 0);
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        point.setPointId(idx);
+        addPoint(point);
+    }
+}
+
+
+bool CopcWriter::processOne(PointRef& point)
+{
+    addPoint(point);
+    return true;
+}
+
+
+void CopcWriter::addPoint(PointRef& point)
+{
+    m_p->loader.pack(point, m_p->pointBuf.data(), m_p->pointLen);
+    try
+    {
+        m_p->builder->add(point.getFieldAs<double>(Dimension::Id::X),
+            point.getFieldAs<double>(Dimension::Id::Y),
+            point.getFieldAs<double>(Dimension::Id::Z),
+            m_p->pointBuf.data());
+    }
+    catch (const pdal_error& err)
+    {
+        throwError(err.what());
+    }
+}
+
+
+void CopcWriter::done(PointTableRef)
+{
+    copc::OctreeBuilder& builder = *m_p->builder;
+
+    m_p->bounds = builder.count() ? builder.bounds() : BOX3D(0, 0, 0, 0, 0, 0);
+    const BOX3D& b = m_p->bounds;
+    double halfsize = (std::max)({ b.maxx - b.minx, b.maxy - b.miny,
+        b.maxz - b.minz }) / 2;
+    if (halfsize == 0)
+        halfsize = 1;
+    const double cx = (b.minx + b.maxx) / 2;
+    const double cy = (b.miny + b.maxy) / 2;
+    const double cz = (b.minz + b.maxz) / 2;
+    m_p->cube = BOX3D(cx - halfsize, cy - halfsize, cz - halfsize,
+        cx + halfsize, cy + halfsize, cz + halfsize);
+    setScaling(m_p->bounds);
+
+    m_p->out = Utils::createFile(m_args->filename, true);
+    if (!m_p->out)
+        throwError("Couldn't open file '" + m_args->filename +
+            "' for output.");
+
+    // Write the header and VLRs to find the offset of the point data.  They
+    // are written again once the points are written.
+    addVlrs();
+    writeHeader();
+
+    m_p->pointCount = 0;
+    m_p->returns.fill(0);
+    m_p->gpsMin = (std::numeric_limits<double>::max)();
+    m_p->gpsMax = (std::numeric_limits<double>::lowest)();
+    m_p->pool.reset(new ThreadPool(m_args->threads));
+    try
+    {
+        using namespace std::placeholders;
+        builder.build(m_p->cube, std::bind(&CopcWriter::queueNode, this, _1, _2));
+        while (m_p->pending.size())
+            writeNode();
+    }
+    catch (const pdal_error& err)
+    {
+        throwError(err.what());
+    }
+    m_p->pool->join();
+    m_p->builder.reset();
+    if (m_p->pointCount == 0)
+        m_p->gpsMin = m_p->gpsMax = 0;
+
+    // Write the chunk table.  Each node is a chunk of variable size.
+    m_p->chunkTableOffset = m_p->out->tellp();
+    OLeStream out(m_p->out);
+    out << (uint32_t)0;  // Version
+    out << (uint32_t)m_p->chunks.size();
+    lazperf::OutFileStream stream(*m_p->out);
+    lazperf::compress_chunk_table(stream.cb(), m_p->chunks, true);
+
+    writeHierarchy();
+    writeHeader();
+
+    bool ok = m_p->out->good();
+    Utils::closeFile(m_p->out);
+    m_p->out = nullptr;
+    if (!ok)
+        throwError("Error writing file '" + m_args->filename + "'.");
+}
+
+
+// Set any automatic scale/offset from the bounds of the points and make
+// sure that the points can be represented with the scaling.
+void CopcWriter::setScaling(const BOX3D& bounds)
+{
+    auto set = [this](XForm& xform, double min, double max,
+        const std::string& name)
+    {
+        if (xform.m_scale.m_auto)
+        {
+            double d = (max - min) / 2;
+            xform.m_scale.m_val =
+                d ? d / ((std::numeric_limits<int32_t>::max)() - 1) : 1.0;
+        }
+        // Keep the offset a multiple of the scale so that values that are
+        // already quantized to the scale come back unchanged.
+        if (xform.m_offset.m_auto)
+            xform.m_offset.m_val = std::round((min + max) / 2 /
+                xform.m_scale.m_val) * xform.m_scale.m_val;
+        if (xform.toScaled(min) < (std::numeric_limits<int32_t>::lowest)() ||
+            xform.toScaled(max) > (std::numeric_limits<int32_t>::max)())
+            throwError("Can't represent " + name + " values with a scale of " +
+                Utils::toString(xform.m_scale.m_val) + " and an offset of " +
+                Utils::toString(xform.m_offset.m_val) + ".");
+    };
+
+    Scaling& s = m_args->scaling;
+    set(s.m_xXform, bounds.minx, bounds.maxx, "X");
+    set(s.m_yXform, bounds.miny, bounds.maxy, "Y");
+    set(s.m_zXform, bounds.minz, bounds.maxz, "Z");
+}
+
+
+// Called by the octree builder with the items of each node.
+void CopcWriter::queueNode(const copc::Key& key, std::vector<char>& items)
+{
+    // Bound the number of nodes held in memory.
+    if (m_p->pending.size() >= 2 * m_p->pool->numThreads())
+        writeNode();
+
+    NodePtr node(new Node);
+    node->key = key;
+    node->items.swap(items);
+    node->done = false;
+    m_p->pending.push_back(node);
+
+    const Scaling scaling(m_args->scaling);
+    const int pdrf = m_p->pdrf;
+    const int pointLen = m_p->pointLen;
+    m_p->pool->add([this, node, scaling, pdrf, pointLen]()
+    {
+        try
+        {
+            compressNode(*node, scaling, pdrf, pointLen);
+        }
+        catch (const std::exception& err)
+        {
+            node->error = err.what();
+        }
+        std::vector<char>().swap(node->items);
+
+        std::lock_guard<std::mutex> lock(m_p->mutex);
+        node->done = true;
+        m_p->doneCv.notify_all();
+    });
+}
+
+
+// Wait for the oldest node to finish and write it to the file.
+void CopcWriter::writeNode()
+{
+    NodePtr node = m_p->pending.front();
+    m_p->pending.pop_front();
+
+    std::unique_lock<std::mutex> lock(m_p->mutex);
+    m_p->doneCv.wait(lock, [&node](){ return node->done; });
+    lock.unlock();
+
+    if (node->error.size())
+    {
+        m_p->pool->stop();
+        throw pdal_error("Error compressing node " + node->key.toString() +
+            ": " + node->error);
+    }
+
+    copc::Entry entry(node->key, 0, 0, node->count);
+    if (node->count)
+    {
+        entry.m_offset = m_p->out->tellp();
+        entry.m_byteSize = (int32_t)node->compressed.size();
+        m_p->out->write(
+            reinterpret_cast<const char *>(node->compressed.data()),
+            node->compressed.size());
+        m_p->chunks.push_back({ (uint64_t)node->count,
+            (uint64_t)node->compressed.size() });
+
+        m_p->pointCount += node->count;
+        for (size_t i = 0; i < m_p->returns.size(); ++i)
+            m_p->returns[i] += node->returns[i];
+        m_p->gpsMin = (std::min)(m_p->gpsMin, node->gpsMin);
+        m_p->gpsMax = (std::max)(m_p->gpsMax, node->gpsMax);
+    }
+    m_p->hierarchy[node->key] = entry;
+}
+
+
+void CopcWriter::addVlrs()
+{
+    const int pdrf = m_p->pdrf;
+    const int ebCount = m_p->pointLen - lazperf::baseCount(pdrf);
+
+    // The COPC info VLR must be first.  It's filled in by writeHeader().
+    std::vector<uint8_t> info(COPC_INFO_SIZE);
+    m_p->vlrs.push_back(LasVLR("copc", 1, "COPC info VLR", info));
+
+    std::vector<char> lazData =
+        lazperf::laz_vlr(pdrf, ebCount, lazperf::VariableChunkSize).data();
+    std::vector<uint8_t> laz(lazData.begin(), lazData.end());
+    m_p->vlrs.push_back(LasVLR(LASZIP_USER_ID, LASZIP_RECORD_ID,
+        "http://laszip.org", laz));
+
+    // LAS 1.4 requires WKTv1
+    std::string wkt = m_p->srs.getWKT1();
+    if (wkt.size())
+    {
+        std::vector<uint8_t> wktBytes(wkt.begin(), wkt.end());
+        wktBytes.resize(wktBytes.size() + 1, 0);
+        m_p->vlrs.push_back(LasVLR(TRANSFORM_USER_ID, WKT_RECORD_ID,
+            "OGC Transformation Record", wktBytes));
+    }
+
+    if (m_p->extraDims.size())
+    {
+        std::vector<uint8_t> ebBytes;
+        for (auto& dim : m_p->extraDims)
+        {
+            las::ExtraBytesIf eb(dim.m_name, dim.m_dimType.m_type,
+                Dimension::description(dim.m_dimType.m_id));
+            eb.appendTo(ebBytes);
+        }
+        m_p->vlrs.push_back(LasVLR(SPEC_USER_ID, EXTRA_BYTES_RECORD_ID,
+            "Extra Bytes Record", ebBytes));
+    }
+
+    m_p->chunkTableOffset = 0;
+    m_p->evlrOffset = 0;
+    m_p->hierarchySize = 0;
+}
+
+
+// Write the hierarchy as a single page in an EVLR.  A reader walks the
+// hierarchy from the root, so any ancestor of a node that doesn't contain
+// points is added as an empty node.
+void CopcWriter::writeHierarchy()
+{
+    std::map<copc::Key, copc::Entry>& hierarchy = m_p->hierarchy;
+
+    std::vector<copc::Key> keys;
+    for (auto& p : hierarchy)
+        keys.push_back(p.first);
+    keys.push_back(copc::Key());
+    for (copc::Key key : keys)
+    {
+        while (hierarchy.find(key) == hierarchy.end())
+        {
+            hierarchy[key] = copc::Entry(key, 0, 0, 0);
+            if (key.d == 0)
+                break;
+            key = key.parent();
+        }
+    }
+
+    std::vector<uint8_t> data(hierarchy.size() * HIERARCHY_ENTRY_SIZE);
+    LeInserter inserter(data.data(), data.size());
+    for (auto& p : hierarchy)
+    {
+        const copc::Entry& e = p.second;
+        inserter << e.m_key.d << e.m_key.x << e.m_key.y << e.m_key.z <<
+            e.m_offset << e.m_byteSize << e.m_pointCount;
+    }
+
+    m_p->evlrOffset = m_p->out->tellp();
+    m_p->hierarchySize = data.size();
+    OLeStream out(m_p->out);
+    out << ExtLasVLR("copc", 1000, "EPT hierarchy", data);
+}
+
+
+// Write the header, VLRs and the offset of the chunk table at the start of
+// the file.
+void CopcWriter::writeHeader()
+{
+    const BOX3D& cube = m_p->cube;
+    LasVLR& info = m_p->vlrs.front();
+    LeInserter inserter(info.data(), info.dataLen());
+    inserter << (cube.minx + cube.maxx) / 2 << (cube.miny + cube.maxy) / 2 <<
+        (cube.minz + cube.maxz) / 2 << (cube.maxx - cube.minx) / 2 <<
+        (cube.maxx - cube.minx) / copc::OctreeBuilder::GridSize <<
+        (m_p->evlrOffset ?
+            m_p->evlrOffset + lazperf::evlr_header::Size : 0) <<
+        m_p->hierarchySize << m_p->gpsMin << m_p->gpsMax;
+
+    LasHeader h;
+    h.setVersionMinor(4);
+    h.setGlobalEncoding(WKT_MASK);
+    h.setSoftwareId(las::generateSoftwareId());
+    h.setPointFormat((uint8_t)m_p->pdrf);
+    h.setPointLen((uint16_t)m_p->pointLen);
+    h.setCompressed(true);
+    h.setScaling(m_args->scaling);
+    h.setBounds(m_p->bounds);
+    h.setVlrCount((uint32_t)m_p->vlrs.size());
+    if (m_p->evlrOffset)
+    {
+        h.setPointCount(m_p->pointCount);
+        for (size_t i = 0; i < m_p->returns.size(); ++i)
+            h.setPointCountByReturn(i, m_p->returns[i]);
+        h.setVlrOffset(m_p->vlrOffset);
+        h.setPointOffset((uint32_t)m_p->pointOffset);
+        h.setEVlrOffset(m_p->evlrOffset);
+        h.setEVlrCount(1);
+    }
+
+    m_p->out->seekp(0);
+    OLeStream out(m_p->out);
+    out << h;
+    m_p->vlrOffset = (uint16_t)m_p->out->tellp();
+    for (const LasVLR& vlr : m_p->vlrs)
+        out << vlr;
+    m_p->pointOffset = m_p->out->tellp();
+    out << m_p->chunkTableOffset;
+}
+
+} // namespace pdal
@@ -46,6 +46,7 @@
 #include <pdal/private/gdal/GDALUtils.hpp>
 #include <pdal/private/SrsTransform.hpp>
 
+#include "private/ContentCache.hpp"
 #include "private/ept/Connector.hpp"
 #include "private/ept/Artifact.hpp"
 #include "private/ept/EptSupport.hpp"
@@ -90,6 +91,9 @@ public:
     double m_resolution = 0;
     std::vector<Polygon> m_polys;
     NL::json m_addons;
+    std::size_t m_memoryLimit = 0;
+    std::string m_cacheDir;
+    std::size_t m_cacheSize = 0;
 
     NL::json m_query;
     NL::json m_headers;
@@ -110,6 +114,10 @@ public:
     std::condition_variable contentsCv;
     std::vector<PolyXform> polys;
     BoxXform bounds;
+    // Next tile to load and the memory held by tiles that have been
+    // loaded or queued for loading but not yet consumed.
+    ept::Hierarchy::const_iterator nextOverlap;
+    uint64_t pendingBytes = 0;
 };
 
 EptReader::EptReader() : m_args(new EptReader::Args), m_p(new EptReader::Private),
@@ -135,6 +143,13 @@ void EptReader::addArgs(ProgramArgs& args)
     args.add("header", "Header fields to forward with HTTP requests", m_args->m_headers);
     args.add("query", "Query parameters to forward with HTTP requests", m_args->m_query);
     args.add("ogr", "OGR filter geometries", m_args->m_ogr);
+    args.add("memory_limit", "Approximate memory (in MB) used to hold tiles "
+        "that have been fetched but not yet read", m_args->m_memoryLimit,
+        (size_t)1024);
+    args.add("cache_dir", "Directory of a persistent cache of remote data",
+        m_args->m_cacheDir);
+    args.add("cache_size", "Maximum size (in MB) of the cache of remote data",
+        m_args->m_cacheSize, (size_t)1024);
 }
 
 
@@ -174,7 +189,11 @@ void EptReader::initialize()
     StringMap headers;
     StringMap query;
     setForwards(headers, query);
-    m_p->connector.reset(new ept::Connector(headers, query));
+    std::shared_ptr<ContentCache> cache;
+    if (m_args->m_cacheDir.size())
+        cache.reset(new ContentCache(m_args->m_cacheDir,
+            (uint64_t)m_args->m_cacheSize * 1024 * 1024));
+    m_p->connector.reset(new ept::Connector(headers, query, cache));
 
     try
     {
@@ -423,6 +442,38 @@ void EptReader::addDimensions(PointLayoutPtr layout)
 }
 
 
+// Estimate of the memory used by the points of a tile once it's been read.
+uint64_t EptReader::tileBytes(point_count_t count) const
+{
+    return (uint64_t)count * m_p->info->remoteLayout().pointSize();
+}
+
+
+// Queue loads for tiles until the tiles that haven't been consumed would
+// use more than the memory limit.  At least one tile is always pending
+// so that large tiles are still read.  Only called from the reading thread.
+void EptReader::loadMore()
+{
+    const uint64_t limit = (uint64_t)m_args->m_memoryLimit * 1024 * 1024;
+    while (m_p->nextOverlap != m_p->hierarchy->end())
+    {
+        uint64_t bytes = tileBytes(m_p->nextOverlap->m_count);
+        if (m_p->pendingBytes && m_p->pendingBytes + bytes > limit)
+            break;
+        m_p->pendingBytes += bytes;
+        load(*m_p->nextOverlap++);
+    }
+}
+
+
+// Note that a tile has been consumed and queue more loads.
+void EptReader::consumed(const ept::TileContents& tile)
+{
+    m_p->pendingBytes -= tileBytes(tile.size());
+    loadMore();
+}
+
+
 // Start a thread to read an overlap.  When the data has been read,
 // stick the tile on the queue and notify the main thread.
 void EptReader::load(const ept::Overlap& overlap)
@@ -475,13 +526,12 @@ void EptReader::ready(PointTableRef table)
     m_pointId = 0;
     m_tileCount = m_p->hierarchy->size();
 
-    // If we're running in standard mode, queue up all the requests for data.
-    // In streaming mode, queue up at most 4 to avoid having a ton of data
-    // show up at once. Others requests will be queued as the results
-    // are handled.
+    // Queue up requests for data until the memory limit is reached.  Other
+    // requests are queued as the results are handled.
     m_p->pool.reset(new ThreadPool(m_p->pool->numThreads()));
-    for (const ept::Overlap& overlap : *m_p->hierarchy)
-        load(overlap);
+    m_p->nextOverlap = m_p->hierarchy->begin();
+    m_p->pendingBytes = 0;
+    loadMore();
     if (table.supportsView())
         m_artifactMgr = &table.artifactManager();
 }
@@ -767,6 +817,8 @@ point_count_t EptReader::read(PointViewPtr view, point_count_t count)
                 process(view, tile, count - numRead);
                 numRead += tile.size();
                 m_tileCount--;
+                if (m_tileCount && numRead <= count)
+                    consumed(tile);
             }
             else
                 m_p->contentsCv.wait(l);
@@ -840,6 +892,7 @@ top:
     if (m_pointId == m_p->currentTile->size())
     {
         m_pointId = 0;
+        consumed(*m_p->currentTile);
         m_p->currentTile.reset();
         --m_tileCount;
     }
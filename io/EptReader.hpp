@@ -94,6 +94,9 @@ private:
     void process(PointViewPtr dstView, const ept::TileContents& tile, point_count_t count);
     bool processPoint(PointRef& dst, const ept::TileContents& tile);
     void load(const ept::Overlap& overlap);
+    void loadMore();
+    void consumed(const ept::TileContents& tile);
+    uint64_t tileBytes(point_count_t count) const;
     void checkTile(const ept::TileContents& tile);
 
     struct Args;
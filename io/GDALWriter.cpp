@@ -37,6 +37,7 @@
 
 #include <pdal/PointView.hpp>
 #include <pdal/private/gdal/Raster.hpp>
+#include <pdal/util/FileUtils.hpp>
 #include <pdal/util/Utils.hpp>
 
 #include "private/GDALGrid.hpp"
@@ -44,6 +45,15 @@
 namespace pdal
 {
 
+namespace
+{
+
+// Number of cells along each side of a grid tile.  This matches the default
+// block size of tiled GeoTIFF output.
+const size_t TileSize = 256;
+
+} // unnamed namespace
+
 static StaticPluginInfo const s_info
 {
     "writers.gdal",
@@ -100,6 +110,13 @@ void GDALWriter::addArgs(ProgramArgs& args)
         m_GDAL_metadata);
     args.add("pdal_metadata", "Write PDAL metadata as to GDAL PAM XML Metadata?",
         m_writePDALMetadata, decltype(m_writePDALMetadata)(false));
+    args.add("memory_limit", "Approximate memory (in MB) used to hold the "
+        "grid before spilling tiles to a temporary file. 0 for no limit",
+        m_memoryLimit, (size_t)0);
+    args.add("temp_dir", "Directory for temporary files. Default is the "
+        "directory of the output file", m_tempDir);
+    args.add("threads", "Number of threads used to add points and "
+        "finalize the grid", m_threads, 1);
 }
 
 
@@ -217,15 +234,21 @@ void GDALWriter::createGrid(BOX2D bounds)
         throwError("Grid height out of range.");
     int width = static_cast<int>(d_width);
     int height = static_cast<int>(d_height);
+    std::string scratchFilename = m_outputFilename + ".tmp";
+    if (m_tempDir.size())
+        scratchFilename = FileUtils::toAbsolutePath(
+            FileUtils::getFilename(scratchFilename), m_tempDir);
     try
     {
         m_grid.reset(new GDALGrid(bounds.minx, bounds.miny, width, height, m_edgeLength,
-            m_radius, m_outputTypes, m_windowSize, m_power));
+            m_radius, m_outputTypes, m_windowSize, m_power, TileSize,
+            m_memoryLimit * 1024 * 1024, scratchFilename));
     }
     catch (GDALGrid::error& err)
     {
         throwError(err.what());
     }
+    m_grid->setThreads(m_threads);
 }
 
 
@@ -249,12 +272,14 @@ void GDALWriter::writeView(const PointViewPtr view)
         }
     }
 
-    PointRef point(*view, 0);
-    for (PointId idx = 0; idx < view->size(); ++idx)
-    {
-        point.setPointId(idx);
-        processOne(point);
-    }
+    m_grid->addPoints(view->size(),
+        [this, &view](PointId begin, point_count_t count,
+            double *x, double *y, double *z)
+        {
+            view->getFieldsAs(Dimension::Id::X, begin, count, x);
+            view->getFieldsAs(Dimension::Id::Y, begin, count, y);
+            view->getFieldsAs(m_interpDim, begin, count, z);
+        });
 }
 
 
@@ -302,27 +327,13 @@ void GDALWriter::doneFile()
         throwError(raster.errorMsg());
     int bandNum = 1;
 
-    // Perhaps the grid should return an iterator, which would work as well.
-    double *src;
-    src = m_grid->data("min");
+    // Bands are written a block at a time from the grid tiles.
     double srcNoData = std::numeric_limits<double>::quiet_NaN();
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "min");
-    src = m_grid->data("max");
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "max");
-    src = m_grid->data("mean");
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "mean");
-    src = m_grid->data("idw");
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "idw");
-    src = m_grid->data("count");
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "count");
-    src = m_grid->data("stdev");
-    if (src && err == gdal::GDALError::None)
-        err = raster.writeBand(src, srcNoData, bandNum++, "stdev");
+    for (const char *name : { "min", "max", "mean", "idw", "count",
+        "stdev" })
+        if (m_grid->hasBand(name) && err == gdal::GDALError::None)
+            err = raster.writeBand(m_grid->band(name), srcNoData, bandNum++,
+                name);
     if (err != gdal::GDALError::None)
         throwError(raster.errorMsg());
 
@@ -110,6 +110,9 @@ private:
     SpatialReference m_overrideSrs;
     std::string m_GDAL_metadata;
     bool m_writePDALMetadata;
+    size_t m_memoryLimit;
+    std::string m_tempDir;
+    int m_threads;
 };
 
 }
@@ -38,6 +38,7 @@
 #include "LasReader.hpp"
 #include "private/las/Utils.hpp"
 
+#include <deque>
 #include <sstream>
 #include <string.h>
 
@@ -45,10 +46,12 @@
 #include <pdal/Metadata.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/QuickInfo.hpp>
+#include <pdal/util/Charbuf.hpp>
 #include <pdal/util/Extractor.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/util/IStream.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include "LasHeader.hpp"
 #include "LasVLR.hpp"
@@ -61,6 +64,10 @@ using laszip_point_struct = void *;
 struct laszip_point;
 #endif
 
+#ifdef PDAL_HAVE_LAZPERF
+#include <lazperf/readers.hpp>
+#endif
+
 namespace pdal
 {
 
@@ -75,6 +82,41 @@ struct invalid_stream : public std::runtime_error
 
 } // unnamed namespace
 
+// Stream interface that reads from a memory mapping of the entire file.
+class LasReader::LasMapStreamIf : public LasStreamIf
+{
+public:
+    LasMapStreamIf(const std::string& filename)
+    {
+        m_ctx = FileUtils::mapFile(filename);
+        m_istream = nullptr;
+        if (m_ctx.addr())
+        {
+            m_buf.initialize(static_cast<char *>(m_ctx.addr()),
+                (size_t)m_ctx.m_size);
+            m_istream = new std::istream(&m_buf);
+        }
+    }
+
+    virtual ~LasMapStreamIf()
+    {
+        delete m_istream;
+        m_istream = nullptr;
+        FileUtils::unmapFile(m_ctx);
+    }
+
+    const char *data() const
+        { return static_cast<const char *>(m_ctx.addr()); }
+    uintmax_t size() const
+        { return m_ctx.m_size; }
+    std::string error() const
+        { return m_ctx.what(); }
+
+private:
+    FileUtils::MapContext m_ctx;
+    Charbuf m_buf;
+};
+
 struct LasReader::Options
 {
     StringList extraDimSpec;
@@ -84,6 +126,8 @@ struct LasReader::Options
     bool fixNames;
     PointId start;
     bool nosrs;
+    size_t threads;
+    bool useMmap;
 };
 
 struct LasReader::Private
@@ -99,6 +143,7 @@ struct LasReader::Private
     point_count_t index;
     IgnoreVLRList ignoreVLRs;
     std::vector<las::ExtraDim> extraDims;
+    std::unique_ptr<ThreadPool> pool;
 
     Private() : decompressor(nullptr), index(0)
     {}
@@ -127,6 +172,10 @@ void LasReader::addArgs(ProgramArgs& args)
     args.add("fix_dims", "Make invalid dimension names valid by changing "
         "invalid characters to '_'", d->opts.fixNames, true);
     args.add("nosrs", "Skip reading/processing file SRS", d->opts.nosrs);
+    args.add("threads", "Number of threads used to decompress LAZ data or "
+        "to decode memory-mapped LAS data", d->opts.threads, (size_t)1);
+    args.add("use_mmap", "Read uncompressed point data through a memory "
+        "mapping of the file", d->opts.useMmap);
 }
 
 
@@ -186,8 +235,9 @@ void LasReader::handleCompressionOption()
 {
     std::string compression = Utils::toupper(d->opts.compression);
 #if defined(PDAL_HAVE_LAZPERF) && defined(PDAL_HAVE_LASZIP)
+    // Only LAZperf can decompress chunks in parallel.
     if (compression == "EITHER")
-        compression = "LASZIP";
+        compression = (d->opts.threads > 1) ? "LAZPERF" : "LASZIP";
 #endif
 #if !defined(PDAL_HAVE_LAZPERF) && defined(PDAL_HAVE_LASZIP)
     if (compression == "EITHER")
@@ -210,6 +260,11 @@ void LasReader::handleCompressionOption()
             d->opts.compression + "'.  Value values are 'lazperf' and 'laszip'.");
 #endif
 
+    if (compression == "LASZIP" && d->opts.threads > 1)
+        log()->get(LogLevel::Warning) << "Option 'threads' is only supported "
+            "when decompressing with LAZperf. Reading with a single "
+            "thread." << std::endl;
+
     // Set case-corrected value.
     d->opts.compression = compression;
 }
@@ -218,6 +273,15 @@ void LasReader::createStream()
 {
     if (m_streamIf)
         std::cerr << "Attempt to create stream twice!\n";
+    if (d->opts.useMmap)
+    {
+        LasMapStreamIf *mapIf = new LasMapStreamIf(m_filename);
+        m_streamIf.reset(mapIf);
+        if (!m_streamIf->m_istream)
+            throwError("Unable to map file '" + m_filename + "': " +
+                mapIf->error());
+        return;
+    }
     m_streamIf.reset(new LasStreamIf(m_filename));
     if (!m_streamIf->m_istream)
     {
@@ -347,6 +411,8 @@ void LasReader::ready(PointTableRef table)
                 d->decompressor->seek(d->opts.start);
             }
             d->decompressorBuf.resize(d->header.pointLen());
+            if (d->opts.threads > 1)
+                d->pool.reset(new ThreadPool(d->opts.threads));
         }
 #endif
 
@@ -360,6 +426,8 @@ void LasReader::ready(PointTableRef table)
         std::istream::pos_type start = d->header.pointOffset() +
             (d->opts.start * d->header.pointLen());
         stream->seekg(start);
+        if (d->opts.useMmap && d->opts.threads > 1)
+            d->pool.reset(new ThreadPool(d->opts.threads));
     }
 }
 
@@ -671,6 +739,10 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
     PointId i = 0;
     if (d->header.compressed())
     {
+#ifdef PDAL_HAVE_LAZPERF
+        if (d->pool)
+            return readChunks(view, count);
+#endif
 #if defined(PDAL_HAVE_LAZPERF) || defined(PDAL_HAVE_LASZIP)
         if (d->opts.compression == "LASZIP" || d->opts.compression == "LAZPERF")
         {
@@ -688,6 +760,8 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
             "LAZperf decompression library.");
 #endif
     }
+    else if (d->opts.useMmap)
+        return readMapped(view, count);
     else
     {
         point_count_t remaining = count;
@@ -724,6 +798,210 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
 }
 
 
+#ifdef PDAL_HAVE_LAZPERF
+// Decompress LAZ chunks on the thread pool and load the decompressed points
+// into the view in file order.
+point_count_t LasReader::readChunks(PointViewPtr view, point_count_t count)
+{
+    struct ChunkData
+    {
+        std::vector<char> compressed;
+        std::vector<char> points;
+        point_count_t count;
+        point_count_t skip;
+        bool done;
+        std::string error;
+    };
+    using ChunkDataPtr = std::shared_ptr<ChunkData>;
+
+    const int format = d->header.pointFormat();
+    const int ebCount = d->header.pointLen() - d->header.basePointLen();
+    const size_t pointLen = d->header.pointLen();
+    std::istream *stream(m_streamIf->m_istream);
+
+    // Absolute range of points to read.
+    const uint64_t first = d->opts.start + d->index;
+    const uint64_t last = first + count;
+
+    std::mutex mutex;
+    std::condition_variable doneCv;
+    std::deque<ChunkDataPtr> pending;
+    PointId numRead = 0;
+
+    // Wait for the oldest chunk to be decompressed and copy its points
+    // to the view.
+    auto consume = [&]()
+    {
+        ChunkDataPtr chunk = pending.front();
+        pending.pop_front();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [&chunk](){ return chunk->done; });
+        lock.unlock();
+
+        if (chunk->error.size())
+            throwError("Error reading " + m_filename + ": " + chunk->error);
+
+        char *pos = chunk->points.data() + chunk->skip * pointLen;
+        for (point_count_t j = chunk->skip; j < chunk->count; ++j)
+        {
+            if (numRead == count)
+                break;
+            PointId id = view->size();
+            PointRef point = view->point(id);
+            loadPoint(point, pos, pointLen);
+            if (m_cb)
+                m_cb(*view, id);
+            pos += pointLen;
+            numRead++;
+        }
+    };
+
+    // Tasks refer to local state, so they must be stopped before we leave.
+    try
+    {
+        for (const LazPerfChunk& c : d->decompressor->chunks())
+        {
+            if (c.start + c.count <= first)
+                continue;
+            if (c.start >= last)
+                break;
+
+            // Bound the number of decompressed chunks held in memory.
+            if (pending.size() >= 2 * d->pool->numThreads())
+                consume();
+
+            ChunkDataPtr chunk(new ChunkData);
+            chunk->count = (std::min)(c.count, last - c.start);
+            chunk->skip = (c.start < first) ? first - c.start : 0;
+            chunk->done = false;
+            chunk->compressed.resize(c.size);
+            stream->seekg(c.offset);
+            stream->read(chunk->compressed.data(), c.size);
+            if (stream->gcount() != (std::streamsize)c.size)
+                throwError("Error reading point chunk at offset " +
+                    std::to_string(c.offset) + " from " + m_filename +
+                    ". Invalid/corrupt file.");
+            pending.push_back(chunk);
+
+            d->pool->add([chunk, format, ebCount, pointLen, &mutex, &doneCv]()
+            {
+                try
+                {
+                    lazperf::reader::chunk_decompressor decomp(format, ebCount,
+                        chunk->compressed.data());
+                    chunk->points.resize(chunk->count * pointLen);
+                    char *pos = chunk->points.data();
+                    for (point_count_t j = 0; j < chunk->count; ++j)
+                    {
+                        decomp.decompress(pos);
+                        pos += pointLen;
+                    }
+                }
+                catch (const std::exception& err)
+                {
+                    chunk->error = err.what();
+                }
+                chunk->compressed.clear();
+                chunk->compressed.shrink_to_fit();
+
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk->done = true;
+                doneCv.notify_all();
+            });
+        }
+        while (pending.size())
+            consume();
+    }
+    catch (...)
+    {
+        // Stopping the pool discards its threads, so replace it for
+        // later reads.
+        d->pool->stop();
+        d->pool.reset(new ThreadPool(d->opts.threads));
+        throw;
+    }
+
+    d->index += numRead;
+    return (point_count_t)numRead;
+}
+#endif // PDAL_HAVE_LAZPERF
+
+
+// Decode points directly from the file mapping.  Slots for all the points
+// are added to the view first so that ranges of points can be decoded
+// concurrently.
+point_count_t LasReader::readMapped(PointViewPtr view, point_count_t count)
+{
+    LasMapStreamIf *mapIf = static_cast<LasMapStreamIf *>(m_streamIf.get());
+    const size_t pointLen = d->header.pointLen();
+    const uintmax_t pos = d->header.pointOffset() +
+        (d->opts.start + d->index) * pointLen;
+
+    // The file may be truncated or the header may be bunk.
+    if (pos >= mapIf->size())
+        return 0;
+    count = (std::min)(count, (point_count_t)((mapIf->size() - pos) / pointLen));
+    const char *base = mapIf->data() + pos;
+
+    const PointId first = view->size();
+    for (PointId i = 0; i < count; ++i)
+        view->getOrAddPoint(first + i);
+
+    auto decode = [this, &view, base, first, pointLen](PointId begin,
+        PointId end)
+    {
+        PointRef point(*view, first + begin);
+        const char *p = base + begin * pointLen;
+        for (PointId i = begin; i < end; ++i)
+        {
+            point.setPointId(first + i);
+            loadPoint(point, p, pointLen);
+            p += pointLen;
+        }
+    };
+
+    if (d->pool && count > 1)
+    {
+        const size_t numThreads = d->pool->numThreads();
+        const point_count_t rangeSize = (count + numThreads - 1) / numThreads;
+        std::vector<std::string> errors(numThreads);
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            PointId begin = t * rangeSize;
+            PointId end = (std::min)(begin + rangeSize, count);
+            if (begin >= end)
+                break;
+            std::string& error = errors[t];
+            d->pool->add([&decode, &error, begin, end]()
+            {
+                try
+                {
+                    decode(begin, end);
+                }
+                catch (const std::exception& err)
+                {
+                    error = err.what();
+                }
+            });
+        }
+        d->pool->await();
+        for (const std::string& error : errors)
+            if (error.size())
+                throwError(error);
+    }
+    else
+        decode(0, count);
+
+    if (m_cb)
+        for (PointId i = 0; i < count; ++i)
+            m_cb(*view, first + i);
+
+    d->index += count;
+    return count;
+}
+
+
 point_count_t LasReader::readFileBlock(std::vector<char>& buf,
     point_count_t maxpoints)
 {
@@ -759,7 +1037,7 @@ void LasReader::loadPoint(PointRef& point)
 #endif // PDAL_HAVE_LASZIP
 
 
-void LasReader::loadPoint(PointRef& point, char *buf, size_t bufsize)
+void LasReader::loadPoint(PointRef& point, const char *buf, size_t bufsize)
 {
     if (d->header.has14PointFormat())
         loadPointV14(point, buf, bufsize);
@@ -813,7 +1091,7 @@ void LasReader::loadPointV10(PointRef& point)
 }
 #endif // PDAL_HAVE_LASZIP
 
-void LasReader::loadPointV10(PointRef& point, char *buf, size_t bufsize)
+void LasReader::loadPointV10(PointRef& point, const char *buf, size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
@@ -925,7 +1203,7 @@ void LasReader::loadPointV14(PointRef& point)
 #endif  // PDAL_HAVE_LASZIP
 
 
-void LasReader::loadPointV14(PointRef& point, char *buf, size_t bufsize)
+void LasReader::loadPointV14(PointRef& point, const char *buf, size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
@@ -1029,6 +1307,7 @@ void LasReader::done(PointTableRef)
         handleLaszip(laszip_destroy(d->laszip));
     }
 #endif
+    d->pool.reset();
     m_streamIf.reset();
 }
 
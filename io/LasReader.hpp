@@ -74,6 +74,7 @@ protected:
 
         std::istream *m_istream;
     };
+    class LasMapStreamIf;
 
     friend class NitfReader;
 public:
@@ -112,12 +113,14 @@ private:
     void loadPoint(PointRef& point);
     void loadPointV10(PointRef& point);
     void loadPointV14(PointRef& point);
-    void loadPoint(PointRef& point, char *buf, size_t bufsize);
-    void loadPointV10(PointRef& point, char *buf, size_t bufsize);
-    void loadPointV14(PointRef& point, char *buf, size_t bufsize);
+    void loadPoint(PointRef& point, const char *buf, size_t bufsize);
+    void loadPointV10(PointRef& point, const char *buf, size_t bufsize);
+    void loadPointV14(PointRef& point, const char *buf, size_t bufsize);
     void loadExtraDims(LeExtractor& istream, PointRef& data);
     point_count_t readFileBlock(std::vector<char>& buf,
         point_count_t maxPoints);
+    point_count_t readChunks(PointViewPtr view, point_count_t count);
+    point_count_t readMapped(PointViewPtr view, point_count_t count);
     void handleLaszip(int result);
 
     struct Options;
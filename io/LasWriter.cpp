@@ -97,6 +97,8 @@ struct LasWriter::Options
     StringHeaderVal<0> offsetY;
     StringHeaderVal<0> offsetZ;
     std::vector<ExtLasVLR> userVLRs;
+    size_t threads;
+    uint32_t chunkSize;
 };
 
 struct LasWriter::Private
@@ -163,6 +165,10 @@ void LasWriter::addArgs(ProgramArgs& args)
     args.add("offset_y", "Y offset", d->opts.offsetY);
     args.add("offset_z", "Z offset", d->opts.offsetZ);
     args.add("vlrs", "List of VLRs to set", d->opts.userVLRs);
+    args.add("threads", "Number of threads used to compress LAZ output",
+        d->opts.threads, (size_t)1);
+    args.add("chunk_size", "Number of points in each compressed LAZ chunk",
+        d->opts.chunkSize, (uint32_t)50000);
 }
 
 void LasWriter::initialize()
@@ -171,7 +177,11 @@ void LasWriter::initialize()
     ext = Utils::tolower(ext);
     if ((ext == ".laz") && (d->opts.compression == las::Compression::None))
     {
-#if defined(PDAL_HAVE_LASZIP)
+#if defined(PDAL_HAVE_LASZIP) && defined(PDAL_HAVE_LAZPERF)
+        // Only LAZperf can compress chunks in parallel.
+        d->opts.compression = (d->opts.threads > 1) ?
+            las::Compression::LazPerf : las::Compression::LasZip;
+#elif defined(PDAL_HAVE_LASZIP)
         d->opts.compression = las::Compression::LasZip;
 #elif defined(PDAL_HAVE_LAZPERF)
         d->opts.compression = las::Compression::LazPerf;
@@ -191,6 +201,12 @@ void LasWriter::initialize()
     if (d->opts.compression == las::Compression::LazPerf)
         throwError("Can't write LAZ output. PDAL not built with LAZperf.");
 #endif
+    if (d->opts.chunkSize == 0)
+        throwError("Option 'chunk_size' must be greater than 0.");
+    if (d->opts.compression != las::Compression::LazPerf &&
+            (d->opts.threads > 1 || d->opts.chunkSize != 50000))
+        log()->get(LogLevel::Warning) << "Options 'threads' and 'chunk_size' "
+            "are only supported when compressing with LAZperf." << std::endl;
 
     try
     {
@@ -741,7 +757,9 @@ void LasWriter::readyLazPerfCompression()
 {
 #ifdef PDAL_HAVE_LAZPERF
     int ebCount = m_lasHeader.pointLen() - m_lasHeader.basePointLen();
-    m_compressor = new LazPerfVlrCompressor(*m_ostream, m_lasHeader.pointFormat(), ebCount);
+    delete m_compressor;
+    m_compressor = new LazPerfVlrCompressor(*m_ostream, m_lasHeader.pointFormat(), ebCount,
+        d->opts.chunkSize, d->opts.threads);
     std::vector<char> lazVlrData = m_compressor->vlrData();
     std::vector<uint8_t> vlrdata(lazVlrData.begin(), lazVlrData.end());
     addVlr(LASZIP_USER_ID, LASZIP_RECORD_ID, "http://laszip.org", vlrdata);
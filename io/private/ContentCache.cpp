@@ -0,0 +1,273 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#include <random>
+
+#include <pdal/util/FileUtils.hpp>
+
+#include "ContentCache.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+const std::string IndexName("index");
+const std::string ItemExt(".bin");
+
+// FNV-1a.  The hash must be the same from run to run.
+uint64_t hashKey(const std::string& key)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // unnamed namespace
+
+ContentCache::ContentCache(const std::string& dir, uint64_t maxBytes) :
+    m_dir(dir), m_maxBytes(maxBytes), m_bytes(0), m_tempCount(0)
+{
+    // Temporary files are renamed into place so that other processes using
+    // the cache never see partial items.  Make their names unique.
+    m_tempBase = std::to_string(std::random_device()());
+
+    FileUtils::createDirectories(m_dir);
+
+    // Add the items in the index, least recently used first.
+    std::istream *in = FileUtils::openFile(m_dir + "/" + IndexName, false);
+    if (in)
+    {
+        std::string name;
+        while (std::getline(*in, name))
+        {
+            const std::string path(m_dir + "/" + name);
+            if (name.size() && !m_items.count(name) &&
+                    FileUtils::fileExists(path))
+                add(name, FileUtils::fileSize(path));
+        }
+        FileUtils::closeFile(in);
+    }
+
+    // Items that aren't in the index (written by a run that didn't finish,
+    // for example) are treated as the least recently used.
+    for (const std::string& path : FileUtils::directoryList(m_dir))
+    {
+        const std::string name = FileUtils::getFilename(path);
+        if (FileUtils::extension(name) != ItemExt || m_items.count(name))
+            continue;
+        add(name, FileUtils::fileSize(path));
+        m_lru.splice(m_lru.begin(), m_lru, m_items[name].m_pos);
+    }
+    evict();
+}
+
+
+ContentCache::~ContentCache()
+{
+    writeIndex();
+}
+
+
+std::string ContentCache::filename(const std::string& key) const
+{
+    static const char hex[] = "0123456789abcdef";
+
+    uint64_t hash = hashKey(key);
+    std::string name(16, '0');
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        name[name.size() - i - 1] = hex[hash & 0xF];
+        hash >>= 4;
+    }
+    return name + ItemExt;
+}
+
+
+// Add an item as the most recently used.  Called with the mutex held (or
+// from the constructor).
+void ContentCache::add(const std::string& name, uint64_t size)
+{
+    auto it = m_items.find(name);
+    if (it != m_items.end())
+    {
+        m_bytes -= it->second.m_size;
+        m_lru.erase(it->second.m_pos);
+        m_items.erase(it);
+    }
+    Item& item = m_items[name];
+    item.m_size = size;
+    item.m_pos = m_lru.insert(m_lru.end(), name);
+    m_bytes += size;
+}
+
+
+// Remove least recently used items until the cache fits in its limit.
+// Called with the mutex held (or from the constructor).
+void ContentCache::evict()
+{
+    while (m_bytes > m_maxBytes && m_lru.size())
+    {
+        const std::string name = m_lru.front();
+        FileUtils::deleteFile(m_dir + "/" + name);
+        m_bytes -= m_items[name].m_size;
+        m_items.erase(name);
+        m_lru.pop_front();
+    }
+}
+
+
+bool ContentCache::get(const std::string& key, std::vector<char>& data)
+{
+    const std::string name = filename(key);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_items.find(name);
+        if (it == m_items.end())
+            return false;
+        m_lru.splice(m_lru.end(), m_lru, it->second.m_pos);
+    }
+
+    // The item may be evicted or replaced while it's read.  That's treated
+    // as a miss.
+    const std::string path(m_dir + "/" + name);
+    const uint64_t fileSize = FileUtils::fileSize(path);
+    std::istream *in = FileUtils::openFile(path);
+    if (!in)
+        return false;
+
+    uint32_t keySize(0);
+    in->read((char *)&keySize, sizeof(keySize));
+    bool ok = in->good() && keySize == key.size() &&
+        fileSize >= sizeof(keySize) + keySize;
+    if (ok)
+    {
+        std::string storedKey(keySize, '\0');
+        in->read(&storedKey[0], keySize);
+        ok = in->good() && storedKey == key;
+    }
+    if (ok)
+    {
+        data.resize((size_t)(fileSize - sizeof(keySize) - keySize));
+        in->read(data.data(), data.size());
+        ok = ((size_t)in->gcount() == data.size());
+    }
+    FileUtils::closeFile(in);
+    return ok;
+}
+
+
+void ContentCache::put(const std::string& key, const std::vector<char>& data)
+{
+    const std::string name = filename(key);
+    const uint32_t keySize = (uint32_t)key.size();
+    const uint64_t size = sizeof(keySize) + keySize + data.size();
+
+    // Don't push everything else out for one large item.
+    if (size > m_maxBytes)
+        return;
+
+    std::string temp;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        temp = m_dir + "/" + name + "." + m_tempBase + "-" +
+            std::to_string(m_tempCount++) + ".tmp";
+    }
+
+    std::ostream *out = FileUtils::createFile(temp);
+    if (!out)
+        return;
+    out->write((const char *)&keySize, sizeof(keySize));
+    out->write(key.data(), keySize);
+    out->write(data.data(), data.size());
+    bool ok = out->good();
+    FileUtils::closeFile(out);
+    if (!ok)
+    {
+        FileUtils::deleteFile(temp);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try
+    {
+        FileUtils::renameFile(m_dir + "/" + name, temp);
+    }
+    catch (...)
+    {
+        FileUtils::deleteFile(temp);
+        return;
+    }
+    add(name, size);
+    evict();
+}
+
+
+uint64_t ContentCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+
+void ContentCache::writeIndex()
+{
+    const std::string temp(m_dir + "/" + IndexName + "." + m_tempBase +
+        ".tmp");
+    std::ostream *out = FileUtils::createFile(temp, false);
+    if (!out)
+        return;
+    for (const std::string& name : m_lru)
+        *out << name << "\n";
+    bool ok = out->good();
+    FileUtils::closeFile(out);
+    try
+    {
+        if (ok)
+            FileUtils::renameFile(m_dir + "/" + IndexName, temp);
+        else
+            FileUtils::deleteFile(temp);
+    }
+    catch (...)
+    {
+        FileUtils::deleteFile(temp);
+    }
+}
+
+} // namespace pdal
@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// A size-bounded cache of fetched content kept in a directory so that it
+// persists between runs.
+//
+// Each item is stored in its own file, named for a hash of its key.  The key
+// is also stored in the file so that hash collisions are detected.  When the
+// size of the items exceeds the limit, the least recently used items are
+// removed.  The order of use is saved in an index file in the directory when
+// the cache is destroyed.  Items are assumed not to change at their source.
+//
+// The cache may be used from several threads.
+class ContentCache
+{
+public:
+    PDAL_DLL ContentCache(const std::string& dir, uint64_t maxBytes);
+    PDAL_DLL ~ContentCache();
+
+    // Fetch the data for a key.  Returns false if the key isn't cached.
+    PDAL_DLL bool get(const std::string& key, std::vector<char>& data);
+    // Store the data for a key.  Errors writing the cache are ignored.
+    PDAL_DLL void put(const std::string& key,
+        const std::vector<char>& data);
+    // Bytes of data in the cache.
+    PDAL_DLL uint64_t size() const;
+
+private:
+    struct Item
+    {
+        uint64_t m_size;
+        std::list<std::string>::iterator m_pos;
+    };
+
+    std::string m_dir;
+    uint64_t m_maxBytes;
+    uint64_t m_bytes;
+    std::string m_tempBase;
+    uint64_t m_tempCount;
+    // Item filenames, least recently used first.
+    std::list<std::string> m_lru;
+    std::unordered_map<std::string, Item> m_items;
+    mutable std::mutex m_mutex;
+
+    std::string filename(const std::string& key) const;
+    void add(const std::string& name, uint64_t size);
+    void evict();
+    void writeIndex();
+};
+
+} // namespace pdal
@@ -35,26 +35,51 @@
 #include "GDALGrid.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <exception>
 #include <limits>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <pdal/pdal_types.hpp>
+#include <pdal/util/FileUtils.hpp>
 
 namespace pdal
 {
 
-//ABELL - In the beginning this data needed to be contiguous, as it was passed
-//  directly to GDAL to write.  Since we started supporting various data types
-//  in GDAL output, we end up copying/casting data to a block for output,
-//  so there's no reason that we must have contiguous data -- we just need
-//  an iterator that allows traversal of the data in row-major order.  So,
-//  this should probably be re-implemented in some way that doesn't require
-//  moving data around every time the grid is resized.
+namespace
+{
+
+// Fewest tiles held in memory when there's a memory limit.  Code that
+// works with two cells at once relies on the two tiles being in memory.
+const size_t MinTiles = 4;
+
+// Number of points binned by tile before they're added to the grid.
+const size_t BinPoints = 1 << 20;
+
+// Number of points fetched at a time when adding points.
+const point_count_t BlockSize = 4096;
+
+// Each partial grid costs memory and a merge, so don't start a thread to
+// add fewer points than this.
+const point_count_t MinThreadPoints = 100000;
+
+int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a - 1) / b) - 1;
+}
+
+} // unnamed namespace
 
 GDALGrid::GDALGrid(double xOrigin, double yOrigin, size_t width, size_t height, double edgeLength,
-        double radius, int outputTypes, size_t windowSize, double power) :
+        double radius, int outputTypes, size_t windowSize, double power,
+        size_t tileSize, size_t memoryLimit, const std::string& scratchFilename) :
     m_windowSize(windowSize), m_edgeLength(edgeLength), m_radius(radius), m_power(power),
-    m_outputTypes(outputTypes)
+    m_outputTypes(outputTypes), m_min(0), m_max(0), m_mean(0), m_stdDev(0),
+    m_idw(0), m_idwDist(0), m_iShift(0), m_jShift(0), m_maxTiles(0),
+    m_lastKey(0), m_lastTile(nullptr), m_scratchFilename(scratchFilename),
+    m_slots(0), m_threads(1), m_indexI(0), m_indexJ(0), m_indexWidth(0)
 {
     if (width > (size_t)(std::numeric_limits<int>::max)() ||
         height > (size_t)(std::numeric_limits<int>::max)())
@@ -65,80 +90,321 @@ GDALGrid::GDALGrid(double xOrigin, double yOrigin, size_t width, size_t height,
             "Try setting bounds or increasing resolution.";
         throw error(oss.str());
     }
-    RasterLimits limits(xOrigin, yOrigin, width, height, edgeLength);
-
-    m_count.reset(new Rasterd(limits));
+    if (tileSize == 0 || tileSize > 65536)
+        throw error("Grid tile size must be between 1 and 65536 cells.");
+    m_limits = RasterLimits(xOrigin, yOrigin, width, height, edgeLength);
+
+    // The values of each statistic are stored together in a tile, after
+    // the counts.
+    m_tileSize = (int)tileSize;
+    m_tileCells = tileSize * tileSize;
+    size_t offset = m_tileCells;
+    auto keep = [this, &offset](size_t& stat)
+    {
+        stat = offset;
+        offset += m_tileCells;
+    };
     if (m_outputTypes & statMin)
-        m_min.reset(new Rasterd(limits, (std::numeric_limits<double>::max)()));
+        keep(m_min);
     if (m_outputTypes & statMax)
-        m_max.reset(new Rasterd(limits, std::numeric_limits<double>::lowest()));
+        keep(m_max);
     if (m_outputTypes & statIdw)
     {
-        m_idw.reset(new Rasterd(limits));
-        m_idwDist.reset(new Rasterd(limits));
+        keep(m_idw);
+        keep(m_idwDist);
     }
     if ((m_outputTypes & statMean) || (m_outputTypes & statStdDev))
-        m_mean.reset(new Rasterd(limits));
+        keep(m_mean);
     if (m_outputTypes & statStdDev)
-        m_stdDev.reset(new Rasterd(limits));
+        keep(m_stdDev);
+    m_tileValues = offset;
+
+    if (memoryLimit)
+        m_maxTiles = (std::max)(memoryLimit / (m_tileValues * sizeof(double)),
+            MinTiles);
+}
+
+GDALGrid::~GDALGrid()
+{
+    if (m_scratch.is_open())
+    {
+        m_scratch.close();
+        FileUtils::deleteFile(m_scratchFilename);
+    }
 }
 
 int GDALGrid::width() const
 {
-    return m_count->width();
+    return m_limits.width;
 }
 
 int GDALGrid::height() const
 {
-    return m_count->height();
+    return m_limits.height;
 }
 
 double GDALGrid::xOrigin() const
 {
-    return m_count->xOrigin();
+    return m_limits.xOrigin;
 }
 
 double GDALGrid::yOrigin() const
 {
-    return m_count->yOrigin();
+    return m_limits.yOrigin;
 }
 
 double GDALGrid::distance(int i, int j, double x, double y) const
 {
-    double x1 = m_count->xCellPos(i);
-    double y1 = m_count->yCellPos(j);
+    double x1 = m_limits.xOrigin + (i + .5) * m_edgeLength;
+    double y1 = m_limits.yOrigin + (j + .5) * m_edgeLength;
     return std::sqrt(std::pow(x1 - x, 2) + std::pow(y1 - y, 2));
 }
 
+uint64_t GDALGrid::tileKey(int i, int j) const
+{
+    uint32_t ti = (uint32_t)floorDiv(i + m_iShift, m_tileSize);
+    uint32_t tj = (uint32_t)floorDiv(j + m_jShift, m_tileSize);
+    return ((uint64_t)ti << 32) | tj;
+}
+
+double *GDALGrid::cell(int i, int j, bool modify)
+{
+    int gi = i + m_iShift;
+    int gj = j + m_jShift;
+    int ti = floorDiv(gi, m_tileSize);
+    int tj = floorDiv(gj, m_tileSize);
+
+    Tile *t;
+    if (m_index.size())
+        t = m_index[(size_t)(tj - m_indexJ) * m_indexWidth + (ti - m_indexI)];
+    else
+        t = &tile(((uint64_t)(uint32_t)ti << 32) | (uint32_t)tj);
+    if (modify && m_maxTiles)
+        t->m_dirty = true;
+    size_t pos = (size_t)(gj - tj * m_tileSize) * m_tileSize +
+        (gi - ti * m_tileSize);
+    return t->m_data.data() + pos;
+}
+
+GDALGrid::Tile& GDALGrid::tile(uint64_t key)
+{
+    if (m_lastTile && key == m_lastKey)
+        return *m_lastTile;
+
+    Tile& t = m_tiles[key];
+    if (t.m_data.empty())
+    {
+        if (t.m_slot < 0)
+            initTile(t);
+        else
+        {
+            const std::streamsize bytes = m_tileValues * sizeof(double);
+            t.m_data.resize(m_tileValues);
+            m_scratch.seekg((std::streamoff)t.m_slot * bytes);
+            m_scratch.read((char *)t.m_data.data(), bytes);
+            if (!m_scratch)
+                throw error("Unable to read grid tile from scratch file '" +
+                    m_scratchFilename + "'.");
+            t.m_dirty = false;
+        }
+        if (m_maxTiles)
+        {
+            m_lru.push_front(key);
+            t.m_lruPos = m_lru.begin();
+        }
+    }
+    else if (m_maxTiles)
+        m_lru.splice(m_lru.begin(), m_lru, t.m_lruPos);
+
+    m_lastKey = key;
+    m_lastTile = &t;
+    if (m_maxTiles && m_lru.size() > m_maxTiles)
+        evict();
+    return t;
+}
+
+void GDALGrid::initTile(Tile& t)
+{
+    t.m_data.assign(m_tileValues, 0);
+    if (m_min)
+        std::fill(t.m_data.begin() + m_min,
+            t.m_data.begin() + m_min + m_tileCells,
+            (std::numeric_limits<double>::max)());
+    if (m_max)
+        std::fill(t.m_data.begin() + m_max,
+            t.m_data.begin() + m_max + m_tileCells,
+            std::numeric_limits<double>::lowest());
+    t.m_dirty = true;
+}
+
+// Write the least recently used tile to the scratch file, if it's changed,
+// and release its memory.
+void GDALGrid::evict()
+{
+    Tile& t = m_tiles[m_lru.back()];
+    m_lru.pop_back();
+
+    if (t.m_dirty)
+    {
+        if (!m_scratch.is_open())
+        {
+            m_scratch.open(m_scratchFilename, std::ios::in | std::ios::out |
+                std::ios::binary | std::ios::trunc);
+            if (!m_scratch)
+                throw error("Unable to open scratch file '" +
+                    m_scratchFilename + "'.");
+        }
+        if (t.m_slot < 0)
+            t.m_slot = m_slots++;
+
+        const std::streamsize bytes = m_tileValues * sizeof(double);
+        m_scratch.seekp((std::streamoff)t.m_slot * bytes);
+        m_scratch.write((const char *)t.m_data.data(), bytes);
+        if (!m_scratch)
+            throw error("Unable to write grid tile to scratch file '" +
+                m_scratchFilename + "'.");
+    }
+    std::vector<double>().swap(t.m_data);
+}
+
+bool GDALGrid::parallel() const
+{
+    return m_threads > 1 && !m_maxTiles;
+}
+
+// Create all the tiles that cover the grid and index them so that cells
+// can be found without changing the grid.
+void GDALGrid::freeze()
+{
+    m_index.clear();
+    m_indexI = floorDiv(m_iShift, m_tileSize);
+    m_indexJ = floorDiv(m_jShift, m_tileSize);
+    m_indexWidth =
+        floorDiv(m_iShift + width() - 1, m_tileSize) - m_indexI + 1;
+    int indexHeight =
+        floorDiv(m_jShift + height() - 1, m_tileSize) - m_indexJ + 1;
+
+    std::vector<Tile *> index;
+    for (int tj = m_indexJ; tj < m_indexJ + indexHeight; ++tj)
+        for (int ti = m_indexI; ti < m_indexI + m_indexWidth; ++ti)
+            index.push_back(&tile(((uint64_t)(uint32_t)ti << 32) |
+                (uint32_t)tj));
+    m_index.swap(index);
+}
+
+// Call f(k) for k in [0, count) from up to m_threads threads.
+void GDALGrid::runThreads(size_t count, const std::function<void(size_t)>& f)
+{
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::exception_ptr err;
+    auto work = [&]()
+    {
+        try
+        {
+            for (size_t k = next++; k < count; k = next++)
+                f(k);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!err)
+                err = std::current_exception();
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t numThreads = (std::min)((size_t)m_threads, count);
+    for (size_t t = 1; t < numThreads; ++t)
+        threads.emplace_back(work);
+    work();
+    for (std::thread& t : threads)
+        t.join();
+    if (err)
+        std::rethrow_exception(err);
+}
+
+template<typename F>
+void GDALGrid::forEachCell(F f)
+{
+    const int w = width();
+    const int h = height();
+
+    // Find the rows of the grid covered by each row of tiles.
+    std::vector<std::pair<int, int>> rows;
+    for (int j0 = 0; j0 < h;)
+    {
+        int j1 = (std::min)(h,
+            (floorDiv(j0 + m_jShift, m_tileSize) + 1) * m_tileSize - m_jShift);
+        rows.push_back({ j0, j1 });
+        j0 = j1;
+    }
+
+    auto doRow = [this, &rows, &f, w](size_t r)
+    {
+        const int j0 = rows[r].first;
+        const int j1 = rows[r].second;
+        for (int i0 = 0; i0 < w;)
+        {
+            int i1 = (std::min)(w,
+                (floorDiv(i0 + m_iShift, m_tileSize) + 1) * m_tileSize -
+                m_iShift);
+            for (int j = j0; j < j1; ++j)
+                for (int i = i0; i < i1; ++i)
+                    f(i, j);
+            i0 = i1;
+        }
+    };
+
+    if (parallel())
+    {
+        freeze();
+        runThreads(rows.size(), doRow);
+    }
+    else
+        for (size_t r = 0; r < rows.size(); ++r)
+            doRow(r);
+}
+
 void GDALGrid::windowFill()
 {
-    for (int i = 0; i < width(); ++i)
-        for (int j = 0; j < height(); ++j)
-            if (empty(i, j))
-                windowFill(i, j);
+    forEachCell([this](int i, int j)
+    {
+        if (empty(i, j))
+            windowFill(i, j);
+    });
 }
 
 /**
-  Expand the grid to a new size.
-
-  /param width
+  Expand the grid to include a point.  Only the limits change.  Tiles are
+  created when they're needed.
 */
 void GDALGrid::expandToInclude(double x, double y)
 {
-    m_count->expandToInclude(x, y);
-    if (m_outputTypes & statMin)
-        m_min->expandToInclude(x, y);
-    if (m_outputTypes & statMax)
-        m_max->expandToInclude(x, y);
-    if (m_outputTypes & statIdw)
-    {
-        m_idw->expandToInclude(x, y);
-        m_idwDist->expandToInclude(x, y);
-    }
-    if ((m_outputTypes & statMean) || (m_outputTypes & statStdDev))
-        m_mean->expandToInclude(x, y);
-    if (m_outputTypes & statStdDev)
-        m_stdDev->expandToInclude(x, y);
+    int xi = xCell(x);
+    int yi = yCell(y);
+
+    if (xi >= 0 && yi >= 0 && xi < width() && yi < height())
+        return;
+
+    // Points that are waiting to be added must be added to the grid as it
+    // was when they arrived.
+    if (m_bin.size())
+        addBinned();
+
+    int w = (std::max)(width(), xi + 1);
+    int h = (std::max)(height(), yi + 1);
+    int xshift = (std::max)(-xi, 0);
+    int yshift = (std::max)(-yi, 0);
+
+    m_index.clear();
+    m_limits.xOrigin -= xshift * m_edgeLength;
+    m_limits.yOrigin -= yshift * m_edgeLength;
+    m_limits.width = w + xshift;
+    m_limits.height = h + yshift;
+    m_iShift -= xshift;
+    m_jShift -= yshift;
 }
 
 
@@ -162,25 +428,204 @@ int GDALGrid::numBands() const
 }
 
 
-double *GDALGrid::data(const std::string& name)
+bool GDALGrid::hasBand(const std::string& name) const
+{
+    return (name == "count" && (m_outputTypes & statCount)) ||
+        (name == "min" && (m_outputTypes & statMin)) ||
+        (name == "max" && (m_outputTypes & statMax)) ||
+        (name == "mean" && (m_outputTypes & statMean)) ||
+        (name == "idw" && (m_outputTypes & statIdw)) ||
+        (name == "stdev" && (m_outputTypes & statStdDev));
+}
+
+
+GDALGrid::BandIterator GDALGrid::band(const std::string& name)
+{
+    size_t offset = 0;
+    if (name == "min")
+        offset = m_min;
+    else if (name == "max")
+        offset = m_max;
+    else if (name == "mean")
+        offset = m_mean;
+    else if (name == "idw")
+        offset = m_idw;
+    else if (name == "stdev")
+        offset = m_stdDev;
+
+    // Bands are read a row of cells at a time, so keep at least a row of
+    // tiles in memory.  Otherwise each row of cells would read every tile
+    // in the row back from the scratch file.
+    if (m_maxTiles)
+    {
+        size_t rowTiles = (size_t)(floorDiv(m_iShift + width() - 1,
+            m_tileSize) - floorDiv(m_iShift, m_tileSize) + 1);
+        m_maxTiles = (std::max)(m_maxTiles, rowTiles);
+    }
+    return BandIterator(*this, offset, 0);
+}
+
+
+double GDALGrid::bandValue(size_t offset, size_t pos)
 {
-    if (name == "count" && (m_outputTypes & statCount))
-        return m_count->data();
-    if (name == "min" && (m_outputTypes & statMin))
-        return m_min->data();
-    if (name == "max" && (m_outputTypes & statMax))
-        return m_max->data();
-    if (name == "mean" && (m_outputTypes & statMean))
-        return m_mean->data();
-    if (name == "idw" && (m_outputTypes & statIdw))
-         return m_idw->data();
-    if (name == "stdev" && (m_outputTypes & statStdDev))
-        return m_stdDev->data();
-    return nullptr;
+    int i = (int)(pos % (size_t)width());
+    int j = height() - 1 - (int)(pos / (size_t)width());
+    return cell(i, j, false)[offset];
 }
 
 
 void GDALGrid::addPoint(double x, double y, double z)
+{
+    if (!m_maxTiles)
+    {
+        applyPoint(x, y, z);
+        return;
+    }
+
+    // Bin points by tile so that each tile is loaded once per batch
+    // rather than as points arrive.
+    m_bin.push_back({ x, y, z, tileKey(xCell(x), yCell(y)) });
+    if (m_bin.size() >= BinPoints)
+        addBinned();
+}
+
+
+void GDALGrid::setThreads(int threads)
+{
+    m_threads = (std::max)(threads, 1);
+}
+
+
+void GDALGrid::addPoints(point_count_t count, const PointFunc& get)
+{
+    auto add = [&get](GDALGrid& grid, PointId begin, PointId end)
+    {
+        std::vector<double> x(BlockSize);
+        std::vector<double> y(BlockSize);
+        std::vector<double> z(BlockSize);
+        for (PointId idx = begin; idx < end; idx += BlockSize)
+        {
+            point_count_t n = (std::min)(BlockSize, end - idx);
+            get(idx, n, x.data(), y.data(), z.data());
+            for (point_count_t i = 0; i < n; ++i)
+                grid.addPoint(x[i], y[i], z[i]);
+        }
+    };
+
+    size_t threads = 1;
+    if (parallel())
+        threads = (size_t)(std::min)((point_count_t)m_threads,
+            (std::max)(count / MinThreadPoints, (point_count_t)1));
+    if (threads == 1)
+    {
+        add(*this, 0, count);
+        return;
+    }
+
+    // Partial grids have the same limits and tile positions as this grid.
+    std::vector<std::unique_ptr<GDALGrid>> partials(threads);
+    runThreads(threads, [&](size_t t)
+    {
+        GDALGrid *grid = new GDALGrid(xOrigin(), yOrigin(), width(),
+            height(), m_edgeLength, m_radius, m_outputTypes, m_windowSize,
+            m_power, m_tileSize);
+        partials[t].reset(grid);
+        grid->m_iShift = m_iShift;
+        grid->m_jShift = m_jShift;
+        add(*grid, t * count / threads, (t + 1) * count / threads);
+    });
+    merge(partials);
+}
+
+
+// Merge partial grids into this grid.  The partial grids hold points that
+// follow those already added, in order, so an exact IDW hit from an earlier
+// grid takes precedence as it would if the points were added in order.
+void GDALGrid::merge(std::vector<std::unique_ptr<GDALGrid>>& partials)
+{
+    std::vector<uint64_t> keys;
+    for (auto& p : partials)
+        for (auto& t : p->m_tiles)
+            keys.push_back(t.first);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // Finding a tile may create it, so do that before starting threads.
+    std::vector<Tile *> dst;
+    for (uint64_t key : keys)
+        dst.push_back(&tile(key));
+
+    runThreads(keys.size(), [&](size_t k)
+    {
+        double *d = dst[k]->m_data.data();
+        for (auto& p : partials)
+        {
+            auto it = p->m_tiles.find(keys[k]);
+            if (it == p->m_tiles.end())
+                continue;
+            const double *s = it->second.m_data.data();
+            for (size_t c = 0; c < m_tileCells; ++c)
+                mergeCell(d + c, s + c);
+        }
+    });
+}
+
+
+// Combine the values of a cell from a partial grid with those of a cell
+// of this grid.  See "parallel algorithm" in
+// https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
+void GDALGrid::mergeCell(double *dst, const double *src) const
+{
+    const double srcCount = src[0];
+    if (srcCount <= 0)
+        return;
+    const double dstCount = dst[0];
+    const double count = dstCount + srcCount;
+
+    if (m_min)
+        dst[m_min] = (std::min)(dst[m_min], src[m_min]);
+    if (m_max)
+        dst[m_max] = (std::max)(dst[m_max], src[m_max]);
+    if (m_mean)
+    {
+        double delta = src[m_mean] - dst[m_mean];
+        if (m_stdDev)
+            dst[m_stdDev] += src[m_stdDev] +
+                delta * delta * dstCount * srcCount / count;
+        dst[m_mean] += delta * srcCount / count;
+    }
+    if (m_idw)
+    {
+        if (!std::isnan(dst[m_idwDist]))
+        {
+            if (std::isnan(src[m_idwDist]))
+            {
+                dst[m_idw] = src[m_idw];
+                dst[m_idwDist] = src[m_idwDist];
+            }
+            else
+            {
+                dst[m_idw] += src[m_idw];
+                dst[m_idwDist] += src[m_idwDist];
+            }
+        }
+    }
+    dst[0] = count;
+}
+
+
+void GDALGrid::addBinned()
+{
+    std::stable_sort(m_bin.begin(), m_bin.end(),
+        [](const Position& p1, const Position& p2)
+            { return p1.m_tile < p2.m_tile; });
+    for (const Position& p : m_bin)
+        applyPoint(p.m_x, p.m_y, p.m_z);
+    m_bin.clear();
+}
+
+
+void GDALGrid::applyPoint(double x, double y, double z)
 {
     // Here's the logic... we divide the cells around the subject cell
     // (at iOrigin, jOrigin) into four quadrants.  We move outward from the
@@ -215,8 +660,8 @@ void GDALGrid::addPoint(double x, double y, double z)
     updateThirdQuadrant(x, y, z);
     updateFourthQuadrant(x, y, z);
 
-    int iOrigin = m_count->xCell(x);
-    int jOrigin = m_count->yCell(y);
+    int iOrigin = xCell(x);
+    int jOrigin = yCell(y);
 
     // This is a questionable case.  If a point is in a cell, shouldn't
     // it just be counted?
@@ -232,8 +677,8 @@ void GDALGrid::updateFirstQuadrant(double x, double y, double z)
 {
     int i, j;
     int iStart;
-    int iOrigin = m_count->xCell(x);
-    int jOrigin = m_count->yCell(y);
+    int iOrigin = xCell(x);
+    int jOrigin = yCell(y);
 
     i = iStart = (std::max)(0, iOrigin + 1);
     j = (std::min)(jOrigin, (height() - 1));
@@ -266,8 +711,8 @@ void GDALGrid::updateSecondQuadrant(double x, double y, double z)
 {
     int i, j;
     int jStart;
-    int iOrigin = m_count->xCell(x);
-    int jOrigin = m_count->yCell(y);
+    int iOrigin = xCell(x);
+    int jOrigin = yCell(y);
 
     i = (std::min)(iOrigin, (width() - 1));
     j = jStart = (std::min)(jOrigin - 1, (height() - 1));
@@ -300,8 +745,8 @@ void GDALGrid::updateThirdQuadrant(double x, double y, double z)
 {
     int i, j;
     int iStart;
-    int iOrigin = m_count->xCell(x);
-    int jOrigin = m_count->yCell(y);
+    int iOrigin = xCell(x);
+    int jOrigin = yCell(y);
 
     i = iStart = (std::min)(iOrigin - 1, (width() - 1));
     j = (std::max)(jOrigin, 0);
@@ -335,8 +780,8 @@ void GDALGrid::updateFourthQuadrant(double x, double y, double z)
 
     int i, j;
     int jStart;
-    int iOrigin = m_count->xCell(x);
-    int jOrigin = m_count->yCell(y);
+    int iOrigin = xCell(x);
+    int jOrigin = yCell(y);
 
     i = (std::max)(iOrigin, 0);
     j = jStart = (std::max)(jOrigin + 1, 0);
@@ -366,7 +811,7 @@ void GDALGrid::updateFourthQuadrant(double x, double y, double z)
 }
 
 
-void GDALGrid::update(size_t i, size_t j, double val, double dist)
+void GDALGrid::update(int i, int j, double val, double dist)
 {
     // Once we determine that a point is close enough to a cell to count it,
     // this function does the actual math.  We use the value of the
@@ -378,38 +823,39 @@ void GDALGrid::update(size_t i, size_t j, double val, double dist)
     // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
     // https://en.wikipedia.org/wiki/Inverse_distance_weighting
 
-    double& count = m_count->at(i, j);
+    double *c = cell(i, j);
+    double& count = c[0];
     count++;
 
     if (m_min)
     {
-        double& min = m_min->at(i, j);
+        double& min = c[m_min];
         min = (std::min)(val, min);
     }
 
     if (m_max)
     {
-        double& max = m_max->at(i, j);
+        double& max = c[m_max];
         max = (std::max)(val, max);
     }
 
     if (m_mean)
     {
-        double& mean = m_mean->at(i, j);
+        double& mean = c[m_mean];
         double delta = val - mean;
 
         mean += delta / count;
         if (m_stdDev)
         {
-            double& stdDev = m_stdDev->at(i, j);
+            double& stdDev = c[m_stdDev];
             stdDev += delta * (val - mean);
         }
     }
 
     if (m_idw)
     {
-        double& idw = m_idw->at(i, j);
-        double& idwDist = m_idwDist->at(i, j);
+        double& idw = c[m_idw];
+        double& idwDist = c[m_idwDist];
 
         // If the distance is 0, we set the idwDist to nan to signal that
         // we should ignore the distance and take the value as is.
@@ -430,48 +876,59 @@ void GDALGrid::update(size_t i, size_t j, double val, double dist)
 }
 
 void GDALGrid::finalize()
+{
+    addBinned();
+
+    forEachCell([this](int i, int j){ finalizeCell(i, j); });
+
+    if (m_windowSize > 0)
+        windowFill();
+    else
+    {
+        forEachCell([this](int i, int j)
+        {
+            if (empty(i, j))
+                fillNodata(i, j);
+        });
+    }
+}
+
+
+void GDALGrid::finalizeCell(int i, int j)
 {
     // See
     // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
     // https://en.wikipedia.org/wiki/Inverse_distance_weighting
+    double *c = cell(i, j);
+    const double count = c[0];
+    if (count <= 0)
+        return;
+
     if (m_stdDev)
-        for (size_t i = 0; i < m_count->size(); ++i)
-            if (!empty(i))
-                (*m_stdDev)[i] = sqrt((*m_stdDev)[i] / (*m_count)[i]);
+        c[m_stdDev] = sqrt(c[m_stdDev] / count);
 
     if (m_idw)
-        for (size_t i = 0; i < m_count->size(); ++i)
-            if (!empty(i))
-            {
-                double& distSum = (*m_idwDist)[i];
-                if (!std::isnan(distSum))
-                    (*m_idw)[i] /= distSum;
-            }
-
-    if (m_windowSize > 0)
-        windowFill();
-    else
     {
-        for (int i = 0; i < m_count->width(); ++i)
-            for (int j = 0; j < m_count->height(); ++j)
-                if (empty(i, j))
-                    fillNodata(i, j);
+        double& distSum = c[m_idwDist];
+        if (!std::isnan(distSum))
+            c[m_idw] /= distSum;
     }
 }
 
 
 void GDALGrid::fillNodata(int i, int j)
 {
+    double *c = cell(i, j);
     if (m_min)
-        m_min->at(i, j) = std::numeric_limits<double>::quiet_NaN();
+        c[m_min] = std::numeric_limits<double>::quiet_NaN();
     if (m_max)
-        m_max->at(i, j) = std::numeric_limits<double>::quiet_NaN();
+        c[m_max] = std::numeric_limits<double>::quiet_NaN();
     if (m_mean)
-        m_mean->at(i, j) = std::numeric_limits<double>::quiet_NaN();
+        c[m_mean] = std::numeric_limits<double>::quiet_NaN();
     if (m_idw)
-        m_idw->at(i, j) = std::numeric_limits<double>::quiet_NaN();
+        c[m_idw] = std::numeric_limits<double>::quiet_NaN();
     if (m_stdDev)
-        m_stdDev->at(i, j) = std::numeric_limits<double>::quiet_NaN();
+        c[m_stdDev] = std::numeric_limits<double>::quiet_NaN();
 }
 
 
@@ -486,10 +943,11 @@ void GDALGrid::windowFill(int dstI, int dstJ)
 
     // Initialize to 0 (rather than numeric_limits::max/lowest) since we're
     // going to accumulate and average.
+    double *dst = cell(dstI, dstJ);
     if (m_min)
-        m_min->at(dstI, dstJ) = 0;
+        dst[m_min] = 0;
     if (m_max)
-        m_max->at(dstI, dstJ) = 0;
+        dst[m_max] = 0;
 
     for (int i = istart; i < iend; ++i)
         for (int j = jstart; j < jend; ++j)
@@ -507,16 +965,19 @@ void GDALGrid::windowFill(int dstI, int dstJ)
     // Divide summed values by the (inverse) distance sum.
     if (distSum > 0)
     {
+        // Neighboring cells may be in other tiles, so get the destination
+        // again.
+        dst = cell(dstI, dstJ);
         if (m_min)
-            m_min->at(dstI, dstJ) /= distSum;
+            dst[m_min] /= distSum;
         if (m_max)
-            m_max->at(dstI, dstJ) /= distSum;
+            dst[m_max] /= distSum;
         if (m_mean)
-            m_mean->at(dstI, dstJ) /= distSum;
+            dst[m_mean] /= distSum;
         if (m_idw)
-            m_idw->at(dstI, dstJ) /= distSum;
+            dst[m_idw] /= distSum;
         if (m_stdDev)
-            m_stdDev->at(dstI, dstJ) /= distSum;
+            dst[m_stdDev] /= distSum;
     }
     else
         fillNodata(dstI, dstJ);
@@ -525,16 +986,18 @@ void GDALGrid::windowFill(int dstI, int dstJ)
 
 void GDALGrid::windowFillCell(int srcI, int srcJ, int dstI, int dstJ, double distance)
 {
+    const double *src = cell(srcI, srcJ, false);
+    double *dst = cell(dstI, dstJ);
     if (m_min)
-        m_min->at(dstI, dstJ) += m_min->at(srcI, srcJ) / distance;
+        dst[m_min] += src[m_min] / distance;
     if (m_max)
-        m_max->at(dstI, dstJ) += m_max->at(srcI, srcJ) / distance;
+        dst[m_max] += src[m_max] / distance;
     if (m_mean)
-        m_mean->at(dstI, dstJ) += m_mean->at(srcI, srcJ) / distance;
+        dst[m_mean] += src[m_mean] / distance;
     if (m_idw)
-        m_idw->at(dstI, dstJ) += m_idw->at(srcI, srcJ) / distance;
+        dst[m_idw] += src[m_idw] / distance;
     if (m_stdDev)
-        m_stdDev->at(dstI, dstJ) += m_stdDev->at(srcI, srcJ) / distance;
+        dst[m_stdDev] += src[m_stdDev] / distance;
 }
 
 } //namespace pdal
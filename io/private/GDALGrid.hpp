@@ -33,8 +33,14 @@
 ****************************************************************************/
 
 #include <math.h>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <stdexcept>
 
@@ -44,6 +50,16 @@
 namespace pdal
 {
 
+// The cells of the grid are held in square tiles that are created when
+// first touched.  The grid can expand without moving existing data.
+// If a memory limit is set, the least recently used tiles are written to
+// a scratch file when the limit is exceeded and read back when needed,
+// and points are binned by tile before they're added so that only a few
+// tiles are in use at a time.
+//
+// When the tiles are all held in memory, points can be added by several
+// threads, each into its own partial grid, and finalization works on rows
+// of tiles in parallel.
 class GDALGrid
 {
     FRIEND_TEST(GDALWriterTest, issue_2095);
@@ -61,24 +77,51 @@ public:
         {}
     };
 
+    class BandIterator;
+
+    // Function that gets the X, Y and Z values of the points
+    // [begin, begin + count).
+    using PointFunc = std::function<void(PointId begin, point_count_t count,
+        double *x, double *y, double *z)>;
+
     // Exported for testing.
+    // \param tileSize  Number of cells along each side of a tile.
+    // \param memoryLimit  Approximate number of bytes of tiles to hold in
+    //     memory.  0 means no limit.
+    // \param scratchFilename  Name of the file to which tiles are written
+    //     when the memory limit is exceeded.
     PDAL_DLL GDALGrid(double xOrigin, double yOrigin, size_t width, size_t height,
         double edgeLength, double radius, int outputTypes, size_t windowSize,
-        double power);
+        double power, size_t tileSize = 256, size_t memoryLimit = 0,
+        const std::string& scratchFilename = "");
+    PDAL_DLL ~GDALGrid();
 
     void expandToInclude(double x, double y);
 
     // Get the number of bands represented by this grid.
     int numBands() const;
 
-    // Return a pointer to the data in a raster band, row-major ordered.
-    double *data(const std::string& name);
+    // Determine if the named band is produced.
+    PDAL_DLL bool hasBand(const std::string& name) const;
+
+    // Get an iterator over the values of the named band in raster order:
+    // row by row from the top (maximum Y) of the grid.  With a memory
+    // limit, the grid keeps at least a row of tiles in memory from then on.
+    PDAL_DLL BandIterator band(const std::string& name);
+
+    // Set the number of threads used to add points and finalize the grid.
+    PDAL_DLL void setThreads(int threads);
 
     // Add a point to the raster grid.
-    void addPoint(double x, double y, double z);
+    PDAL_DLL void addPoint(double x, double y, double z);
+
+    // Add points to the raster grid.  Large sets of points are split
+    // between threads, each of which adds points to its own partial grid.
+    // The partial grids are then merged into this grid.
+    PDAL_DLL void addPoints(point_count_t count, const PointFunc& get);
 
     // Compute final values after all points have been added.
-    void finalize();
+    PDAL_DLL void finalize();
 
     int width() const;
     int height() const;
@@ -86,29 +129,98 @@ public:
     double yOrigin() const;
 
 private:
+    struct Tile
+    {
+        Tile() : m_slot(-1), m_dirty(false)
+        {}
+
+        std::vector<double> m_data;   // Values, empty when not in memory.
+        int64_t m_slot;               // Slot in the scratch file or -1.
+        bool m_dirty;                 // Changed since written to the slot.
+        std::list<uint64_t>::iterator m_lruPos;
+    };
+
+    struct Position
+    {
+        double m_x;
+        double m_y;
+        double m_z;
+        uint64_t m_tile;
+    };
+
     int m_windowSize;
     double m_edgeLength;
     double m_radius;
     double m_power;
+    RasterLimits m_limits;
+    int m_outputTypes;
 
-    typedef std::unique_ptr<Rasterd> DataPtr;
-    DataPtr m_count;
-    DataPtr m_min;
-    DataPtr m_max;
-    DataPtr m_mean;
-    DataPtr m_stdDev;
-    DataPtr m_idw;
-    DataPtr m_idwDist;
+    // Offset of the values of each statistic in a tile.  The count is
+    // always at offset zero, so zero means that a statistic isn't kept.
+    size_t m_min;
+    size_t m_max;
+    size_t m_mean;
+    size_t m_stdDev;
+    size_t m_idw;
+    size_t m_idwDist;
 
-    int m_outputTypes;
+    // Global cell indices are relative to the original origin of the grid
+    // so that tiles don't move when the grid is expanded.  These are the
+    // global indices of cell 0, 0.
+    int m_iShift;
+    int m_jShift;
 
-    // Determine if a cell i, j has no associated points.
-    bool empty(size_t i, size_t j) const
-        { return m_count->at(i, j) <= 0; }
+    int m_tileSize;
+    size_t m_tileCells;
+    size_t m_tileValues;
+    size_t m_maxTiles;
+    std::unordered_map<uint64_t, Tile> m_tiles;
+    std::list<uint64_t> m_lru;
+    uint64_t m_lastKey;
+    Tile *m_lastTile;
+    std::string m_scratchFilename;
+    std::fstream m_scratch;
+    int64_t m_slots;
+    std::vector<Position> m_bin;
+    int m_threads;
 
-    // Determine if a cell with index \c idx has no associated points.
-    bool empty(size_t idx) const
-        { return (m_count->at(idx) <= 0); }
+    // When the grid is frozen, m_index holds the tiles covering the grid,
+    // row by row, so that cells can be found from several threads.
+    std::vector<Tile *> m_index;
+    int m_indexI;
+    int m_indexJ;
+    int m_indexWidth;
+
+    // Get the values of cell i, j.  The value of a statistic is at its
+    // offset from the returned pointer.  The pointer remains valid until
+    // two other tiles have been accessed.  If the values won't be
+    // modified, pass false for 'modify' to avoid rewriting the tile to the
+    // scratch file.
+    double *cell(int i, int j, bool modify = true);
+
+    // Get the tile with the provided key, reading or creating it as
+    // necessary.
+    Tile& tile(uint64_t key);
+    uint64_t tileKey(int i, int j) const;
+    void initTile(Tile& t);
+    void evict();
+    bool parallel() const;
+    void freeze();
+    void runThreads(size_t count, const std::function<void(size_t)>& f);
+    void merge(std::vector<std::unique_ptr<GDALGrid>>& partials);
+    void mergeCell(double *dst, const double *src) const;
+    void addBinned();
+    void applyPoint(double x, double y, double z);
+    PDAL_DLL double bandValue(size_t offset, size_t pos);
+
+    int xCell(double x) const
+        { return (int)std::floor((x - m_limits.xOrigin) / m_edgeLength); }
+    int yCell(double y) const
+        { return (int)std::floor((y - m_limits.yOrigin) / m_edgeLength); }
+
+    // Determine if a cell i, j has no associated points.
+    bool empty(int i, int j)
+        { return *cell(i, j, false) <= 0; }
 
     // Determine the distance from the center of cell at coordinate i, j to
     // a point at absolute coordinate x, y.
@@ -121,7 +233,10 @@ private:
     void updateFourthQuadrant(double x, double y, double z);
 
     // Update cell at i, j with value at a distance.
-    void update(size_t i, size_t j, double val, double dist);
+    void update(int i, int j, double val, double dist);
+
+    // Compute the final value of cell i, j.
+    void finalizeCell(int i, int j);
 
     // Fill cell at index \c i with the nondata value.
     // \i  I coordinate.
@@ -139,6 +254,45 @@ private:
     // Cumulate data from a source cell to a destination cell when doing
     // a window fill.
     void windowFillCell(int srcI, int srcJ, int dstI, int dstJ, double distance);
+
+    // Call a function for each cell of the grid, a tile at a time.  Rows of
+    // tiles are processed in parallel if possible.
+    template<typename F>
+    void forEachCell(F f);
+};
+
+
+// Iterator over the values of a band, suitable for gdal::Raster::writeBand().
+class GDALGrid::BandIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = double;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const double *;
+    using reference = double;
+
+    BandIterator(GDALGrid& grid, size_t offset, size_t pos) :
+        m_grid(&grid), m_offset(offset), m_pos(pos)
+    {}
+
+    double operator*() const
+        { return m_grid->bandValue(m_offset, m_pos); }
+    BandIterator& operator++()
+        { m_pos++; return *this; }
+    BandIterator operator++(int)
+        { BandIterator it(*this); m_pos++; return it; }
+    BandIterator operator+(difference_type n) const
+        { return BandIterator(*m_grid, m_offset, m_pos + n); }
+    bool operator==(const BandIterator& other) const
+        { return m_pos == other.m_pos; }
+    bool operator!=(const BandIterator& other) const
+        { return m_pos != other.m_pos; }
+
+private:
+    GDALGrid *m_grid;
+    size_t m_offset;
+    size_t m_pos;
 };
 
 } //namespace pdal
@@ -34,23 +34,98 @@
 
 #include "Connector.hpp"
 
+#include <algorithm>
+
 #include <pdal/pdal_types.hpp>
 
+#include "../ContentCache.hpp"
+
 namespace pdal
 {
 namespace copc
 {
 
 Connector::Connector(const std::string& filename, const StringMap& headers,
-        const StringMap& query) :
-    m_filename(filename), m_headers(headers), m_query(query), m_arbiter(new arbiter::Arbiter)
-{}
+        const StringMap& query, std::shared_ptr<ContentCache> cache) :
+    m_filename(filename), m_headers(headers), m_query(query), m_arbiter(new arbiter::Arbiter),
+    m_cache(cache)
+{
+    // Local files aren't cached.
+    if (m_arbiter->isLocal(m_filename))
+        m_cache.reset();
+}
+
+bool Connector::isRemote() const
+{
+    return !m_arbiter->isLocal(m_filename);
+}
 
 std::vector<char> Connector::getBinary(uint64_t offset, int32_t size) const
 {
     if (size <= 0)
         return std::vector<char>();
 
+    std::vector<char> buf;
+    if (m_cache && m_cache->get(cacheKey(offset, size), buf))
+        return buf;
+    buf = fetch(offset, size);
+    if (m_cache)
+        m_cache->put(cacheKey(offset, size), buf);
+    return buf;
+}
+
+std::vector<std::vector<char>> Connector::getBinary(const std::vector<ByteRange>& ranges) const
+{
+    std::vector<std::vector<char>> bufs(ranges.size());
+
+    // Find the ranges that need to be read, in file order.
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        const ByteRange& r = ranges[i];
+        if (r.m_size <= 0)
+            continue;
+        if (!m_cache || !m_cache->get(cacheKey(r.m_offset, r.m_size), bufs[i]))
+            misses.push_back(i);
+    }
+    std::sort(misses.begin(), misses.end(), [&ranges](size_t a, size_t b)
+        { return ranges[a].m_offset < ranges[b].m_offset; });
+
+    // Read runs of nearby ranges together and split the result.
+    size_t i = 0;
+    while (i < misses.size())
+    {
+        const uint64_t begin = ranges[misses[i]].m_offset;
+        uint64_t end = begin + ranges[misses[i]].m_size;
+        size_t j = i + 1;
+        for (; j < misses.size(); ++j)
+        {
+            const ByteRange& r = ranges[misses[j]];
+            const uint64_t rEnd = (std::max)(end, r.m_offset + r.m_size);
+            if (r.m_offset > end + MaxGap || rEnd - begin > MaxRead)
+                break;
+            end = rEnd;
+        }
+
+        std::vector<char> buf = fetch(begin, end - begin);
+        if (buf.size() < end - begin)
+            throw pdal_error("Short read of '" + m_filename + "' at offset " +
+                std::to_string(begin) + ".");
+        for (; i < j; ++i)
+        {
+            const ByteRange& r = ranges[misses[i]];
+            const char *pos = buf.data() + (r.m_offset - begin);
+            std::vector<char>& dst = bufs[misses[i]];
+            dst.assign(pos, pos + r.m_size);
+            if (m_cache)
+                m_cache->put(cacheKey(r.m_offset, r.m_size), dst);
+        }
+    }
+    return bufs;
+}
+
+std::vector<char> Connector::fetch(uint64_t offset, uint64_t size) const
+{
     if (m_arbiter->isLocal(m_filename))
     {
         std::vector<char> buf(size);
@@ -68,5 +143,10 @@ std::vector<char> Connector::getBinary(uint64_t offset, int32_t size) const
     }
 }
 
+std::string Connector::cacheKey(uint64_t offset, int32_t size) const
+{
+    return m_filename + ":" + std::to_string(offset) + ":" + std::to_string(size);
+}
+
 } // namespace copc
 } // namespace pdal
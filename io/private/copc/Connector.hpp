@@ -36,29 +36,58 @@
 
 #include <arbiter/arbiter.hpp>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
 
 using StringMap = std::map<std::string, std::string>;
 
 namespace pdal
 {
+
+class ContentCache;
+
 namespace copc
 {
 
+struct ByteRange
+{
+    uint64_t m_offset;
+    int32_t m_size;
+};
+
 class Connector
 {
     std::string m_filename;
     StringMap m_headers;
     StringMap m_query;
     std::unique_ptr<arbiter::Arbiter> m_arbiter;
+    std::shared_ptr<ContentCache> m_cache;
 
 public:
+    // Ranges separated by no more than this many bytes are read together.
+    static const uint64_t MaxGap = 64 * 1024;
+    // Ranges aren't merged into reads larger than this.
+    static const uint64_t MaxRead = 4 * 1024 * 1024;
+
     Connector() = default;
-    Connector(const std::string& filename, const StringMap& headers, const StringMap& query);
+    PDAL_DLL Connector(const std::string& filename, const StringMap& headers,
+        const StringMap& query, std::shared_ptr<ContentCache> cache = nullptr);
 
-    std::vector<char> getBinary(uint64_t offset, int32_t size) const;
+    // Whether the file is read from a remote source.
+    PDAL_DLL bool isRemote() const;
+    PDAL_DLL std::vector<char> getBinary(uint64_t offset, int32_t size) const;
+    // Read several ranges.  Ranges that aren't cached are merged with
+    // nearby ranges into single reads.
+    PDAL_DLL std::vector<std::vector<char>> getBinary(
+        const std::vector<ByteRange>& ranges) const;
+
+private:
+    std::vector<char> fetch(uint64_t offset, uint64_t size) const;
+    std::string cacheKey(uint64_t offset, int32_t size) const;
 };
 
 } // namespace copc
 } // namespace pdal
-
@@ -110,6 +110,11 @@ public:
             (z << 1) | ((dir >> 2) & 0x1));
     }
 
+    Key parent() const
+    {
+        return Key(d - 1, x >> 1, y >> 1, z >> 1);
+    }
+
     BOX3D bounds(const BOX3D& root) const
     {
         BOX3D cellBounds;
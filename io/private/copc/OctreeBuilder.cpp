@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+#include <pdal/pdal_types.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "OctreeBuilder.hpp"
+
+namespace pdal
+{
+namespace copc
+{
+
+OctreeBuilder::OctreeBuilder(const std::string& tempBase, size_t pointLen,
+        point_count_t memoryPoints) :
+    m_tempBase(tempBase), m_itemSize(3 * sizeof(double) + pointLen),
+    m_memoryPoints((std::max)(memoryPoints, (point_count_t)1000)),
+    m_count(0), m_spilled(false)
+{}
+
+
+OctreeBuilder::~OctreeBuilder()
+{
+    for (const std::string& filename : m_tempFiles)
+        if (FileUtils::fileExists(filename))
+            FileUtils::deleteFile(filename);
+}
+
+
+void OctreeBuilder::add(double x, double y, double z, const char *record)
+{
+    size_t pos = m_items.size();
+    m_items.resize(pos + m_itemSize);
+    char *p = m_items.data() + pos;
+    std::memcpy(p, &x, sizeof(double));
+    std::memcpy(p + sizeof(double), &y, sizeof(double));
+    std::memcpy(p + 2 * sizeof(double), &z, sizeof(double));
+    std::memcpy(p + 3 * sizeof(double), record, m_itemSize - 3 * sizeof(double));
+
+    m_bounds.grow(x, y, z);
+    m_count++;
+
+    // Half of the memory is for incoming points.  The rest is used when
+    // the points are distributed.
+    if (m_items.size() >= m_memoryPoints / 2 * m_itemSize)
+        spill();
+}
+
+
+void OctreeBuilder::spill()
+{
+    append(m_tempBase + ".tmp", m_items);
+    std::vector<char>().swap(m_items);
+    m_spilled = true;
+}
+
+
+void OctreeBuilder::append(const std::string& filename,
+    const std::vector<char>& items)
+{
+    std::ostream *out;
+    if (FileUtils::fileExists(filename))
+        out = FileUtils::openExisting(filename);
+    else
+    {
+        out = FileUtils::createFile(filename);
+        m_tempFiles.push_back(filename);
+    }
+    if (!out)
+        throw pdal_error("Unable to open temporary file '" + filename + "'.");
+
+    out->seekp(0, std::ios::end);
+    out->write(items.data(), items.size());
+    bool ok = out->good();
+    FileUtils::closeFile(out);
+    if (!ok)
+        throw pdal_error("Error writing temporary file '" + filename + "'.");
+}
+
+
+std::vector<char> OctreeBuilder::readAll(const std::string& filename)
+{
+    std::vector<char> items((size_t)FileUtils::fileSize(filename));
+    std::istream *in = FileUtils::openFile(filename);
+    if (!in)
+        throw pdal_error("Unable to open temporary file '" + filename + "'.");
+    in->read(items.data(), items.size());
+    bool ok = in->good();
+    FileUtils::closeFile(in);
+    if (!ok)
+        throw pdal_error("Error reading temporary file '" + filename + "'.");
+    FileUtils::deleteFile(filename);
+    return items;
+}
+
+
+void OctreeBuilder::build(const BOX3D& cube, const NodeFunc& func)
+{
+    m_cube = cube;
+    if (!m_spilled)
+    {
+        process(Key(), m_items, MaxDepth, func);
+        return;
+    }
+    spill();
+
+    // Pick the depth of the subtree roots so that the points of each
+    // subtree are expected to fit in memory.
+    const point_count_t limit = m_memoryPoints / 2;
+    int depth = 1;
+    while (depth < 4 && m_count / std::pow(8, depth) > limit)
+        depth++;
+    const int cells = 1 << depth;
+    const double width = (m_cube.maxx - m_cube.minx) / cells;
+
+    // Distribute the spilled points to a file per subtree.
+    std::vector<std::vector<char>> buckets(cells * cells * cells);
+    std::vector<bool> used(buckets.size());
+    point_count_t buffered = 0;
+    auto flush = [&]()
+    {
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            if (buckets[i].empty())
+                continue;
+            int x = (int)(i % cells);
+            int y = (int)((i / cells) % cells);
+            int z = (int)(i / (cells * cells));
+            append(filename(cellKey(depth, x, y, z)), buckets[i]);
+            std::vector<char>().swap(buckets[i]);
+        }
+        buffered = 0;
+    };
+
+    const std::string spillFilename(m_tempBase + ".tmp");
+    std::istream *in = FileUtils::openFile(spillFilename);
+    if (!in)
+        throw pdal_error("Unable to open temporary file '" +
+            spillFilename + "'.");
+    std::vector<char> buf((limit / 2) * m_itemSize);
+    while (true)
+    {
+        in->read(buf.data(), buf.size());
+        size_t bytes = (size_t)in->gcount();
+        if (bytes == 0)
+            break;
+        for (const char *p = buf.data(); p < buf.data() + bytes;
+            p += m_itemSize)
+        {
+            double pos[3];
+            std::memcpy(pos, p, sizeof(pos));
+            int x = cell(pos[0], m_cube.minx, width, cells);
+            int y = cell(pos[1], m_cube.miny, width, cells);
+            int z = cell(pos[2], m_cube.minz, width, cells);
+            size_t i = (size_t)x + (size_t)cells * (y + (size_t)cells * z);
+            buckets[i].insert(buckets[i].end(), p, p + m_itemSize);
+            used[i] = true;
+            if (++buffered >= limit / 2)
+                flush();
+        }
+    }
+    flush();
+    FileUtils::closeFile(in);
+    FileUtils::deleteFile(spillFilename);
+    std::vector<char>().swap(buf);
+
+    // Build each subtree, holding back the points sampled for its root.
+    std::vector<char> top;
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        if (!used[i])
+            continue;
+        int x = (int)(i % cells);
+        int y = (int)((i / cells) % cells);
+        int z = (int)(i / (cells * cells));
+        const Key root = cellKey(depth, x, y, z);
+        std::vector<char> items = readAll(filename(root));
+        process(root, items, MaxDepth,
+            [&top, &root, &func](const Key& key, std::vector<char>& items)
+            {
+                if (key == root)
+                    top.insert(top.end(), items.begin(), items.end());
+                else
+                    func(key, items);
+            }
+        );
+    }
+
+    // Build the top of the tree down to the subtree roots.
+    process(Key(), top, depth, func);
+}
+
+
+void OctreeBuilder::process(const Key& key, std::vector<char>& items,
+    int stopDepth, const NodeFunc& func)
+{
+    if (items.size() / m_itemSize <= MaxNodePoints || key.d >= stopDepth)
+    {
+        func(key, items);
+        return;
+    }
+
+    std::vector<char> keep;
+    std::vector<char> children[8];
+    sample(key, items, keep, children);
+    std::vector<char>().swap(items);
+
+    func(key, keep);
+    std::vector<char>().swap(keep);
+    for (int dir = 0; dir < 8; ++dir)
+        if (children[dir].size())
+            process(key.child(dir), children[dir], stopDepth, func);
+}
+
+
+// Keep the first point that falls in each cell of a grid over the node.
+// The other points are passed to the child that contains their cell.
+void OctreeBuilder::sample(const Key& key, std::vector<char>& items,
+    std::vector<char>& keep, std::vector<char> *children)
+{
+    const BOX3D bounds = nodeBounds(key);
+    const double width = (bounds.maxx - bounds.minx) / GridSize;
+    const int half = GridSize / 2;
+
+    std::unordered_set<uint32_t> occupied;
+    for (const char *p = items.data(); p < items.data() + items.size();
+        p += m_itemSize)
+    {
+        double pos[3];
+        std::memcpy(pos, p, sizeof(pos));
+        int x = cell(pos[0], bounds.minx, width, GridSize);
+        int y = cell(pos[1], bounds.miny, width, GridSize);
+        int z = cell(pos[2], bounds.minz, width, GridSize);
+
+        uint32_t voxel = (uint32_t)((x * GridSize + y) * GridSize + z);
+        std::vector<char> *dst;
+        if (occupied.insert(voxel).second)
+            dst = &keep;
+        else
+            dst = &children[(x >= half) | ((y >= half) << 1) |
+                ((z >= half) << 2)];
+        dst->insert(dst->end(), p, p + m_itemSize);
+    }
+}
+
+
+BOX3D OctreeBuilder::nodeBounds(const Key& key) const
+{
+    const double width = (m_cube.maxx - m_cube.minx) / std::pow(2, key.d);
+
+    BOX3D b;
+    b.minx = m_cube.minx + width * key.x;
+    b.miny = m_cube.miny + width * key.y;
+    b.minz = m_cube.minz + width * key.z;
+    b.maxx = b.minx + width;
+    b.maxy = b.miny + width;
+    b.maxz = b.minz + width;
+    return b;
+}
+
+
+std::string OctreeBuilder::filename(const Key& key) const
+{
+    return m_tempBase + "-" + key.toString() + ".tmp";
+}
+
+
+int OctreeBuilder::cell(double pos, double min, double width, int cells) const
+{
+    int i = (int)std::floor((pos - min) / width);
+    return Utils::clamp(i, 0, cells - 1);
+}
+
+
+Key OctreeBuilder::cellKey(int depth, int x, int y, int z)
+{
+    Key key;
+    for (int level = depth - 1; level >= 0; --level)
+        key = key.child(((x >> level) & 1) | (((y >> level) & 1) << 1) |
+            (((z >> level) & 1) << 2));
+    return key;
+}
+
+} // namespace copc
+} // namespace pdal
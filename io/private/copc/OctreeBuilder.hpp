@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of the Martin Isenburg or Iowa Department
+ *       of Natural Resources nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <pdal/pdal_types.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include "Key.hpp"
+
+namespace pdal
+{
+namespace copc
+{
+
+// Builds the octree of a COPC file from points that need not fit in memory.
+//
+// Each point is stored as an item: its X/Y/Z as doubles followed by its LAS
+// point record.  The coordinates are kept as doubles so that the scaling
+// can be chosen once all the points have been seen.  Items are held in
+// memory up to a limit and are then spilled to a temporary file.
+//
+// When the tree is built, spilled items are distributed by position to a
+// temporary file for each node at a fixed depth, chosen so that each file
+// is expected to fit in memory.  The subtrees below these nodes are then
+// built one at a time.  The points sampled for the roots of the subtrees
+// are held back and used to build the top of the tree.
+class OctreeBuilder
+{
+public:
+    // Called with each node and the items it contains.
+    using NodeFunc = std::function<void(const Key&, std::vector<char>&)>;
+
+    // Number of cells along each side of the sampling grid of a node.
+    static const int GridSize = 128;
+    // Nodes with no more than this many points aren't split.
+    static const point_count_t MaxNodePoints = 100000;
+    // Maximum depth of the tree.
+    static const int MaxDepth = 24;
+
+    OctreeBuilder(const std::string& tempBase, size_t pointLen,
+        point_count_t memoryPoints);
+    ~OctreeBuilder();
+
+    size_t itemSize() const
+        { return m_itemSize; }
+    point_count_t count() const
+        { return m_count; }
+    const BOX3D& bounds() const
+        { return m_bounds; }
+
+    void add(double x, double y, double z, const char *record);
+
+    // Build the tree for a cube that contains all points.  The function
+    // is called for each node that contains points, from the build
+    // thread.  Parent nodes aren't necessarily passed before their children.
+    void build(const BOX3D& cube, const NodeFunc& func);
+
+private:
+    std::string m_tempBase;
+    size_t m_itemSize;
+    point_count_t m_memoryPoints;
+    point_count_t m_count;
+    BOX3D m_bounds;
+    BOX3D m_cube;
+    std::vector<char> m_items;
+    bool m_spilled;
+    std::vector<std::string> m_tempFiles;
+
+    void spill();
+    void append(const std::string& filename, const std::vector<char>& items);
+    std::vector<char> readAll(const std::string& filename);
+    void process(const Key& key, std::vector<char>& items, int stopDepth,
+        const NodeFunc& func);
+    void sample(const Key& key, std::vector<char>& items,
+        std::vector<char>& keep, std::vector<char> *children);
+    BOX3D nodeBounds(const Key& key) const;
+    std::string filename(const Key& key) const;
+    int cell(double pos, double min, double width, int cells) const;
+    static Key cellKey(int depth, int x, int y, int z);
+};
+
+} // namespace copc
+} // namespace pdal
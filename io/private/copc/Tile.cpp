@@ -45,10 +45,29 @@ namespace copc
 {
 
 void Tile::read()
+{
+    std::vector<char> buf;
+    try
+    {
+        buf = m_connector.getBinary(m_entry.m_offset, m_entry.m_byteSize);
+    }
+    catch (const std::exception& ex)
+    {
+        m_error = ex.what();
+        return;
+    }
+    catch (...)
+    {
+        m_error = "Unknown exception when reading tile contents";
+        return;
+    }
+    read(buf);
+}
+
+void Tile::read(const std::vector<char>& buf)
 {
     try
     {
-        std::vector<char> buf = m_connector.getBinary(m_entry.m_offset, m_entry.m_byteSize);
         lazperf::reader::chunk_decompressor d(m_header.pointFormat(), m_header.ebCount(),
             buf.data());
 
@@ -65,6 +65,8 @@ public:
     const std::string& error() const
         { return m_error; }
     void read();
+    // Decompress the tile from data that has already been fetched.
+    void read(const std::vector<char>& buf);
     const char *dataPtr() const
         { return m_data.data(); }
 
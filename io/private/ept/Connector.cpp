@@ -34,8 +34,12 @@
 
 #include "Connector.hpp"
 
+#include <fstream>
+
 #include <pdal/pdal_types.hpp>
 
+#include "../ContentCache.hpp"
+
 namespace pdal
 {
 namespace ept
@@ -44,14 +48,21 @@ namespace ept
 Connector::Connector() : m_arbiter(new arbiter::Arbiter())
 {}
 
-Connector::Connector(const StringMap& headers, const StringMap& query) :
-    m_arbiter(new arbiter::Arbiter), m_headers(headers), m_query(query)
+Connector::Connector(const StringMap& headers, const StringMap& query,
+        std::shared_ptr<ContentCache> cache) :
+    m_arbiter(new arbiter::Arbiter), m_headers(headers), m_query(query),
+    m_cache(cache)
 {}    
 
 std::string Connector::get(const std::string& path) const
 {
     if (m_arbiter->isLocal(path))
         return m_arbiter->get(path);
+    else if (m_cache)
+    {
+        std::vector<char> buf(getBinary(path));
+        return std::string(buf.begin(), buf.end());
+    }
     else
         return m_arbiter->get(path, m_headers, m_query);
 }
@@ -73,8 +84,14 @@ std::vector<char> Connector::getBinary(const std::string& path) const
 {
     if (m_arbiter->isLocal(path))
         return m_arbiter->getBinary(path);
-    else
-        return m_arbiter->getBinary(path, m_headers, m_query);
+
+    std::vector<char> buf;
+    if (m_cache && m_cache->get(path, buf))
+        return buf;
+    buf = m_arbiter->getBinary(path, m_headers, m_query);
+    if (m_cache)
+        m_cache->put(path, buf);
+    return buf;
 }
 
 
@@ -82,6 +99,23 @@ arbiter::LocalHandle Connector::getLocalHandle(const std::string& path) const
 {
     if (m_arbiter->isLocal(path))
         return m_arbiter->getLocalHandle(path);
+    else if (m_cache)
+    {
+        // Write the (possibly cached) content to a temporary file that's
+        // removed with the handle.
+        std::vector<char> buf(getBinary(path));
+        std::string ext(arbiter::getExtension(path));
+        std::string local(arbiter::getTempPath() +
+            std::to_string(arbiter::randomNumber()) +
+            (ext.size() ? "." + ext : ""));
+        std::ofstream out(local, std::ios::binary | std::ios::trunc);
+        out.write(buf.data(), buf.size());
+        out.close();
+        if (!out.good())
+            throw pdal_error("Unable to write temporary file '" + local +
+                "'.");
+        return arbiter::LocalHandle(local, true);
+    }
     else
         return m_arbiter->getLocalHandle(path, m_headers, m_query);
 }
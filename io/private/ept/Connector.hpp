@@ -34,12 +34,17 @@
 
 #pragma once
 
+#include <memory>
+
 #include <arbiter/arbiter.hpp>
 
 using StringMap = std::map<std::string, std::string>;
 
 namespace pdal
 {
+
+class ContentCache;
+
 namespace ept
 {
 
@@ -48,10 +53,13 @@ class Connector
     std::unique_ptr<arbiter::Arbiter> m_arbiter;
     StringMap m_headers;
     StringMap m_query;
+    std::shared_ptr<ContentCache> m_cache;
 
 public:
     Connector();
-    Connector(const StringMap& headers, const StringMap& query);
+    // Content of remote paths is kept in the cache, if provided.
+    Connector(const StringMap& headers, const StringMap& query,
+        std::shared_ptr<ContentCache> cache = nullptr);
 
     std::string get(const std::string& path) const;
     NL::json getJson(const std::string& path) const;
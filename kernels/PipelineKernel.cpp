@@ -77,6 +77,8 @@ void PipelineKernel::validateSwitches(ProgramArgs& args)
         m_mode = ExecMode::Standard;
     else
         m_mode = ExecMode::PreferStream;
+    if (m_streamBuffers && m_noStream)
+        throw pdal_error("Can't use 'stream_buffers' with 'nostream' option");
 }
 
 
@@ -105,6 +107,21 @@ void PipelineKernel::addSwitches(ProgramArgs& args)
     args.add("stream", "Run in stream mode.  Error if not streamable.",
         m_stream);
     args.add("nostream", "Run in standard mode.", m_noStream);
+    args.add("stream_buffers", "Number of point buffers used to run stages "
+        "concurrently in stream mode.  0 runs stages serially.",
+        m_streamBuffers, (size_t)0);
+    args.add("threads", "Number of threads used to run independent stages "
+        "and point views concurrently in standard mode.", m_threads,
+        (size_t)1);
+    args.add("memory_limit", "Approximate memory (in MB) used to hold "
+        "points in standard mode.  Points beyond the limit are paged to a "
+        "temporary file.  0 holds all points in memory.", m_memoryLimit,
+        (size_t)0);
+    args.add("temp_dir", "Directory for the temporary file used with "
+        "'memory_limit'.  Default is the system temporary directory.",
+        m_tempDir);
+    args.add("compact", "Release the storage of points dropped by stages "
+        "in standard mode.", m_compact);
     args.add("metadata", "Metadata filename", m_metadataFile);
     args.add("dims", "Dimensions to be stored", m_dimNames);
 }
@@ -119,6 +136,10 @@ int PipelineKernel::execute()
         m_progressFd = Utils::openProgress(m_progressFile);
         m_manager.setProgressFd(m_progressFd);
     }
+    m_manager.setStreamBuffers(m_streamBuffers);
+    m_manager.setThreads(m_threads);
+    m_manager.setMemoryLimit(m_memoryLimit * 1024 * 1024, m_tempDir);
+    m_manager.setCompact(m_compact);
 
     if (m_validate)
     {
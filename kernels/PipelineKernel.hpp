@@ -64,6 +64,11 @@ private:
     bool m_usestdin;
     bool m_stream;
     bool m_noStream;
+    size_t m_streamBuffers;
+    size_t m_threads;
+    size_t m_memoryLimit;
+    std::string m_tempDir;
+    bool m_compact;
     ExecMode m_mode;
     StringList m_dimNames;
 };
@@ -34,7 +34,12 @@
 
 #include "TIndexKernel.hpp"
 
+#include <cstdio>
+#include <condition_variable>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <ogr_api.h>
@@ -61,6 +66,35 @@ void setDate(OGRFeatureH feature, const tm& tyme, int fieldNumber)
 }
 
 
+// Format a time as text, for drivers that can't store the time of day
+// in a date field.
+std::string dateText(const tm& tyme)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02d",
+        tyme.tm_year + 1900, tyme.tm_mon + 1, tyme.tm_mday, tyme.tm_hour,
+        tyme.tm_min, tyme.tm_sec);
+    return buf;
+}
+
+
+bool parseDateText(const char *text, tm& tyme)
+{
+    int year, month, day, hour, minute, second;
+    if (std::sscanf(text, "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour,
+            &minute, &second) != 6)
+        return false;
+    tyme = tm();
+    tyme.tm_year = year - 1900;
+    tyme.tm_mon = month - 1;
+    tyme.tm_mday = day;
+    tyme.tm_hour = hour;
+    tyme.tm_min = minute;
+    tyme.tm_sec = second;
+    return true;
+}
+
+
 } // anonymous namespace
 
 
@@ -84,6 +118,7 @@ TIndexKernel::TIndexKernel() : SubcommandKernel()
     , m_dataset(NULL)
     , m_layer(NULL)
     , m_overrideASrs(false)
+    , m_threads(1)
 {}
 
 
@@ -118,6 +153,8 @@ void TIndexKernel::addSubSwitches(ProgramArgs& args,
             "Write absolute rather than relative file paths", m_absPath);
         args.add("stdin,s", "Read filespec pattern from standard input",
             m_usestdin);
+        args.add("threads", "Number of threads used to inspect files",
+            m_threads, (size_t)1);
     }
     else if (subcommand == "merge")
     {
@@ -197,34 +234,58 @@ StringList readSTDIN()
 }
 
 
-bool TIndexKernel::isFileIndexed(const FieldIndexes& indexes,
-    const FileInfo& fileInfo)
+TIndexKernel::IndexMap TIndexKernel::readIndex(const FieldIndexes& indexes)
 {
-    std::ostringstream qstring;
+    IndexMap index;
 
-    qstring << Utils::toupper(m_tileIndexColumnName) << "=" <<
-        "'" << fileInfo.m_filename << "'";
-    std::string query = qstring.str();
-    OGRErr err = OGR_L_SetAttributeFilter(m_layer, query.c_str());
-    if (err != OGRERR_NONE)
+    // Some drivers (shapefiles) store only the date of the modification
+    // time in the modified field, which can't tell whether a file has
+    // changed.
+    bool dateOnly(false);
+    if (indexes.m_mtime >= 0)
     {
-        std::ostringstream oss;
-        oss << "Unable to set attribute filter for file '" <<
-             fileInfo.m_filename << "'";
-        throw pdal_error(oss.str());
+        OGRFieldDefnH fDefn = OGR_FD_GetFieldDefn(OGR_L_GetLayerDefn(m_layer),
+            indexes.m_mtime);
+        dateOnly = (OGR_Fld_GetType(fDefn) == OFTDate);
     }
 
-    bool output(false);
     OGR_L_ResetReading(m_layer);
-    auto hFeat = OGR_L_GetNextFeature(m_layer);
-    if( hFeat )
+    while (true)
     {
-        OGR_F_Destroy(hFeat);
-        output = true;
+        OGRFeatureH feature = OGR_L_GetNextFeature(m_layer);
+        if (!feature)
+            break;
+
+        IndexEntry& entry =
+            index[OGR_F_GetFieldAsString(feature, indexes.m_filename)];
+        entry.m_fids.push_back(OGR_F_GetFID(feature));
+
+        // The text field holds the full time when the modified field
+        // holds only a date.
+        int year, month, day, hour, minute, second, tz;
+        if (indexes.m_mtimeText >= 0 &&
+            OGR_F_IsFieldSet(feature, indexes.m_mtimeText))
+            entry.m_hasMtime = parseDateText(
+                OGR_F_GetFieldAsString(feature, indexes.m_mtimeText),
+                entry.m_mtime);
+        else if (!dateOnly && indexes.m_mtime >= 0 &&
+            OGR_F_IsFieldSet(feature, indexes.m_mtime) &&
+            OGR_F_GetFieldAsDateTime(feature, indexes.m_mtime, &year, &month,
+                &day, &hour, &minute, &second, &tz))
+        {
+            entry.m_hasMtime = true;
+            entry.m_mtime = tm();
+            entry.m_mtime.tm_year = year - 1900;
+            entry.m_mtime.tm_mon = month - 1;
+            entry.m_mtime.tm_mday = day;
+            entry.m_mtime.tm_hour = hour;
+            entry.m_mtime.tm_min = minute;
+            entry.m_mtime.tm_sec = second;
+        }
+        OGR_F_Destroy(feature);
     }
     OGR_L_ResetReading(m_layer);
-    OGR_L_SetAttributeFilter(m_layer, NULL);
-    return output;
+    return index;
 }
 
 
@@ -272,28 +333,185 @@ void TIndexKernel::createFile()
         }
 
     FieldIndexes indexes = getFields();
+    const IndexMap index = readIndex(indexes);
+    const bool hasTimes = indexes.m_mtime >= 0 || indexes.m_mtimeText >= 0;
+
+    enum class Status
+    {
+        Pending,
+        Unchanged,
+        Changed,
+        Skipped
+    };
+
+    struct Result
+    {
+        Result() : m_status(Status::Pending), m_entry(nullptr)
+        {}
+
+        Status m_status;
+        FileInfo m_info;
+        const IndexEntry *m_entry;
+        std::exception_ptr m_error;
+    };
+
+    // Determine whether a file needs to be indexed and, if so, compute its
+    // boundary.  This may be called from several threads at once.
+    // Files in an index without modification times are never reindexed.
+    // Files whose full modification time wasn't stored always are.
+    auto process = [this, &index, hasTimes](StageFactory& factory,
+        const std::string& f, Result& r)
+    {
+        r.m_entry = nullptr;
+        auto it = index.find(f);
+        if (it != index.end())
+        {
+            r.m_entry = &it->second;
+            if (!hasTimes)
+            {
+                r.m_status = Status::Unchanged;
+                return;
+            }
+            struct tm ctime = tm();
+            struct tm mtime = tm();
+            FileUtils::fileTimes(f, &ctime, &mtime);
+            const struct tm& t = r.m_entry->m_mtime;
+            if (r.m_entry->m_hasMtime && t.tm_year == mtime.tm_year &&
+                t.tm_mon == mtime.tm_mon && t.tm_mday == mtime.tm_mday &&
+                t.tm_hour == mtime.tm_hour && t.tm_min == mtime.tm_min &&
+                t.tm_sec == mtime.tm_sec)
+            {
+                r.m_status = Status::Unchanged;
+                return;
+            }
+        }
+        r.m_status = getFileInfo(factory, f, r.m_info) ?
+            Status::Changed : Status::Skipped;
+    };
+
+    //ABELL - Not sure why we need to get absolute path here.
+    std::vector<std::string> files;
+    for (const std::string& f : m_files)
+        files.push_back(FileUtils::toAbsolutePath(f));
+
+    std::vector<std::unique_ptr<Result>> results(files.size());
+    for (auto& r : results)
+        r.reset(new Result);
+
+    // Workers compute the results for files in order, but no further ahead
+    // of the writer than the window.  The OGR layer is only touched from
+    // this thread.
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next(0);
+    size_t written(0);
+    bool stop(false);
+    const size_t window = 16 * m_threads;
+    auto work = [&]()
+    {
+        StageFactory factory(false);
+        while (true)
+        {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]()
+                    { return stop || next >= files.size() ||
+                        next < written + window; });
+                if (stop || next >= files.size())
+                    return;
+                i = next++;
+            }
+            Result r;
+            try
+            {
+                process(factory, files[i], r);
+            }
+            catch (...)
+            {
+                r.m_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            *results[i] = std::move(r);
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    if (m_threads > 1)
+        for (size_t i = 0; i < m_threads; ++i)
+            threads.emplace_back(work);
+    auto join = [&]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (std::thread& t : threads)
+            t.join();
+        threads.clear();
+    };
 
     size_t filecount(0);
     StageFactory factory(false);
-    for (auto f : m_files)
+    try
     {
-        //ABELL - Not sure why we need to get absolute path here.
-        f = FileUtils::toAbsolutePath(f);
-        FileInfo info;
-        if (getFileInfo(factory, f, info))
+        for (size_t i = 0; i < files.size(); ++i)
         {
+            const std::string& f = files[i];
+            std::unique_ptr<Result> r;
+            if (threads.empty())
+            {
+                r.reset(new Result);
+                process(factory, f, *r);
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]()
+                    { return results[i]->m_status != Status::Pending ||
+                        results[i]->m_error; });
+                r = std::move(results[i]);
+                written = i + 1;
+                cv.notify_all();
+            }
+            if (r->m_error)
+                std::rethrow_exception(r->m_error);
+
+            if (r->m_status == Status::Skipped)
+            {
+                m_log->get(LogLevel::Error) << "Skipping file '" << f <<
+                    "': can't compute boundary." << std::endl;
+                continue;
+            }
             filecount++;
-            if (!isFileIndexed(indexes, info))
+            if (r->m_status == Status::Unchanged)
             {
-                if (createFeature(indexes, info))
-                    m_log->get(LogLevel::Info) << "Indexed file " << f <<
-                    std::endl;
-                else
-                    m_log->get(LogLevel::Error) << "Failed to create feature "
-                        "for file '" << f << "'" << std::endl;
+                m_log->get(LogLevel::Debug) << "File " << f <<
+                    " is unchanged" << std::endl;
+                continue;
             }
+
+            // Replace the features of a file that has been modified.
+            if (r->m_entry)
+                for (int64_t fid : r->m_entry->m_fids)
+                    OGR_L_DeleteFeature(m_layer, (GIntBig)fid);
+            if (createFeature(indexes, r->m_info))
+                m_log->get(LogLevel::Info) << "Indexed file " << f <<
+                    std::endl;
+            else
+                m_log->get(LogLevel::Error) << "Failed to create feature "
+                    "for file '" << f << "'" << std::endl;
         }
     }
+    catch (...)
+    {
+        join();
+        throw;
+    }
+    join();
+
     if (!filecount)
         throw pdal_error("Couldn't index any files.");
     OGR_DS_Destroy(m_dataset);
@@ -422,6 +640,9 @@ bool TIndexKernel::createFeature(const FieldIndexes& indexes,
 
     // Set the file mod time into the feature.
     setDate(hFeature, fileInfo.m_mtime, indexes.m_mtime);
+    if (indexes.m_mtimeText >= 0)
+        OGR_F_SetFieldString(hFeature, indexes.m_mtimeText,
+            dateText(fileInfo.m_mtime).c_str());
 
     // Set the filename into the feature.
     OGR_F_SetFieldString(hFeature, indexes.m_filename,
@@ -519,11 +740,7 @@ bool TIndexKernel::getFileInfo(StageFactory& factory,
         fast = true;
     }
     if (fast && !fastBoundary(reader, fileInfo))
-    {
-        m_log->get(LogLevel::Error) << "Skipping file '" << filename <<
-            "': can't compute boundary." << std::endl;
         return false;
-    }
     FileUtils::fileTimes(filename, &fileInfo.m_ctime, &fileInfo.m_mtime);
     fileInfo.m_filename = filename;
 
@@ -608,6 +825,18 @@ void TIndexKernel::createFields()
     hFieldDefn = OGR_Fld_Create("created", OFTDateTime);
     OGR_L_CreateField(m_layer, hFieldDefn, TRUE);
     OGR_Fld_Destroy(hFieldDefn);
+
+    // Drivers that store only the date in the "modified" field get the
+    // full time as text as well.
+    int idx = OGR_FD_GetFieldIndex(OGR_L_GetLayerDefn(m_layer), "modified");
+    if (idx >= 0 && OGR_Fld_GetType(OGR_FD_GetFieldDefn(
+            OGR_L_GetLayerDefn(m_layer), idx)) == OFTDate)
+    {
+        hFieldDefn = OGR_Fld_Create("mod_time", OFTString);
+        OGR_Fld_SetWidth(hFieldDefn, 19);
+        OGR_L_CreateField(m_layer, hFieldDefn, TRUE);
+        OGR_Fld_Destroy(hFieldDefn);
+    }
 }
 
 
@@ -639,6 +868,7 @@ TIndexKernel::FieldIndexes TIndexKernel::getFields()
 
     indexes.m_ctime = OGR_FD_GetFieldIndex(fDefn, "created");
     indexes.m_mtime = OGR_FD_GetFieldIndex(fDefn, "modified");
+    indexes.m_mtimeText = OGR_FD_GetFieldIndex(fDefn, "mod_time");
 
     return indexes;
 }
@@ -34,6 +34,9 @@
 
 #pragma once
 
+#include <map>
+#include <vector>
+
 #include <pdal/Stage.hpp>
 #include <pdal/SubcommandKernel.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -66,7 +69,20 @@ class PDAL_DLL TIndexKernel : public SubcommandKernel
         int m_srs;
         int m_ctime;
         int m_mtime;
+        int m_mtimeText;
+    };
+
+    // Features of an existing index for a file.
+    struct IndexEntry
+    {
+        IndexEntry() : m_hasMtime(false)
+        {}
+
+        std::vector<int64_t> m_fids;
+        bool m_hasMtime;
+        struct tm m_mtime;
     };
+    using IndexMap = std::map<std::string, IndexEntry>;
 
 public:
     std::string getName() const;
@@ -94,7 +110,7 @@ private:
     bool fastBoundary(Stage& reader, FileInfo& fileInfo);
     bool slowBoundary(Stage& hexer, FileInfo& fileInfo);
 
-    bool isFileIndexed( const FieldIndexes& indexes, const FileInfo& fileInfo);
+    IndexMap readIndex(const FieldIndexes& indexes);
 
     std::string m_idxFilename;
     std::string m_filespec;
@@ -114,6 +130,7 @@ private:
     bool m_fastBoundary;
     bool m_usestdin;
     bool m_overrideASrs;
+    size_t m_threads;
 };
 
 } // namespace pdal
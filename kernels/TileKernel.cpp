@@ -34,6 +34,11 @@
 
 #include "TileKernel.hpp"
 
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <thread>
+
 #include <pdal/StageFactory.hpp>
 #include <pdal/StageWrapper.hpp>
 #include <pdal/Writer.hpp>
@@ -51,6 +56,69 @@ static StaticPluginInfo const s_info
 
 CREATE_STATIC_KERNEL(TileKernel, s_info)
 
+namespace
+{
+
+// Point buffer of a worker thread.  Shares the layout of the kernel's table.
+class TilePointTable : public StreamPointTable
+{
+public:
+    TilePointTable(PointLayout& layout, point_count_t capacity)
+        : StreamPointTable(layout, capacity)
+        , m_buf(pointsToBytes(capacity + 1))
+    {}
+
+protected:
+    virtual void reset()
+        { std::fill(m_buf.begin(), m_buf.end(), 0); }
+
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+
+private:
+    std::vector<char> m_buf;
+};
+
+// Call 'f' with each item number from 'first' up to 'count', spread over
+// 'workers' threads.  'f' is also passed the number of the worker.  The
+// first exception thrown is rethrown once all the threads are done.
+void runWorkers(size_t workers, size_t first, size_t count,
+    const std::function<void(size_t, size_t)>& f)
+{
+    std::atomic<size_t> next(first);
+    std::vector<std::exception_ptr> errors(workers);
+    auto work = [&](size_t worker)
+    {
+        try
+        {
+            size_t item;
+            while ((item = next++) < count)
+                f(worker, item);
+        }
+        catch (...)
+        {
+            errors[worker] = std::current_exception();
+            next = count;
+        }
+    };
+
+    if (workers == 1)
+        work(0);
+    else
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < workers; ++i)
+            threads.emplace_back(work, i);
+        for (std::thread& t : threads)
+            t.join();
+    }
+    for (std::exception_ptr& err : errors)
+        if (err)
+            std::rethrow_exception(err);
+}
+
+} // unnamed namespace
+
 TileKernel::TileKernel() : m_table(10000), m_repro(nullptr)
 {}
 
@@ -75,6 +143,10 @@ void TileKernel::addSwitches(ProgramArgs& args)
         m_buffer);
     args.add("out_srs", "Output SRS to which points will be reprojected",
         m_outSrs);
+    args.add("threads", "Number of threads used to read input files",
+        m_threads, (size_t)1);
+    args.add("max_writers", "Maximum number of output files open at once.  "
+        "0 means no limit", m_maxWriters, (size_t)100);
 }
 
 
@@ -84,6 +156,7 @@ void TileKernel::validateSwitches(ProgramArgs& args)
     if (m_hashPos == std::string::npos)
         throw pdal_error("Output filename must contain a single '#' "
             "template placeholder.");
+    m_threads = (std::max)(m_threads, (size_t)1);
 }
 
 
@@ -98,8 +171,20 @@ int TileKernel::execute()
     for (auto&& file : files)
         readers[file] = prepareReader(file);
     checkReaders(readers);
+
+    // Each thread reprojects with its own filter.
+    const size_t workers = (std::min)(m_threads, readers.size());
     if (m_repro)
-        m_repro->prepare(m_table);
+    {
+        m_repros.push_back(m_repro);
+        Options opts;
+        opts.add("out_srs", m_outSrs);
+        for (size_t i = 1; i < workers; ++i)
+            m_repros.push_back(dynamic_cast<Streamable *>(
+                &m_manager.makeFilter("filters.reprojection", opts)));
+        for (Streamable *repro : m_repros)
+            repro->prepare(m_table);
+    }
     Options opts;
     opts.add("length", m_length);
     opts.add("buffer", m_buffer);
@@ -109,8 +194,10 @@ int TileKernel::execute()
     m_table.finalize();
     process(readers);
     StageWrapper::done(m_splitter, m_table);
-    for (auto&& wp : m_writers)
-        StageWrapper::done(*wp.second, m_table);
+    for (auto& tp : m_tiles)
+        if (tp.second.m_writer)
+            closeTile(tp.second);
+    mergeTiles();
     return 0;
 }
 
@@ -192,128 +279,342 @@ Streamable *TileKernel::prepareReader(const std::string& filename)
 }
 
 
-// We calculate the origin specially in order to avoid a "first point"
-// check for every point iteration, seeing as we might have BILLIONS
-// of points to process.
+// Input files are read by a pool of threads.  Each thread reads a file at
+// a time into its own table, reprojects and splits the points, and then
+// passes the points of each tile to the tile's writer.  If no origin was
+// provided, the first point read is used as the origin, so files are
+// read in order until a point is found before the threads are started.
 void TileKernel::process(const Readers& readers)
 {
-    using std::placeholders::_1;
-    using std::placeholders::_2;
-    using std::placeholders::_3;
-    SplitterFilter::PointAdder adder =
-        std::bind(&TileKernel::adder, this, _1, _2, _3);
+    std::vector<Streamable *> files;
+    for (auto&& rp : readers)
+        files.push_back(rp.second);
+
+    const size_t workers = (std::min)(m_threads, files.size());
+    std::vector<std::unique_ptr<TilePointTable>> tables;
+    for (size_t i = 0; i < workers; ++i)
+        tables.emplace_back(
+            new TilePointTable(*m_table.layout(), m_table.capacity()));
+    auto repro = [this](size_t worker)
+        { return m_repros.size() ? m_repros[worker] : nullptr; };
+
+    // Writers are readied with the kernel's table.
+    for (Streamable *r : files)
+    {
+        SpatialReference srs = r->getSpatialReference();
+        if (!srs.empty())
+        {
+            m_table.setSpatialReference(srs);
+            break;
+        }
+    }
 
-    bool haveOrigin(false);
     StageWrapper::ready(m_splitter, m_table);
-    for (auto&& rp : readers)
+    size_t first = 0;
+    bool haveOrigin = !std::isnan(m_xOrigin) && !std::isnan(m_yOrigin);
+    if (haveOrigin)
+        m_splitter.setOrigin(m_xOrigin, m_yOrigin);
+    while (!haveOrigin && first < files.size())
+        haveOrigin = processFile(*files[first++], *tables[0], repro(0), true);
+
+    runWorkers(workers, first, files.size(),
+        [this, &files, &tables, &repro](size_t worker, size_t file)
+        {
+            processFile(*files[file], *tables[worker], repro(worker), false);
+        }
+    );
+}
+
+
+// Read, reproject, split and write the points of a file.  Returns true if
+// the origin is set.
+bool TileKernel::processFile(Streamable& r, StreamPointTable& table,
+    Streamable *repro, bool findOrigin)
+{
+    const point_count_t capacity = table.capacity();
+    std::vector<bool> skips(capacity);
+    PointRef point(table, 0);
+    Buckets buckets;
+    SplitterFilter::PointAdder adder =
+        [&buckets](PointRef& p, int xpos, int ypos)
+        { buckets[Coord(xpos, ypos)].push_back(p.pointId()); };
+
+    SpatialReference srs = r.getSpatialReference();
+    if (!srs.empty())
+        table.setSpatialReference(srs);
+    StreamableWrapper::ready(r, table);
+    if (repro)
+        StreamableWrapper::spatialReferenceChanged(*repro, srs);
+
+    bool finished(false);
+    while (!finished)
     {
-        Streamable& r = *(rp.second);
-        std::vector<bool> skips(m_table.capacity());
-        PointId idx(0);
-        PointRef point(m_table, idx);
-
-        StreamableWrapper::ready(r, m_table);
-        if (m_repro)
-            StreamableWrapper::spatialReferenceChanged(*m_repro,
-                r.getSpatialReference());
-
-        // Read first point.
-        bool finished(false);
-        finished = !StreamableWrapper::processOne(r, point);
-        if (!haveOrigin && !finished)
+        // Read points.
+        point_count_t count = 0;
+        while (count < capacity)
+        {
+            point.setPointId(count);
+            if (!StreamableWrapper::processOne(r, point))
+            {
+                finished = true;
+                break;
+            }
+            count++;
+        }
+
+        if (findOrigin && count)
         {
+            point.setPointId(0);
             if (std::isnan(m_xOrigin))
                 m_xOrigin = point.getFieldAs<double>(Dimension::Id::X);
             if (std::isnan(m_yOrigin))
                 m_yOrigin = point.getFieldAs<double>(Dimension::Id::Y);
             m_splitter.setOrigin(m_xOrigin, m_yOrigin);
-            haveOrigin = true;
+            findOrigin = false;
         }
 
-        idx++;
-        while (!finished)
-        {
-            // Read subsequent points.
-            while (true)
+        // Reproject if necessary.
+        if (repro)
+            for (PointId idx = 0; idx < count; ++idx)
             {
                 point.setPointId(idx);
-                finished = !StreamableWrapper::processOne(r, point);
-                idx++;
-                if (idx == m_table.capacity() || finished)
-                    break;
+                skips[idx] = !StreamableWrapper::processOne(*repro, point);
             }
-            PointId last = idx - 1;
 
-            SpatialReference srs = r.getSpatialReference();
-            if (!srs.empty())
-                m_table.setSpatialReference(srs);
-            // Reproject if necessary.
-            if (m_repro)
-            {
-                for (idx = 0; idx < last; ++idx)
-                {
-                    point.setPointId(idx);
-                    if (!StreamableWrapper::processOne(*m_repro, point))
-                        skips[idx] = true;
-                }
-                SpatialReference srs = r.getSpatialReference();
-                if (!srs.empty())
-                    m_table.setSpatialReference(srs);
-            }
+        // Split and write.
+        for (PointId idx = 0; idx < count; ++idx)
+        {
+            if (skips[idx])
+                continue;
 
-            // Split and write.
-            for (idx = 0; idx < last; ++idx)
-            {
-                if (skips[idx])
-                    continue;
+            point.setPointId(idx);
+            m_splitter.processPoint(point, adder);
+        }
+        write(buckets, table);
+        std::fill(skips.begin(), skips.end(), false);
+    }
+    StreamableWrapper::done(r, table);
+    if (repro)
+        StreamableWrapper::done(*repro, table);
+    return !findOrigin;
+}
 
-                point.setPointId(idx);
-                m_splitter.processPoint(point, adder);
 
-            }
-            for (size_t i = 0; i < skips.size(); ++i)
-                skips[i] = false;
-            idx = 0;
+// Pass the points of each tile to its writer or its spill file.  Writers
+// are shared by the threads, so only one thread writes at a time.
+void TileKernel::write(Buckets& buckets, StreamPointTable& table)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    PointRef point(table, 0);
+    for (auto& bp : buckets)
+    {
+        Tile& tile = openTile(bp.first);
+        if (!tile.m_writer)
+        {
+            spill(tile, table, bp.second);
+            continue;
         }
-        StreamableWrapper::done(r, m_table);
-        if (m_repro)
-            StreamableWrapper::done(*m_repro, m_table);
+        for (PointId idx : bp.second)
+        {
+            point.setPointId(idx);
+            StreamableWrapper::processOne(*tile.m_writer, point);
+        }
+    }
+    buckets.clear();
+}
+
+
+// Find a tile, creating its writer if it has never been opened.  When
+// too many writers are open, the least recently used one is closed.
+TileKernel::Tile& TileKernel::openTile(const Coord& loc)
+{
+    Tile& tile = m_tiles[loc];
+    if (tile.m_writer)
+    {
+        m_lru.splice(m_lru.begin(), m_lru, tile.m_lruPos);
+        return tile;
+    }
+    if (tile.m_closed)
+        return tile;
+
+    if (m_maxWriters && m_lru.size() >= m_maxWriters)
+        closeTile(m_tiles[m_lru.back()]);
+
+    tile.m_filename = m_outputFile;
+    std::string xname(std::to_string(loc.first));
+    std::string yname(std::to_string(loc.second));
+    tile.m_filename.replace(m_hashPos, 1, (xname + "_" + yname));
+
+    Stage *w = &m_manager.makeWriter(tile.m_filename, "");
+    if (!w)
+        throw pdal_error("Couldn't create writer for output file '" +
+            m_outputFile + "'.");
+    Streamable *sw = dynamic_cast<Streamable *>(w);
+    if (!sw)
+        throw pdal_error("Driver '" + w->getName() + "' for input file '" +
+            m_outputFile + "' is not streamable.");
+
+    sw->prepare(m_table);
+    StreamableWrapper::spatialReferenceChanged(*sw, m_outSrs);
+    StreamableWrapper::ready(*sw, m_table);
+    tile.m_writer = sw;
+    tile.m_lruPos = m_lru.insert(m_lru.begin(), loc);
+    return tile;
+}
+
+
+void TileKernel::closeTile(Tile& tile)
+{
+    StreamableWrapper::done(*tile.m_writer, m_table);
+    tile.m_writer = nullptr;
+    tile.m_closed = true;
+    m_lru.erase(tile.m_lruPos);
+}
+
+
+std::string TileKernel::spillFilename(const Tile& tile) const
+{
+    return tile.m_filename + ".spill";
+}
+
+
+// Append points to the spill file of a tile whose writer has been closed.
+// Points are stored with the dimensions and types of the kernel's table.
+void TileKernel::spill(Tile& tile, StreamPointTable& table,
+    const std::vector<PointId>& ids)
+{
+    const DimTypeList dims = m_table.layout()->dimTypes();
+    const size_t pointSize = m_table.layout()->pointSize();
+
+    std::vector<char> buf(ids.size() * pointSize);
+    char *pos = buf.data();
+    PointRef point(table, 0);
+    for (PointId idx : ids)
+    {
+        point.setPointId(idx);
+        point.getPackedData(dims, pos);
+        pos += pointSize;
     }
+
+    const std::string filename(spillFilename(tile));
+    std::ostream *out = tile.m_spilled ? FileUtils::openExisting(filename) :
+        FileUtils::createFile(filename);
+    if (!out)
+        throw pdal_error("Unable to open temporary file '" + filename + "'.");
+    out->seekp(0, std::ios::end);
+    out->write(buf.data(), buf.size());
+    bool ok = out->good();
+    FileUtils::closeFile(out);
+    if (!ok)
+        throw pdal_error("Error writing temporary file '" + filename + "'.");
+    tile.m_spilled = true;
 }
 
 
-void TileKernel::adder(PointRef& point, int xpos, int ypos)
+// Rewrite each tile with spilled points from its output file and its
+// spill file.  The stages are created and prepared serially and the tiles
+// are merged by the pool of threads.
+void TileKernel::mergeTiles()
 {
-    Coord loc(xpos, ypos);
+    std::vector<Merge> merges;
+    for (auto& tp : m_tiles)
+    {
+        Tile& tile = tp.second;
+        if (!tile.m_spilled)
+            continue;
+
+        std::string driver = StageFactory::inferReaderDriver(tile.m_filename);
+        if (driver.empty())
+            throw pdal_error("Can't read output file '" + tile.m_filename +
+                "' to add spilled points.  Increase 'max_writers'.");
+        Stage& r = m_manager.makeReader(tile.m_filename, driver);
+
+        std::string ext = FileUtils::extension(tile.m_filename);
+        std::string tempFilename = tile.m_filename.substr(0,
+            tile.m_filename.size() - ext.size()) + ".merge" + ext;
+        driver = StageFactory::inferWriterDriver(tile.m_filename);
+        Stage& w = m_manager.makeWriter(tempFilename, driver);
+
+        Merge m;
+        m.m_tile = &tile;
+        m.m_reader = dynamic_cast<Streamable *>(&r);
+        m.m_writer = dynamic_cast<Streamable *>(&w);
+        m.m_tempFilename = tempFilename;
+        if (!m.m_reader || !m.m_writer)
+            throw pdal_error("Can't stream output file '" + tile.m_filename +
+                "' to add spilled points.  Increase 'max_writers'.");
+
+        // Points are merged one at a time, so a small table will do.
+        m.m_table.reset(new FixedPointTable(1000));
+        PointLayoutPtr layout = m.m_table->layout();
+        m.m_reader->prepare(*m.m_table);
+
+        // Map the dimensions of the spilled points to the merge table.
+        PointLayoutPtr srcLayout = m_table.layout();
+        for (const DimType& dt : srcLayout->dimTypes())
+            m.m_dims.push_back(DimType(layout->registerOrAssignDim(
+                srcLayout->dimName(dt.m_id), dt.m_type), dt.m_type));
+        m.m_writer->prepare(*m.m_table);
+        m.m_table->finalize();
+        merges.push_back(std::move(m));
+    }
+
+    if (merges.empty())
+        return;
+    m_log->get(LogLevel::Debug) << "Merging spilled points into " <<
+        merges.size() << " tiles." << std::endl;
+    runWorkers((std::min)(m_threads, merges.size()), 0, merges.size(),
+        [this, &merges](size_t, size_t i)
+        {
+            mergeTile(merges[i]);
+        }
+    );
+}
 
-    Stage *w;
-    Streamable *sw;
 
-    auto wi = m_writers.find(loc);
-    if (wi == m_writers.end())
+void TileKernel::mergeTile(Merge& m)
+{
+    FixedPointTable& table = *m.m_table;
+    Streamable& reader = *m.m_reader;
+    Streamable& writer = *m.m_writer;
+
+    table.setSpatialReference(m_table.spatialReference());
+    StreamableWrapper::spatialReferenceChanged(writer, m_outSrs);
+    StreamableWrapper::ready(writer, table);
+
+    PointRef point(table, 0);
+    StreamableWrapper::ready(reader, table);
+    while (StreamableWrapper::processOne(reader, point))
+        StreamableWrapper::processOne(writer, point);
+    StreamableWrapper::done(reader, table);
+
+    const std::string filename(spillFilename(*m.m_tile));
+    const size_t pointSize = m_table.layout()->pointSize();
+    std::istream *in = FileUtils::openFile(filename);
+    if (!in)
+        throw pdal_error("Unable to open temporary file '" + filename + "'.");
+    std::vector<char> buf(table.capacity() * pointSize);
+    while (true)
     {
-        std::string filename(m_outputFile);
-        std::string xname(std::to_string(xpos));
-        std::string yname(std::to_string(ypos));
-        filename.replace(m_hashPos, 1, (xname + "_" + yname));
-
-        w = &m_manager.makeWriter(filename, "");
-        if (!w)
-            throw pdal_error("Couldn't create writer for output file '" +
-                m_outputFile + "'.");
-        sw = dynamic_cast<Streamable *>(w);
-        if (!sw)
-            throw pdal_error("Driver '" + w->getName() + "' for input file '" +
-                m_outputFile + "' is not streamable.");  
-        m_writers[loc] = sw;
-
-        sw->prepare(m_table);
-        StreamableWrapper::spatialReferenceChanged(*sw, m_outSrs);
-        StreamableWrapper::ready(*sw, m_table);
+        in->read(buf.data(), buf.size());
+        point_count_t count = (point_count_t)(in->gcount() / pointSize);
+        if (count == 0)
+            break;
+        table.clear(count);
+        for (PointId idx = 0; idx < count; ++idx)
+        {
+            point.setPointId(idx);
+            point.setPackedData(m.m_dims, buf.data() + idx * pointSize);
+            StreamableWrapper::processOne(writer, point);
+        }
     }
-    else
-        sw = wi->second;
-    StreamableWrapper::processOne(*sw, point);
+    FileUtils::closeFile(in);
+    StreamableWrapper::done(writer, table);
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(m.m_tile->m_filename);
+    FileUtils::renameFile(m.m_tile->m_filename, m.m_tempFilename);
 }
 
 } // namespace pdal
@@ -34,7 +34,11 @@
 
 #pragma once
 
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <pdal/Kernel.hpp>
 #include <filters/SplitterFilter.hpp>
@@ -46,6 +50,34 @@ class PDAL_DLL TileKernel : public Kernel
 {
     using Coord = std::pair<int, int>;
     using Readers = std::map<std::string, Streamable *>;
+    using Buckets = std::map<Coord, std::vector<PointId>>;
+
+    // Output state of a tile.  A tile's writer is open while the tile is
+    // in the list of recently used tiles.  Once the writer has been
+    // closed, points for the tile are appended to a spill file and merged
+    // into the output file at the end.
+    struct Tile
+    {
+        Tile() : m_writer(nullptr), m_closed(false), m_spilled(false)
+        {}
+
+        std::string m_filename;
+        Streamable *m_writer;
+        bool m_closed;
+        bool m_spilled;
+        std::list<Coord>::iterator m_lruPos;
+    };
+
+    // Stages and table used to add spilled points to a tile.
+    struct Merge
+    {
+        Tile *m_tile;
+        Streamable *m_reader;
+        Streamable *m_writer;
+        std::string m_tempFilename;
+        std::unique_ptr<FixedPointTable> m_table;
+        DimTypeList m_dims;
+    };
 
 public:
     TileKernel();
@@ -57,8 +89,17 @@ private:
     void validateSwitches(ProgramArgs& args);
     Streamable *prepareReader(const std::string& filename);
     void process(const Readers& readers);
+    bool processFile(Streamable& r, StreamPointTable& table,
+        Streamable *repro, bool findOrigin);
     void checkReaders(const Readers& readers);
-    void adder(PointRef& point, int xpos, int ypos);
+    void write(Buckets& buckets, StreamPointTable& table);
+    Tile& openTile(const Coord& loc);
+    void closeTile(Tile& tile);
+    void spill(Tile& tile, StreamPointTable& table,
+        const std::vector<PointId>& ids);
+    void mergeTiles();
+    void mergeTile(Merge& merge);
+    std::string spillFilename(const Tile& tile) const;
 
     std::string m_inputFile;
     std::string m_outputFile;
@@ -66,10 +107,15 @@ private:
     double m_xOrigin;
     double m_yOrigin;
     double m_buffer;
-    std::map<Coord, Streamable *> m_writers;
+    size_t m_threads;
+    size_t m_maxWriters;
+    std::map<Coord, Tile> m_tiles;
+    std::list<Coord> m_lru;
+    std::mutex m_mutex;
     FixedPointTable m_table;
     SplitterFilter m_splitter;
     Streamable *m_repro;
+    std::vector<Streamable *> m_repros;
     SpatialReference m_outSrs;
     std::string::size_type m_hashPos;
 };
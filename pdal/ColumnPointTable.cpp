@@ -40,8 +40,8 @@ namespace pdal
 ColumnPointTable::~ColumnPointTable()
 {
     for (DimBlockList& l : m_blocks)
-        for (auto ptr : l)
-            delete [] ptr;
+        for (size_t i = 0; i < l.size(); ++i)
+            delete [] l[i];
 }
 
 
@@ -52,23 +52,56 @@ void ColumnPointTable::finalize()
 }
 
 
+// See RowPointTable::addPoint().
 PointId ColumnPointTable::addPoint()
 {
-    if (m_numPts % m_blockPtCnt == 0)
+    const PointId idx = m_numPts++;
+    const size_t block = idx / m_blockPtCnt;
+    if (block >= m_numBlocks.load(std::memory_order_acquire))
     {
-        for (Dimension::Id id : m_layoutRef.dims())
-        {
-            const Dimension::Detail *detail = m_layoutRef.dimDetail(id);
-
-            // Make a block that holds m_blockPtCnt values of a dimension.
-            size_t size = m_blockPtCnt * Dimension::size(detail->type());
-            char *buf = new char[size];
-            memset(buf, 0, size);
-            DimBlockList& dimBlocks = m_blocks[detail->order()];
-            dimBlocks.push_back(buf);
-        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t b = m_numBlocks; b <= block; ++b)
+            for (Dimension::Id id : m_layoutRef.dims())
+            {
+                const Dimension::Detail *detail = m_layoutRef.dimDetail(id);
+
+                // Make a block that holds m_blockPtCnt values of a dimension.
+                size_t size = m_blockPtCnt * Dimension::size(detail->type());
+                char *buf = new char[size];
+                memset(buf, 0, size);
+                DimBlockList& dimBlocks = m_blocks[detail->order()];
+                dimBlocks.push_back(buf);
+            }
+        if (block >= m_numBlocks)
+            m_numBlocks.store(block + 1, std::memory_order_release);
     }
-    return m_numPts++;
+    return idx;
+}
+
+// Values are moved in order, one dimension at a time.  See
+// RowPointTable::compact().
+void ColumnPointTable::compact(const std::vector<PointId>& live)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t numBlocks = (live.size() + m_blockPtCnt - 1) / m_blockPtCnt;
+    for (Dimension::Id id : m_layoutRef.dims())
+    {
+        const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+        const size_t size = Dimension::size(d->type());
+        DimBlockList& dimBlocks = m_blocks[d->order()];
+        for (PointId i = 0; i < live.size(); ++i)
+            if (live[i] != i)
+                memcpy(getDimension(d, i), getDimension(d, live[i]), size);
+
+        for (size_t i = numBlocks; i < dimBlocks.size(); ++i)
+            delete [] dimBlocks[i];
+        dimBlocks.truncate(numBlocks);
+        if (live.size() % m_blockPtCnt)
+            memset(getDimension(d, live.size()), 0,
+                size * (m_blockPtCnt - live.size() % m_blockPtCnt));
+    }
+    m_numBlocks = numBlocks;
+    m_numPts = live.size();
 }
 
 namespace
@@ -165,5 +198,15 @@ const char *ColumnPointTable::getDimension(const Dimension::Detail *d,
     return ncThis->getDimension(d, idx);
 }
 
+
+// The values of a dimension are contiguous to the end of a block.
+char *ColumnPointTable::getDimensionRun(const Dimension::Detail *d,
+    PointId idx, point_count_t& count, std::size_t& stride)
+{
+    count = m_blockPtCnt - (idx % m_blockPtCnt);
+    stride = Dimension::size(d->type());
+    return getDimension(d, idx);
+}
+
 } // namespace pdal
 
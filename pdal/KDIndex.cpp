@@ -59,6 +59,11 @@ void KD2Index::build()
     m_impl->build();
 }
 
+void KD2Index::build(bool cacheCoords, size_t threads)
+{
+    m_impl->build(cacheCoords, threads);
+}
+
 PointId KD2Index::neighbor(double x, double y) const
 {
     PointIdList ids = neighbors(x, y, 1);
@@ -145,6 +150,36 @@ PointIdList KD2Index::radius(PointRef &point, double const& r) const
     return radius(x, y, r);
 }
 
+void KD2Index::knnSearch(const PointIdList& ids, point_count_t k,
+    std::vector<PointIdList> *indices,
+    std::vector<std::vector<double>> *sqr_dists, size_t threads) const
+{
+    k = (std::min)(m_buf.size(), k);
+    indices->resize(ids.size());
+    sqr_dists->resize(ids.size());
+    kdRunRanges(ids.size(), threads, [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+        {
+            (*indices)[i].resize(k);
+            (*sqr_dists)[i].resize(k);
+            knnSearch(ids[i], k, &(*indices)[i], &(*sqr_dists)[i]);
+        }
+    });
+}
+
+std::vector<PointIdList> KD2Index::radius(const PointIdList& ids, double r,
+    size_t threads) const
+{
+    std::vector<PointIdList> output(ids.size());
+    kdRunRanges(ids.size(), threads, [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+            output[i] = radius(ids[i], r);
+    });
+    return output;
+}
+
 //
 // KD3Index
 //
@@ -168,6 +203,11 @@ void KD3Index::build()
     m_impl->build();
 }
 
+void KD3Index::build(bool cacheCoords, size_t threads)
+{
+    m_impl->build(cacheCoords, threads);
+}
+
 PointId KD3Index::neighbor(double x, double y, double z) const
 {
     PointIdList ids = neighbors(x, y, z, 1);
@@ -261,6 +301,36 @@ PointIdList KD3Index::radius(PointRef &point, double r) const
     return radius(x, y, z, r);
 }
 
+void KD3Index::knnSearch(const PointIdList& ids, point_count_t k,
+    std::vector<PointIdList> *indices,
+    std::vector<std::vector<double>> *sqr_dists, size_t threads) const
+{
+    k = (std::min)(m_buf.size(), k);
+    indices->resize(ids.size());
+    sqr_dists->resize(ids.size());
+    kdRunRanges(ids.size(), threads, [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+        {
+            (*indices)[i].resize(k);
+            (*sqr_dists)[i].resize(k);
+            knnSearch(ids[i], k, &(*indices)[i], &(*sqr_dists)[i]);
+        }
+    });
+}
+
+std::vector<PointIdList> KD3Index::radius(const PointIdList& ids, double r,
+    size_t threads) const
+{
+    std::vector<PointIdList> output(ids.size());
+    kdRunRanges(ids.size(), threads, [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+            output[i] = radius(ids[i], r);
+    });
+    return output;
+}
+
 //
 // KDFlexIndex
 //
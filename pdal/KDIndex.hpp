@@ -50,6 +50,15 @@ public:
     ~KD2Index();
 
     void build();
+    /**
+      Build the index.
+
+      \param cacheCoords  Copy the point coordinates into packed arrays
+        used by the index instead of reading them from the point view on
+        each access.  Faster, but takes additional memory.
+      \param threads  Number of threads used to build the index.
+    */
+    void build(bool cacheCoords, size_t threads = 1);
     PointId neighbor(double x, double y) const;
     PointId neighbor(PointId idx) const;
     PointId neighbor(PointRef &point) const;
@@ -67,6 +76,32 @@ public:
     PointIdList radius(PointId idx, double const& r) const;
     PointIdList radius(PointRef &point, double const& r) const;
 
+    /**
+      Find the nearest neighbors of many points of the indexed point view,
+      using multiple threads.
+
+      \param ids  Ids of the points whose neighbors should be found.
+      \param k  Number of neighbors to find for each point.
+      \param indices  Neighbor ids of each point, in the order of \a ids.
+      \param sqr_dists  Squared distances to the neighbors of each point.
+      \param threads  Number of threads used to run the queries.
+    */
+    void knnSearch(const PointIdList& ids, point_count_t k,
+        std::vector<PointIdList> *indices,
+        std::vector<std::vector<double>> *sqr_dists,
+        size_t threads) const;
+    /**
+      Find the points within a radius of many points of the indexed point
+      view, using multiple threads.
+
+      \param ids  Ids of the points whose neighbors should be found.
+      \param r  Search radius.
+      \param threads  Number of threads used to run the queries.
+      \return  Neighbor ids of each point, in the order of \a ids.
+    */
+    std::vector<PointIdList> radius(const PointIdList& ids, double r,
+        size_t threads) const;
+
 private:
     const PointView& m_buf;
     std::unique_ptr<KD2Impl> m_impl;
@@ -79,6 +114,15 @@ public:
     ~KD3Index();
 
     void build();
+    /**
+      Build the index.
+
+      \param cacheCoords  Copy the point coordinates into packed arrays
+        used by the index instead of reading them from the point view on
+        each access.  Faster, but takes additional memory.
+      \param threads  Number of threads used to build the index.
+    */
+    void build(bool cacheCoords, size_t threads = 1);
     PointId neighbor(double x, double y, double z) const;
     PointId neighbor(PointId idx) const;
     PointId neighbor(PointRef &point) const;
@@ -98,6 +142,32 @@ public:
     PointIdList radius(PointId idx, double r) const;
     PointIdList radius(PointRef &point, double r) const;
 
+    /**
+      Find the nearest neighbors of many points of the indexed point view,
+      using multiple threads.
+
+      \param ids  Ids of the points whose neighbors should be found.
+      \param k  Number of neighbors to find for each point.
+      \param indices  Neighbor ids of each point, in the order of \a ids.
+      \param sqr_dists  Squared distances to the neighbors of each point.
+      \param threads  Number of threads used to run the queries.
+    */
+    void knnSearch(const PointIdList& ids, point_count_t k,
+        std::vector<PointIdList> *indices,
+        std::vector<std::vector<double>> *sqr_dists,
+        size_t threads) const;
+    /**
+      Find the points within a radius of many points of the indexed point
+      view, using multiple threads.
+
+      \param ids  Ids of the points whose neighbors should be found.
+      \param r  Search radius.
+      \param threads  Number of threads used to run the queries.
+      \return  Neighbor ids of each point, in the order of \a ids.
+    */
+    std::vector<PointIdList> radius(const PointIdList& ids, double r,
+        size_t threads) const;
+
 private:
     const PointView& m_buf;
     std::unique_ptr<KD3Impl> m_impl;
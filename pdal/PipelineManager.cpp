@@ -35,6 +35,7 @@
 #include <pdal/PipelineManager.hpp>
 #include <pdal/Reader.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/Streamable.hpp>
 #include <pdal/PipelineReaderJSON.hpp>
 #include <pdal/PDALUtils.hpp>
 #include <pdal/util/Algorithm.hpp>
@@ -47,10 +48,11 @@ namespace pdal
 
 PipelineManager::PipelineManager(point_count_t streamLimit) :
     m_factory(new StageFactory),
-    m_tablePtr(new ColumnPointTable()), m_table(*m_tablePtr),
+    m_tablePtr(new ColumnPointTable()),
     m_streamTablePtr(new FixedPointTable(streamLimit)),
     m_streamTable(*m_streamTablePtr),
-    m_progressFd(-1), m_input(nullptr)
+    m_progressFd(-1), m_streamBuffers(0), m_threads(1),
+    m_compact(false), m_input(nullptr)
 {}
 
 
@@ -60,6 +62,16 @@ PipelineManager::~PipelineManager()
 }
 
 
+void PipelineManager::setMemoryLimit(size_t memoryLimit,
+    const std::string& tempDir)
+{
+    if (memoryLimit)
+        m_tablePtr.reset(new PagedPointTable(memoryLimit, tempDir));
+    else
+        m_tablePtr.reset(new ColumnPointTable());
+}
+
+
 void PipelineManager::readPipeline(std::istream& input)
 {
     std::istreambuf_iterator<char> eos;
@@ -217,7 +229,7 @@ void PipelineManager::prepare() const
     validateStageOptions();
     Stage *s = getStage();
     if (s)
-       s->prepare(m_table);
+       s->prepare(*m_tablePtr);
 }
 
 
@@ -252,7 +264,7 @@ PipelineManager::ExecResult PipelineManager::execute(ExecMode mode)
             goto next;
         }
         // We can stream.
-        s->execute(m_streamTable);
+        executeStream(*s, m_streamTable);
         result.m_mode = ExecMode::Stream;
         return result;
     }
@@ -263,14 +275,18 @@ PipelineManager::ExecResult PipelineManager::execute(ExecMode mode)
         if (s->pipelineStreamable())
         {
             s->prepare(m_streamTable);
-            s->execute(m_streamTable);
+            executeStream(*s, m_streamTable);
             result.m_mode = ExecMode::Stream;
         }
     }
     else if (mode == ExecMode::Standard)
     {
-        s->prepare(m_table);
-        m_viewSet = s->execute(m_table);
+        s->prepare(*m_tablePtr);
+        m_tablePtr->setAutoCompact(m_compact);
+        if (m_threads > 1)
+            m_viewSet = s->executeConcurrent(*m_tablePtr, m_threads);
+        else
+            m_viewSet = s->execute(*m_tablePtr);
         point_count_t cnt = 0;
         for (auto pi = m_viewSet.begin(); pi != m_viewSet.end(); ++pi)
         {
@@ -297,7 +313,17 @@ void PipelineManager::executeStream(StreamPointTable& table)
         return;
 
     s->prepare(table);
-    s->execute(table);
+    executeStream(*s, table);
+}
+
+
+void PipelineManager::executeStream(Stage& stage, StreamPointTable& table)
+{
+    Streamable *s = dynamic_cast<Streamable *>(&stage);
+    if (s && m_streamBuffers)
+        s->executePipelined(table, m_streamBuffers);
+    else
+        stage.execute(table);
 }
 
 
@@ -80,6 +80,29 @@ public:
     void setProgressFd(int fd)
         { m_progressFd = fd; }
 
+    // Set the number of point buffers used to overlap the execution of
+    // stages in stream mode.  Zero (the default) runs stages serially.
+    void setStreamBuffers(size_t numBuffers)
+        { m_streamBuffers = numBuffers; }
+
+    // Set the number of threads used to run independent stages and point
+    // views concurrently in standard mode.  One (the default) runs stages
+    // serially.
+    void setThreads(size_t threads)
+        { m_threads = threads; }
+
+    // Hold the points of standard mode in a table that is paged to a
+    // scratch file in 'tempDir', keeping about 'memoryLimit' bytes of
+    // points in memory.  Zero (the default) holds all points in memory.
+    // Must be called before the pipeline is prepared.
+    void setMemoryLimit(size_t memoryLimit, const std::string& tempDir = "");
+
+    // Release the storage of points that are dropped by stages in standard
+    // mode by compacting the point table between stages.  Views of the
+    // table held outside of the pipeline become invalid.
+    void setCompact(bool compact)
+        { m_compact = compact; }
+
     void readPipeline(std::istream& input);
     void readPipeline(const std::string& filename);
 
@@ -138,7 +161,7 @@ public:
 
     // Get the point table data.
     PointTableRef pointTable() const
-        { return m_table; }
+        { return *m_tablePtr; }
 
     MetadataNode getMetadata() const;
     Options& commonOptions()
@@ -156,10 +179,10 @@ public:
 private:
     void setOptions(Stage& stage, const Options& addOps);
     Options stageOptions(Stage& stage);
+    void executeStream(Stage& stage, StreamPointTable& table);
 
     std::unique_ptr<StageFactory> m_factory;
     std::unique_ptr<SimplePointTable> m_tablePtr;
-    PointTableRef m_table;
     std::unique_ptr<FixedPointTable> m_streamTablePtr;
     StreamPointTable& m_streamTable;
     Options m_commonOptions;
@@ -167,6 +190,9 @@ private:
     PointViewSet m_viewSet;
     std::vector<Stage*> m_stages; // stage observer, never owner
     int m_progressFd;
+    size_t m_streamBuffers;
+    size_t m_threads;
+    bool m_compact;
     std::istream *m_input;
     LogPtr m_log;
 
@@ -32,14 +32,24 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <limits>
+
 #include <pdal/ArtifactManager.hpp>
 #include <pdal/PointTable.hpp>
+#include <pdal/util/Utils.hpp>
 
 namespace pdal
 {
 
 BasePointTable::BasePointTable(PointLayout& layout) :
-    m_metadata(new Metadata()), m_layoutRef(layout)
+    m_metadata(new Metadata()), m_layoutRef(layout), m_autoCompact(false)
 {}
 
 
@@ -101,20 +111,53 @@ void SimplePointTable::getFieldInternal(Dimension::Id id, PointId idx,
 
 RowPointTable::~RowPointTable()
 {
-    for (auto vi = m_blocks.begin(); vi != m_blocks.end(); ++vi)
-        delete [] *vi;
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+        delete [] m_blocks[i];
 }
 
+// Points may be added from many threads.  A thread that takes a point in
+// a block that hasn't been added yet adds it (or waits for it) with the
+// table locked.
 PointId RowPointTable::addPoint()
 {
-    if (m_numPts % m_blockPtCnt == 0)
+    const PointId id = m_numPts++;
+    const size_t block = id / m_blockPtCnt;
+    if (block >= m_numBlocks.load(std::memory_order_acquire))
     {
-        size_t size = pointsToBytes(m_blockPtCnt);
-        char *buf = new char[size];
-        memset(buf, 0, size);
-        m_blocks.push_back(buf);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_blocks.size() <= block)
+        {
+            size_t size = pointsToBytes(m_blockPtCnt);
+            char *buf = new char[size];
+            memset(buf, 0, size);
+            m_blocks.push_back(buf);
+        }
+        m_numBlocks.store(m_blocks.size(), std::memory_order_release);
     }
-    return m_numPts++;
+    return id;
+}
+
+
+// Live points only move toward the start of the table, so they can be
+// moved in order.  Points past the live points in the last block are
+// cleared, as added points are expected to be zeroed.
+void RowPointTable::compact(const std::vector<PointId>& live)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t pointSize = pointsToBytes(1);
+    for (PointId i = 0; i < live.size(); ++i)
+        if (live[i] != i)
+            memcpy(getPoint(i), getPoint(live[i]), pointSize);
+
+    size_t numBlocks = (live.size() + m_blockPtCnt - 1) / m_blockPtCnt;
+    for (size_t i = numBlocks; i < m_blocks.size(); ++i)
+        delete [] m_blocks[i];
+    m_blocks.truncate(numBlocks);
+    m_numBlocks = numBlocks;
+    m_numPts = live.size();
+    if (m_numPts % m_blockPtCnt)
+        memset(getPoint(m_numPts), 0,
+            pointsToBytes(m_blockPtCnt - m_numPts % m_blockPtCnt));
 }
 
 
@@ -125,6 +168,220 @@ char *RowPointTable::getPoint(PointId idx)
 }
 
 
+// Points are stored in blocks, so a run ends at the end of a block.
+char *RowPointTable::getDimensionRun(const Dimension::Detail *d, PointId idx,
+    point_count_t& count, std::size_t& stride)
+{
+    char *p = getPoint(idx);
+    count = m_blockPtCnt - (idx % m_blockPtCnt);
+    stride = pointsToBytes(1);
+    return p ? p + d->offset() : nullptr;
+}
+
+
+PagedPointTable::PagedPointTable(size_t memoryLimit,
+        const std::string& tempDir) :
+    SimplePointTable(m_layout), m_numPts(0), m_numBlocks(0),
+    m_tempDir(tempDir), m_fd(-1),
+    m_blockBytes(0), m_maxBlocks(0), m_memoryLimit(memoryLimit),
+    m_lastBlock((std::numeric_limits<size_t>::max)())
+{}
+
+
+PagedPointTable::~PagedPointTable()
+{
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+#ifndef _WIN32
+        ::munmap(m_blocks[i], m_blockBytes);
+#else
+        delete [] m_blocks[i];
+#endif
+    }
+#ifndef _WIN32
+    if (m_fd != -1)
+        ::close(m_fd);
+#endif
+}
+
+
+size_t PagedPointTable::residentBlocks() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+
+// Blocks are mapped at page-aligned offsets of the scratch file.  The
+// number of blocks that can be resident is fixed here, once the size of
+// a point is known.
+void PagedPointTable::createFile()
+{
+#ifndef _WIN32
+    std::string dir(m_tempDir);
+    if (dir.empty())
+        Utils::getenv("TMPDIR", dir);
+    if (dir.empty())
+        dir = "/tmp";
+    std::string name(dir + "/pdal-table-XXXXXX");
+    std::vector<char> buf(name.begin(), name.end());
+    buf.push_back(0);
+    m_fd = ::mkstemp(buf.data());
+    if (m_fd == -1)
+        throw pdal_error("Unable to create temporary file in '" + dir +
+            "' for point storage.");
+    ::unlink(buf.data());
+
+    size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+    m_blockBytes = pointsToBytes(m_blockPtCnt);
+    m_blockBytes = ((m_blockBytes + pageSize - 1) / pageSize) * pageSize;
+#else
+    m_blockBytes = pointsToBytes(m_blockPtCnt);
+#endif
+    m_maxBlocks = (std::max)(m_memoryLimit / m_blockBytes, (size_t)2);
+}
+
+
+char *PagedPointTable::mapBlock(size_t block)
+{
+    if (m_blockBytes == 0)
+        createFile();
+#ifndef _WIN32
+    // Growing the file zero-fills the new block.
+    off_t offset = (off_t)block * (off_t)m_blockBytes;
+    if (::ftruncate(m_fd, offset + (off_t)m_blockBytes) != 0)
+        throw pdal_error("Unable to grow temporary point storage file.");
+    void *addr = ::mmap(nullptr, m_blockBytes, PROT_READ | PROT_WRITE,
+        MAP_SHARED, m_fd, offset);
+    if (addr == MAP_FAILED)
+        throw pdal_error("Unable to map temporary point storage file.");
+    return (char *)addr;
+#else
+    // Windows: blocks are held in memory.
+    char *buf = new char[m_blockBytes];
+    memset(buf, 0, m_blockBytes);
+    return buf;
+#endif
+}
+
+
+// See RowPointTable::addPoint().
+PointId PagedPointTable::addPoint()
+{
+    const PointId id = m_numPts++;
+    const size_t block = id / m_blockPtCnt;
+    if (block >= m_numBlocks.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_blocks.size() <= block)
+        {
+            m_blocks.push_back(mapBlock(m_blocks.size()));
+            m_resident.push_back(false);
+            m_lruPos.push_back(m_lru.end());
+        }
+        m_numBlocks.store(m_blocks.size(), std::memory_order_release);
+    }
+    return id;
+}
+
+
+// Move a block to the front of the list of recently used blocks, releasing
+// the least recently used blocks when there are too many.
+void PagedPointTable::touch(size_t block)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_resident[block])
+        m_lru.splice(m_lru.begin(), m_lru, m_lruPos[block]);
+    else
+    {
+#ifndef _WIN32
+        if (block == m_lastBlock + 1 && block + 1 < m_blocks.size())
+            ::madvise(m_blocks[block + 1], m_blockBytes, MADV_WILLNEED);
+#endif
+        m_lruPos[block] = m_lru.insert(m_lru.begin(), block);
+        m_resident[block] = true;
+        while (m_lru.size() > m_maxBlocks)
+            release(m_lru.back());
+    }
+    m_lastBlock = block;
+}
+
+
+// The mapping is shared, so dropping the pages of a block doesn't lose
+// data: modified pages are written to the file and are read back on the
+// next access.  Pointers to the block remain valid.
+void PagedPointTable::release(size_t block)
+{
+#ifndef _WIN32
+    char *addr = m_blocks[block];
+    off_t offset = (off_t)block * (off_t)m_blockBytes;
+    ::msync(addr, m_blockBytes, MS_ASYNC);
+    ::madvise(addr, m_blockBytes, MADV_DONTNEED);
+    ::posix_fadvise(m_fd, offset, (off_t)m_blockBytes, POSIX_FADV_DONTNEED);
+#endif
+    m_lru.erase(m_lruPos[block]);
+    m_lruPos[block] = m_lru.end();
+    m_resident[block] = false;
+}
+
+
+// As with RowPointTable, points are moved in order.  Dropped blocks are
+// unmapped and the scratch file is shrunk.
+void PagedPointTable::compact(const std::vector<PointId>& live)
+{
+    const size_t pointSize = pointsToBytes(1);
+    for (PointId i = 0; i < live.size(); ++i)
+        if (live[i] != i)
+            memcpy(getPoint(i), getPoint(live[i]), pointSize);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t numBlocks = (live.size() + m_blockPtCnt - 1) / m_blockPtCnt;
+    for (size_t i = numBlocks; i < m_blocks.size(); ++i)
+    {
+        if (m_resident[i])
+            release(i);
+#ifndef _WIN32
+        ::munmap(m_blocks[i], m_blockBytes);
+#else
+        delete [] m_blocks[i];
+#endif
+    }
+#ifndef _WIN32
+    if (m_blocks.size() > numBlocks &&
+            ::ftruncate(m_fd, (off_t)numBlocks * (off_t)m_blockBytes) != 0)
+        throw pdal_error("Unable to shrink temporary point storage file.");
+#endif
+    m_blocks.truncate(numBlocks);
+    m_resident.resize(numBlocks);
+    m_lruPos.resize(numBlocks);
+    m_lastBlock = (std::numeric_limits<size_t>::max)();
+    m_numBlocks = numBlocks;
+    m_numPts = live.size();
+    if (m_numPts % m_blockPtCnt)
+        memset(m_blocks[numBlocks - 1] + pointsToBytes(m_numPts % m_blockPtCnt),
+            0, pointsToBytes(m_blockPtCnt - m_numPts % m_blockPtCnt));
+}
+
+
+char *PagedPointTable::getPoint(PointId idx)
+{
+    size_t block = (size_t)(idx / m_blockPtCnt);
+    if (block != m_lastBlock.load(std::memory_order_relaxed))
+        touch(block);
+    return m_blocks[block] + pointsToBytes(idx % m_blockPtCnt);
+}
+
+
+char *PagedPointTable::getDimensionRun(const Dimension::Detail *d,
+    PointId idx, point_count_t& count, std::size_t& stride)
+{
+    char *p = getPoint(idx);
+    count = m_blockPtCnt - (idx % m_blockPtCnt);
+    stride = pointsToBytes(1);
+    return p ? p + d->offset() : nullptr;
+}
+
+
 MetadataNode BasePointTable::toMetadata() const
 {
     return layout()->toMetadata();
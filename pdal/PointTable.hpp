@@ -35,7 +35,12 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include "pdal/SpatialReference.hpp"
@@ -95,11 +100,40 @@ public:
     MetadataNode toMetadata() const;
     ArtifactManager& artifactManager();
 
+    // Compaction operations.  With auto-compaction set, standard mode
+    // compacts the table between stages once the views passed from stage
+    // to stage reference no more than half of the points in the table.
+    // Other views of the table become invalid when it's compacted.
+    void setAutoCompact(bool autoCompact)
+        { m_autoCompact = autoCompact; }
+    bool autoCompact() const
+        { return m_autoCompact; }
+    virtual bool supportsCompaction() const
+        { return false; }
+    // Number of points held in the table's storage.
+    virtual point_count_t storedPoints() const
+        { return 0; }
+    // Move the points with the IDs in 'live', which must be sorted and
+    // unique, to the start of the table so that point live[i] gets ID 'i'.
+    // The storage of the other points is released.
+    virtual void compact(const std::vector<PointId>& live)
+        {}
+
 private:
     // Point data operations.
     virtual PointId addPoint() = 0;
     virtual char *getDimension(const Dimension::Detail *d, PointId idx) = 0;
 
+    // Get the storage of a dimension for a run of points with consecutive
+    // IDs starting at 'idx'.  'count' is set to the number of points in the
+    // run and 'stride' to the distance in bytes from one value to the next.
+    // Returns nullptr if values can only be accessed through
+    // getFieldInternal().  Tables that override getFieldInternal() must
+    // override this as well.
+    virtual char *getDimensionRun(const Dimension::Detail *d, PointId idx,
+            point_count_t& count, std::size_t& stride)
+        { return nullptr; }
+
 protected:
     virtual char *getPoint(PointId idx) = 0;
 
@@ -108,6 +142,7 @@ protected:
     std::list<SpatialReference> m_spatialRefs;
     PointLayout& m_layoutRef;
     std::unique_ptr<ArtifactManager> m_artifactManager;
+    bool m_autoCompact;
 };
 typedef BasePointTable& PointTableRef;
 typedef BasePointTable const & ConstPointTableRef;
@@ -137,29 +172,83 @@ private:
         SimplePointTable *ncThis = const_cast<SimplePointTable *>(this);
         return ncThis->getPoint(idx) + d->offset();
     }
+
+protected:
+    virtual char *getDimensionRun(const Dimension::Detail *d, PointId idx,
+        point_count_t& count, std::size_t& stride)
+    {
+        char *p = getPoint(idx);
+        count = 1;
+        stride = m_layoutRef.pointSize();
+        return p ? p + d->offset() : nullptr;
+    }
+};
+
+// List of point storage blocks.  Unlike a vector, existing entries never
+// move when a block is added, so blocks can be looked up from one thread
+// while another thread adds a block (with the table locked).
+class PDAL_DLL PointBlockList
+{
+public:
+    PointBlockList() : m_size(0)
+        {}
+
+    char *operator[](size_t i) const
+        { return m_pages[i / PageSize][i % PageSize]; }
+    size_t size() const
+        { return m_size; }
+    void push_back(char *block)
+    {
+        std::unique_ptr<char *[]>& page = m_pages.at(m_size / PageSize);
+        if (!page)
+            page.reset(new char *[PageSize]);
+        page[m_size % PageSize] = block;
+        m_size++;
+    }
+    // Drop the entries past 'size'.  The blocks aren't freed.
+    void truncate(size_t size)
+        { m_size = (std::min)(size, m_size); }
+
+private:
+    static const size_t PageSize = 1024;
+    static const size_t NumPages = 1024;
+
+    std::array<std::unique_ptr<char *[]>, NumPages> m_pages;
+    size_t m_size;
 };
 
 // This provides a context for processing a set of points and allows the library
 // to be used to process multiple point sets simultaneously.
+// Points may be added to the table from multiple threads.
 class PDAL_DLL RowPointTable : public SimplePointTable
 {
 private:
-    // Point storage.
-    std::vector<char *> m_blocks;
-    point_count_t m_numPts;
+    // Point storage.  The number of points and blocks are atomic so that
+    // the table only needs to be locked when a block is added.
+    PointBlockList m_blocks;
+    std::atomic<point_count_t> m_numPts;
+    std::atomic<size_t> m_numBlocks;
+    std::mutex m_mutex;
 
     // Make sure this is power-of-2 to facilitate fast div and mod ops.
     static const point_count_t m_blockPtCnt = 65536;
 
 public:
-    RowPointTable() : SimplePointTable(m_layout), m_numPts(0)
+    RowPointTable() : SimplePointTable(m_layout), m_numPts(0), m_numBlocks(0)
         {}
     virtual ~RowPointTable();
     virtual bool supportsView() const
         { return true; }
+    virtual bool supportsCompaction() const
+        { return true; }
+    virtual point_count_t storedPoints() const
+        { return m_numPts; }
+    virtual void compact(const std::vector<PointId>& live);
 
 protected:
     virtual char *getPoint(PointId idx);
+    virtual char *getDimensionRun(const Dimension::Detail *d, PointId idx,
+        point_count_t& count, std::size_t& stride);
 
 private:
     // Point data operations.
@@ -169,28 +258,102 @@ private:
 };
 using PointTable = RowPointTable;
 
+// A row-oriented point table whose storage is paged to a scratch file so
+// that point sets larger than memory can be processed in standard mode.
+// Each block of points is mapped from the file and its address never
+// changes.  Up to 'memoryLimit' bytes of the most recently used blocks are
+// kept resident.  Other blocks are written back and released from memory,
+// to be read from the file again when next accessed.  When blocks are
+// accessed in order, the block following the current block is prefetched.
+// The scratch file is removed when it's created, so it never outlives the
+// table.  Points may be added to the table from multiple threads.
+class PDAL_DLL PagedPointTable : public SimplePointTable
+{
+public:
+    // 'memoryLimit' is in bytes.  The scratch file is created in 'tempDir',
+    // or in the system temporary directory if it's empty.
+    PagedPointTable(size_t memoryLimit, const std::string& tempDir = "");
+    virtual ~PagedPointTable();
+    virtual bool supportsView() const
+        { return true; }
+    virtual bool supportsCompaction() const
+        { return true; }
+    virtual point_count_t storedPoints() const
+        { return m_numPts; }
+    virtual void compact(const std::vector<PointId>& live);
+
+    // Number of blocks currently held in memory.
+    size_t residentBlocks() const;
+
+protected:
+    virtual char *getPoint(PointId idx);
+    virtual char *getDimensionRun(const Dimension::Detail *d, PointId idx,
+        point_count_t& count, std::size_t& stride);
+
+private:
+    // Point data operations.
+    virtual PointId addPoint();
+
+    void createFile();
+    char *mapBlock(size_t block);
+    void touch(size_t block);
+    void release(size_t block);
+
+    // Point storage.  See RowPointTable.
+    PointBlockList m_blocks;
+    std::atomic<point_count_t> m_numPts;
+    std::atomic<size_t> m_numBlocks;
+    mutable std::mutex m_mutex;
+    std::string m_tempDir;
+    int m_fd;
+    size_t m_blockBytes;
+    size_t m_maxBlocks;
+    size_t m_memoryLimit;
+
+    // Most recently used blocks, most recent first, and the position of
+    // each resident block in the list.
+    std::list<size_t> m_lru;
+    std::vector<std::list<size_t>::iterator> m_lruPos;
+    std::vector<bool> m_resident;
+    std::atomic<size_t> m_lastBlock;
+
+    // Make sure this is power-of-2 to facilitate fast div and mod ops.
+    static const point_count_t m_blockPtCnt = 65536;
+
+    PointLayout m_layout;
+};
+
 // This provides a context for processing a set of points and allows the library
 // to be used to process multiple point sets simultaneously.
+// Points may be added to the table from multiple threads.
 class PDAL_DLL ColumnPointTable : public SimplePointTable
 {
 private:
     // Point storage.
-    using DimBlockList = std::vector<char *>;
+    using DimBlockList = PointBlockList;
     using MemBlocks = std::vector<DimBlockList>;
 
-    // List of dimension memory block lists.
+    // List of dimension memory block lists.  See RowPointTable.
     MemBlocks m_blocks;
-    point_count_t m_numPts;
+    std::atomic<point_count_t> m_numPts;
+    std::atomic<size_t> m_numBlocks;
+    std::mutex m_mutex;
 
     // Make sure this is power-of-2 to facilitate fast div and mod ops.
     static const point_count_t m_blockPtCnt = 16384;
 
 public:
-    ColumnPointTable() : SimplePointTable(m_layout), m_numPts(0)
+    ColumnPointTable() : SimplePointTable(m_layout), m_numPts(0),
+        m_numBlocks(0)
         {}
     virtual ~ColumnPointTable();
     virtual bool supportsView() const
         { return true; }
+    virtual bool supportsCompaction() const
+        { return true; }
+    virtual point_count_t storedPoints() const
+        { return m_numPts; }
+    virtual void compact(const std::vector<PointId>& live);
     virtual void finalize();
     virtual char *getPoint(PointId idx)
         { return nullptr; }
@@ -206,6 +369,8 @@ private:
     // Hide base class calls for now.
     const char *getDimension(const Dimension::Detail *d, PointId idx) const;
     char *getDimension(const Dimension::Detail *d, PointId idx);
+    virtual char *getDimensionRun(const Dimension::Detail *d, PointId idx,
+        point_count_t& count, std::size_t& stride);
 
     PointLayout m_layout;
 };
@@ -43,7 +43,7 @@
 namespace pdal
 {
 
-int PointView::m_lastId = 0;
+std::atomic<int> PointView::m_lastId(0);
 
 PointView::PointView(PointTableRef pointTable) : m_pointTable(pointTable),
     m_layout(pointTable.layout()), m_size(0), m_id(0)
@@ -215,6 +215,12 @@ void PointView::invalidateProducts()
 
 
 KD3Index& PointView::build3dIndex()
+{
+    return build3dIndex(false, 1);
+}
+
+
+KD3Index& PointView::build3dIndex(bool cacheCoords, size_t threads)
 {
     //ABELL
     // Should we allow a force of point view build - perhaps the index has
@@ -222,13 +228,19 @@ KD3Index& PointView::build3dIndex()
     if (!m_index3)
     {
         m_index3.reset(new KD3Index(*this));
-        m_index3->build();
+        m_index3->build(cacheCoords, threads);
     }
     return *m_index3.get();
 }
 
 
 KD2Index& PointView::build2dIndex()
+{
+    return build2dIndex(false, 1);
+}
+
+
+KD2Index& PointView::build2dIndex(bool cacheCoords, size_t threads)
 {
     //ABELL
     // Should we allow a force of point view build - perhaps the index has
@@ -236,7 +248,7 @@ KD2Index& PointView::build2dIndex()
     if (!m_index2)
     {
         m_index2.reset(new KD2Index(*this));
-        m_index2->build();
+        m_index2->build(cacheCoords, threads);
     }
     return *m_index2.get();
 }
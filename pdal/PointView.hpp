@@ -42,10 +42,13 @@
 #include <pdal/PointTable.hpp>
 #include <pdal/PointRef.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <set>
 #include <deque>
+#include <type_traits>
 
 //#pragma warning(disable: 4244)  // conversion from 'type1' to 'type2', possible loss of data
 
@@ -132,6 +135,30 @@ public:
     inline void setField(Dimension::Id dim, Dimension::Type type,
         PointId idx, const void *val);
 
+    /// Copy the values of a dimension for the points [begin, begin + count)
+    /// to 'out', converted to T.  The result is the same as calling
+    /// getFieldAs() for each point, but the dimension type is looked up once
+    /// and values are copied in runs straight from the point table storage.
+    template<typename T>
+    void getFieldsAs(Dimension::Id dim, PointId begin, point_count_t count,
+        T *out) const;
+
+    /// Set the values of a dimension for the points [begin, begin + count)
+    /// from 'in', converted to the dimension type.  As with setField(),
+    /// points past the end of the view are added.
+    template<typename T>
+    void setFields(Dimension::Id dim, PointId begin, point_count_t count,
+        const T *in);
+
+    /// Get a pointer to the stored values of a dimension for the points
+    /// starting at 'begin', without copying.  This is possible when the
+    /// dimension is stored as T and the values of consecutive points are
+    /// contiguous, as in a ColumnPointTable.  On success, 'count' is reduced
+    /// to the number of values that can be accessed through the pointer.
+    /// Otherwise nullptr is returned and getFieldsAs() should be used.
+    template<typename T>
+    T *fieldData(Dimension::Id dim, PointId begin, point_count_t& count);
+
     template <typename T>
     bool compare(Dimension::Id dim, PointId id1, PointId id2) const
     {
@@ -311,6 +338,15 @@ public:
 
     KD3Index& build3dIndex();
     KD2Index& build2dIndex();
+    /**
+      Build a spatial index, if one hasn't already been built.
+
+      \param cacheCoords  Have the index keep a packed copy of the point
+        coordinates (see KD3Index::build()).
+      \param threads  Number of threads used to build the index.
+    */
+    KD3Index& build3dIndex(bool cacheCoords, size_t threads);
+    KD2Index& build2dIndex(bool cacheCoords, size_t threads);
 
 protected:
     PointTableRef m_pointTable;
@@ -328,7 +364,7 @@ protected:
     std::unique_ptr<KD2Index> m_index2;
 
 private:
-    static int m_lastId;
+    static std::atomic<int> m_lastId;
 
     PointId tableId(PointId idx);
 
@@ -350,6 +386,14 @@ private:
 
     template<class T>
     T getFieldInternal(Dimension::Id dim, PointId pointIndex) const;
+    inline char *fieldRun(const Dimension::Detail *dd, PointId idx,
+        point_count_t& count, std::size_t& stride) const;
+    template<typename S, typename T>
+    void getFieldRuns(const Dimension::Detail *dd, PointId idx,
+        point_count_t count, T *out) const;
+    template<typename S, typename T>
+    void setFieldRuns(const Dimension::Detail *dd, PointId idx,
+        point_count_t count, const T *in);
     inline PointId getTemp(PointId id);
     void freeTemp(PointId id)
         { m_temps.push(id); }
@@ -596,6 +640,315 @@ void PointView::setField(Dimension::Id dim, PointId idx, T val)
     }
 }
 
+namespace detail
+{
+
+// Conversions that numericCast() doesn't range check can be done in
+// simple loops that the compiler is able to vectorize.
+template<typename S, typename T>
+struct UncheckedCast
+{
+    static const bool value = std::is_same<S, T>::value ||
+        std::is_same<T, double>::value;
+};
+
+template<typename T>
+bool storedAs(Dimension::Type type)
+{
+    switch (type)
+    {
+    case Dimension::Type::Float:
+        return std::is_same<T, float>::value;
+    case Dimension::Type::Double:
+        return std::is_same<T, double>::value;
+    case Dimension::Type::Signed8:
+        return std::is_same<T, int8_t>::value;
+    case Dimension::Type::Signed16:
+        return std::is_same<T, int16_t>::value;
+    case Dimension::Type::Signed32:
+        return std::is_same<T, int32_t>::value;
+    case Dimension::Type::Signed64:
+        return std::is_same<T, int64_t>::value;
+    case Dimension::Type::Unsigned8:
+        return std::is_same<T, uint8_t>::value;
+    case Dimension::Type::Unsigned16:
+        return std::is_same<T, uint16_t>::value;
+    case Dimension::Type::Unsigned32:
+        return std::is_same<T, uint32_t>::value;
+    case Dimension::Type::Unsigned64:
+        return std::is_same<T, uint64_t>::value;
+    default:
+        return false;
+    }
+}
+
+// Convert 'count' values of type S, 'stride' bytes apart, to T.
+template<typename S, typename T>
+void readRun(Dimension::Id dim, const char *pos, std::size_t stride,
+    point_count_t count, T *out)
+{
+    S s;
+    if (UncheckedCast<S, T>::value)
+    {
+        // Separate loop for a constant stride so that it can be vectorized.
+        if (stride == sizeof(S))
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                memcpy(&s, pos + i * sizeof(S), sizeof(S));
+                out[i] = static_cast<T>(s);
+            }
+        else
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                memcpy(&s, pos + i * stride, sizeof(S));
+                out[i] = static_cast<T>(s);
+            }
+        return;
+    }
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        memcpy(&s, pos + i * stride, sizeof(S));
+        if (!Utils::numericCast(s, out[i]))
+        {
+            std::ostringstream oss;
+            oss << "Unable to fetch data and convert as requested: ";
+            oss << Dimension::name(dim) << ":" << Utils::typeidName<S>() <<
+                "(" << (double)s << ") -> " << Utils::typeidName<T>();
+            throw pdal_error(oss.str());
+        }
+    }
+}
+
+// Convert 'count' values of type T to S, storing them 'stride' bytes apart.
+template<typename S, typename T>
+void writeRun(Dimension::Id dim, const T *in, point_count_t count,
+    char *pos, std::size_t stride)
+{
+    S s;
+    if (UncheckedCast<T, S>::value)
+    {
+        if (stride == sizeof(S))
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                s = static_cast<S>(in[i]);
+                memcpy(pos + i * sizeof(S), &s, sizeof(S));
+            }
+        else
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                s = static_cast<S>(in[i]);
+                memcpy(pos + i * stride, &s, sizeof(S));
+            }
+        return;
+    }
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        if (!Utils::numericCast(in[i], s))
+        {
+            std::ostringstream oss;
+            oss << "Unable to set data and convert as requested: ";
+            oss << Dimension::name(dim) << ":" << Utils::typeidName<T>() <<
+                "(" << (double)in[i] << ") -> " << Utils::typeidName<S>();
+            throw pdal_error(oss.str());
+        }
+        memcpy(pos + i * stride, &s, sizeof(S));
+    }
+}
+
+} // namespace detail
+
+
+// Find the storage for the points of the view starting at 'idx' whose
+// table IDs are consecutive.  'count' is the maximum length of the run
+// on input and the actual length on output.
+inline char *PointView::fieldRun(const Dimension::Detail *dd, PointId idx,
+    point_count_t& count, std::size_t& stride) const
+{
+    PointId rawIdx = m_index[idx];
+    point_count_t avail;
+    char *pos = m_pointTable.getDimensionRun(dd, rawIdx, avail, stride);
+    if (!pos)
+    {
+        count = 1;
+        return nullptr;
+    }
+    count = (std::min)(count, avail);
+    point_count_t n = 1;
+    while (n < count && m_index[idx + n] == rawIdx + n)
+        n++;
+    count = n;
+    return pos;
+}
+
+
+template<typename S, typename T>
+void PointView::getFieldRuns(const Dimension::Detail *dd, PointId idx,
+    point_count_t count, T *out) const
+{
+    while (count)
+    {
+        point_count_t run = count;
+        std::size_t stride;
+        const char *pos = fieldRun(dd, idx, run, stride);
+        if (pos)
+            detail::readRun<S>(dd->id(), pos, stride, run, out);
+        else
+        {
+            S s;
+            m_pointTable.getFieldInternal(dd->id(), m_index[idx], &s);
+            detail::readRun<S>(dd->id(), (const char *)&s, sizeof(S), 1, out);
+        }
+        idx += run;
+        out += run;
+        count -= run;
+    }
+}
+
+
+template<typename S, typename T>
+void PointView::setFieldRuns(const Dimension::Detail *dd, PointId idx,
+    point_count_t count, const T *in)
+{
+    while (count)
+    {
+        point_count_t run = count;
+        std::size_t stride;
+        char *pos = fieldRun(dd, idx, run, stride);
+        if (pos)
+            detail::writeRun<S>(dd->id(), in, run, pos, stride);
+        else
+        {
+            S s;
+            detail::writeRun<S>(dd->id(), in, 1, (char *)&s, sizeof(S));
+            m_pointTable.setFieldInternal(dd->id(), m_index[idx], &s);
+        }
+        idx += run;
+        in += run;
+        count -= run;
+    }
+}
+
+
+template<typename T>
+void PointView::getFieldsAs(Dimension::Id dim, PointId begin,
+    point_count_t count, T *out) const
+{
+    assert(begin + count <= m_size);
+    const Dimension::Detail *dd = m_layout->dimDetail(dim);
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        getFieldRuns<float>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Double:
+        getFieldRuns<double>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed8:
+        getFieldRuns<int8_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed16:
+        getFieldRuns<int16_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed32:
+        getFieldRuns<int32_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed64:
+        getFieldRuns<int64_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned8:
+        getFieldRuns<uint8_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned16:
+        getFieldRuns<uint16_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned32:
+        getFieldRuns<uint32_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned64:
+        getFieldRuns<uint64_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::None:
+    default:
+        std::fill(out, out + count, T(0));
+        break;
+    }
+}
+
+
+template<typename T>
+void PointView::setFields(Dimension::Id dim, PointId begin,
+    point_count_t count, const T *in)
+{
+    const Dimension::Detail *dd = layout()->dimDetail(dim);
+    if (dd->type() == Dimension::Type::None)
+        return;
+    if (begin > size())
+        throw pdal_error("Point index must increment.");
+    while (size() < begin + count)
+    {
+        m_index.push_back(m_pointTable.addPoint());
+        m_size++;
+        assert(m_temps.empty());
+    }
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        setFieldRuns<float>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Double:
+        setFieldRuns<double>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed8:
+        setFieldRuns<int8_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed16:
+        setFieldRuns<int16_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed32:
+        setFieldRuns<int32_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed64:
+        setFieldRuns<int64_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned8:
+        setFieldRuns<uint8_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned16:
+        setFieldRuns<uint16_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned32:
+        setFieldRuns<uint32_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned64:
+        setFieldRuns<uint64_t>(dd, begin, count, in);
+        break;
+    default:
+        break;
+    }
+}
+
+
+template<typename T>
+T *PointView::fieldData(Dimension::Id dim, PointId begin,
+    point_count_t& count)
+{
+    assert(begin + count <= m_size);
+    const Dimension::Detail *dd = m_layout->dimDetail(dim);
+    if (!count || !detail::storedAs<T>(dd->type()))
+        return nullptr;
+
+    std::size_t stride;
+    point_count_t run = count;
+    char *pos = fieldRun(dd, begin, run, stride);
+    if (!pos || stride != sizeof(T))
+        return nullptr;
+    count = run;
+    return reinterpret_cast<T *>(pos);
+}
+
+
 inline void PointView::appendPoint(const PointView& buffer, PointId id)
 {
     // Invalid 'id' is a programmer error.
@@ -38,13 +38,18 @@
 #include <pdal/PDALUtils.hpp>
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 #include <pdal/private/gdal/ErrorHandler.hpp>
 #include "../filters/private/expr/ConditionalExpression.hpp"
 
 #include "private/StageRunner.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace pdal
 {
@@ -65,10 +70,12 @@ void Stage::splitView(const PointViewPtr& view, PointViewPtr& keep, PointViewPtr
     {
         PointView *k = keep.get();
         PointView *s = skip.get();
-        for (PointRef p : *view)
+        std::vector<char> pass;
+        where->eval(*view, 0, view->size(), pass);
+        for (PointId idx = 0; idx < view->size(); ++idx)
         {
-            PointView *active = where->eval(p) ? k : s;
-            active->appendPoint(*view, p.pointId());
+            PointView *active = pass[idx] ? k : s;
+            active->appendPoint(*view, idx);
         }
     }
     else
@@ -177,6 +184,18 @@ void Stage::prepare(PointTableRef table)
 
 
 PointViewSet Stage::execute(PointTableRef table)
+{
+    return executeStages(table, 1);
+}
+
+
+PointViewSet Stage::executeConcurrent(PointTableRef table, size_t threads)
+{
+    return executeStages(table, (std::max)(threads, (size_t)1));
+}
+
+
+PointViewSet Stage::executeStages(PointTableRef table, size_t threads)
 {
     table.finalize();
 
@@ -225,30 +244,203 @@ PointViewSet Stage::execute(PointTableRef table)
     // Go through the stages in order, executing
     PointViewSet outViews;
     std::map<StageInstance, PointViewSet> sets;
+
+    // The views waiting to be passed to stages are the only views of the
+    // table that are still needed.
+    auto compactViews = [this, &table, &sets]()
+    {
+        if (!table.autoCompact() || !table.supportsCompaction())
+            return;
+        std::set<PointView *> views;
+        for (auto& p : sets)
+            for (const PointViewPtr& v : p.second)
+                views.insert(v.get());
+        compact(table, views);
+    };
+    if (threads == 1)
+    {
+        while (stages.size())
+        {
+            StageInstance si = stages.top();
+            stages.pop();
+            PointViewSet& inViews = sets[si];
+            if (inViews.empty())
+                inViews.insert(PointViewPtr(new PointView(table)));
+            outViews = si.m_stage->execute(table, inViews);
+
+            StageInstance child = children[si];
+
+            // If a stage has no child it is the terminal stage.  We're done.
+            if (child.m_stage)
+                sets[child].insert(outViews.begin(), outViews.end());
+            // Allow previous point views to be freed.
+            sets.erase(si);
+            if (child.m_stage)
+                compactViews();
+        }
+        return outViews;
+    }
+
+    // Run the stages in waves.  Each wave holds the stage instances whose
+    // inputs have all completed, in the order that they'd be run serially.
+    // A stage may only appear once in a wave, as a stage can't be run
+    // twice at the same time.  Stages are readied and completed serially
+    // and only the runs of the stages (and their views) are concurrent.
+    // The table holds the spatial references of the views of the running
+    // stage, so the stages of a wave must all have views with the same
+    // spatial references.
+    std::list<StageInstance> waiting;
+    std::map<StageInstance, size_t> numInputs;
     while (stages.size())
     {
         StageInstance si = stages.top();
         stages.pop();
-        PointViewSet& inViews = sets[si];
-        if (inViews.empty())
-            inViews.insert(PointViewPtr(new PointView(table)));
-        outViews = si.m_stage->execute(table, inViews);
-
-        StageInstance child = children[si];
-
-        // If a stage has no child it is the terminal stage.  We're done.
-        if (child.m_stage)
-            sets[child].insert(outViews.begin(), outViews.end());
-        // Allow previous point views to be freed.
-        sets.erase(si);
+        waiting.push_back(si);
+        numInputs[si] = si.m_stage->m_inputs.size();
+    }
+
+    ThreadPool pool(threads);
+    std::mutex errMutex;
+    std::exception_ptr err;
+    // Spatial references put on the table when a stage is started.
+    auto tableSrs = [&sets](const StageInstance& si)
+    {
+        std::vector<SpatialReference> srs;
+        const PointViewSet& views = sets[si];
+        for (auto it = views.rbegin(); it != views.rend(); it++)
+            srs.push_back((*it)->spatialReference());
+        return srs;
+    };
+    while (waiting.size())
+    {
+        std::vector<StageInstance> wave;
+        std::vector<SpatialReference> waveSrs;
+        std::set<Stage *> used;
+        for (auto it = waiting.begin(); it != waiting.end();)
+        {
+            if (numInputs[*it] == 0 && !used.count(it->m_stage))
+            {
+                std::vector<SpatialReference> srs = tableSrs(*it);
+                if (wave.empty())
+                    waveSrs = srs;
+                if (srs == waveSrs)
+                {
+                    used.insert(it->m_stage);
+                    wave.push_back(*it);
+                    it = waiting.erase(it);
+                    continue;
+                }
+            }
+            it++;
+        }
+
+        std::vector<std::vector<StageRunnerPtr>> runners;
+        for (StageInstance& si : wave)
+        {
+            PointViewSet& inViews = sets[si];
+            if (inViews.empty())
+                inViews.insert(PointViewPtr(new PointView(table)));
+            runners.push_back(si.m_stage->startRun(table, inViews));
+            si.m_stage->stopLogging();
+        }
+
+        auto runTask = [&err, &errMutex](std::vector<StageRunnerPtr> rs)
+        {
+            try
+            {
+                for (StageRunnerPtr& r : rs)
+                    r->run();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errMutex);
+                if (!err)
+                    err = std::current_exception();
+            }
+        };
+        for (size_t i = 0; i < wave.size(); ++i)
+        {
+            if (wave[i].m_stage->concurrentViews())
+                for (StageRunnerPtr& r : runners[i])
+                    pool.add(std::bind(runTask,
+                        std::vector<StageRunnerPtr>{ r }));
+            else
+                pool.add(std::bind(runTask, runners[i]));
+        }
+        pool.await();
+        if (err)
+            std::rethrow_exception(err);
+
+        for (size_t i = 0; i < wave.size(); ++i)
+        {
+            StageInstance& si = wave[i];
+            si.m_stage->startLogging();
+            outViews = si.m_stage->finishRun(table, runners[i]);
+
+            StageInstance child = children[si];
+            if (child.m_stage)
+            {
+                sets[child].insert(outViews.begin(), outViews.end());
+                numInputs[child]--;
+            }
+            sets.erase(si);
+        }
+        if (waiting.size())
+            compactViews();
     }
     return outViews;
 }
 
+
+// Rewrite the points referenced by the views densely at the start of the
+// table and point the views at the new locations.  This is only done when
+// the views hold no more than half the points stored in the table.
+void Stage::compact(PointTableRef table, const std::set<PointView *>& views)
+{
+    point_count_t stored = table.storedPoints();
+    point_count_t referenced = 0;
+    for (PointView *v : views)
+        referenced += v->size();
+    if (referenced > stored / 2)
+        return;
+
+    std::vector<PointId> live;
+    live.reserve(referenced);
+    for (PointView *v : views)
+        live.insert(live.end(), v->m_index.begin(),
+            v->m_index.begin() + v->size());
+    std::sort(live.begin(), live.end());
+    live.erase(std::unique(live.begin(), live.end()), live.end());
+
+    table.compact(live);
+    for (PointView *v : views)
+    {
+        v->m_index.resize(v->size());
+        v->clearTemps();
+        for (PointId& id : v->m_index)
+            id = std::lower_bound(live.begin(), live.end(), id) - live.begin();
+    }
+    m_log->get(LogLevel::Debug) << "Compacted point table from " <<
+        stored << " to " << live.size() << " points." << std::endl;
+}
+
+
 PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
 {
+    std::vector<StageRunnerPtr> runners = startRun(table, views);
 
-    PointViewSet outViews;
+    for (StageRunnerPtr r : runners)
+        r->run();
+
+    return finishRun(table, runners);
+}
+
+
+// Ready the stage and split the views into runners.  Logging is started
+// and left on for the run.
+std::vector<StageRunnerPtr> Stage::startRun(PointTableRef table,
+    PointViewSet& views)
+{
     std::vector<StageRunnerPtr> runners;
 
     startLogging();
@@ -259,7 +451,6 @@ PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
     // ABELL - Should we clear the references once the stage run has
     //   completed?  Wondering if that would break something where a
     //   writer wants to check a table's SRS.
-    SpatialReference srs;
     table.clearSpatialReferences();
     // Iterating backwards will ensure that the SRS for the first view is
     // first on the list for table.
@@ -285,13 +476,18 @@ PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
     for (StageRunnerPtr r : runners)
         keeps.insert(r->keeps());
     prerun(keeps);
+    return runners;
+}
 
-    for (StageRunnerPtr r : runners)
-        r->run();
 
-    // As the stages complete (synchronously at this time), propagate the
-    // spatial reference and merge the output views.
-    srs = getSpatialReference();
+PointViewSet Stage::finishRun(PointTableRef table,
+    std::vector<StageRunnerPtr>& runners)
+{
+    PointViewSet outViews;
+
+    // As the stages complete, propagate the spatial reference and merge
+    // the output views.
+    SpatialReference srs = getSpatialReference();
     for (StageRunnerPtr r : runners)
     {
         PointViewSet temp = r->wait();
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <list>
+#include <set>
 
 #include <pdal/Dimension.hpp>
 #include <pdal/DimType.hpp>
@@ -135,6 +136,22 @@ public:
     */
     PointViewSet execute(PointTableRef table);
 
+    /**
+      Execute a prepared pipeline, running independent stages and point
+      views at the same time.
+
+      Stages whose inputs have completed are run together, each stage
+      being set up and completed in the same order as with \ref execute.
+      A stage runs its point views concurrently if it supports doing so.
+      Output point views may be ordered differently than with
+      \ref execute when stages create new point views.
+
+      \param table  Point table being used for stage pipeline.  This must be
+        the same \ref table used in the \ref prepare function.
+      \param threads  Maximum number of stages or point views run at once.
+    */
+    PointViewSet executeConcurrent(PointTableRef table, size_t threads);
+
     virtual void execute(StreamPointTable& table)
     {
         throw pdal_error("Attempting to use stream mode with a non-streamable "
@@ -387,6 +404,12 @@ private:
     void setupLog();
     void handleOptions();
     void countElements(const PointViewSet& views);
+    PointViewSet executeStages(PointTableRef table, size_t threads);
+    void compact(PointTableRef table, const std::set<PointView *>& views);
+    std::vector<std::shared_ptr<StageRunner>> startRun(PointTableRef table,
+        PointViewSet& views);
+    PointViewSet finishRun(PointTableRef table,
+        std::vector<std::shared_ptr<StageRunner>>& runners);
 
     virtual void l_addArgs(ProgramArgs& args);
     virtual void l_initialize(PointTableRef table);
@@ -498,6 +521,16 @@ private:
         return PointViewSet();
     }
 
+    /**
+      Determine whether separate point views may be run through the stage
+      at the same time.  Implement in subclass to return true when \ref run
+      doesn't modify the stage's state.
+
+      \return  Whether point views can be run concurrently.
+    */
+    virtual bool concurrentViews() const
+        { return false; }
+
     /**
       Called after all point views have been processed.  Implement in subclass.
 
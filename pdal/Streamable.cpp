@@ -32,7 +32,12 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iterator>
+#include <mutex>
+#include <thread>
 
 #include <pdal/Streamable.hpp>
 #include <pdal/Filter.hpp>
@@ -55,6 +60,23 @@ bool Streamable::pipelineStreamable() const
 }
 
 
+void Streamable::processBatch(StreamPointTable& table, point_count_t count,
+    const std::vector<char> *pass)
+{
+    PointRef point(table, 0);
+    for (PointId idx = 0; idx < count; idx++)
+    {
+        if (table.skip(idx))
+            continue;
+        if (pass && !(*pass)[idx])
+            continue;
+        point.setPointId(idx);
+        if (!processOne(point))
+            table.setSkip(idx);
+    }
+}
+
+
 const Stage *Streamable::findNonstreamable() const
 {
     const Stage *nonstreamable;
@@ -69,11 +91,123 @@ const Stage *Streamable::findNonstreamable() const
 }
 
 
+namespace
+{
+
+// Point buffer used for pipelined execution.  Shares the layout of the
+// table provided by the caller.
+class RingPointTable : public StreamPointTable
+{
+public:
+    RingPointTable(PointLayout& layout, point_count_t capacity)
+        : StreamPointTable(layout, capacity)
+        , m_buf(pointsToBytes(capacity + 1))
+    {}
+
+protected:
+    virtual void reset()
+        { std::fill(m_buf.begin(), m_buf.end(), 0); }
+
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+
+public:
+    // Copy the first 'count' points and their skip flags to 'dst', which
+    // has the same layout.
+    void copyTo(StreamPointTable& dst, point_count_t count)
+    {
+        const DimTypeList dims = layout()->dimTypes();
+        std::vector<char> buf(layout()->pointSize());
+        PointRef src(*this, 0);
+        PointRef out(dst, 0);
+        for (PointId idx = 0; idx < count; ++idx)
+        {
+            src.setPointId(idx);
+            out.setPointId(idx);
+            src.getPackedData(dims, buf.data());
+            out.setPackedData(dims, buf.data());
+            if (skip(idx))
+                dst.setSkip(idx);
+        }
+    }
+
+private:
+    std::vector<char> m_buf;
+};
+
+// Points read in one pass of the reader, passed from stage to stage.
+struct Batch
+{
+    RingPointTable *table;
+    point_count_t count;
+    SpatialReference srs;
+    bool last;
+};
+
+// Blocking queue of batches between two stages.  Closing the queue
+// releases any waiting thread.
+class BatchQueue
+{
+public:
+    BatchQueue() : m_closed(false)
+    {}
+
+    void push(const Batch& b)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches.push_back(b);
+        m_cv.notify_one();
+    }
+
+    bool pop(Batch& b)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this](){ return m_closed || m_batches.size(); });
+        if (m_closed)
+            return false;
+        b = m_batches.front();
+        m_batches.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Batch> m_batches;
+    bool m_closed;
+};
+
+} // unnamed namespace
+
+
 // Streamed execution.
 void Streamable::execute(StreamPointTable& table)
 {
     m_log->get(LogLevel::Debug) << "Executing pipeline in stream mode." <<
         std::endl;
+    executeStages(table, 0);
+}
+
+
+void Streamable::executePipelined(StreamPointTable& table, size_t numBuffers)
+{
+    m_log->get(LogLevel::Debug) << "Executing pipeline in pipelined "
+        "stream mode." << std::endl;
+    executeStages(table, (std::max)(numBuffers, (size_t)2));
+}
+
+
+// Run each path from a reader to this stage.  A buffer count of zero
+// means that stages are run serially using the provided table.
+void Streamable::executeStages(StreamPointTable& table, size_t numBuffers)
+{
     struct StreamableList : public std::list<Streamable *>
     {
         StreamableList operator - (const StreamableList& other) const
@@ -153,7 +287,10 @@ void Streamable::execute(StreamPointTable& table)
             (lastRunStages - stages).done(table);
             // Call ready on all the stages we didn't run last time.
             (stages - lastRunStages).ready(table);
-            execute(table, stages, srsMap);
+            if (numBuffers)
+                executePipelined(table, stages, srsMap, numBuffers);
+            else
+                execute(table, stages, srsMap);
             lastRunStages = stages;
         }
         else
@@ -200,6 +337,7 @@ void Streamable::execute(StreamPointTable& table,
     // Loop until we're finished.  We handle the number of points up to
     // the capacity of the StreamPointTable that we've been provided.
 
+    std::vector<char> pass;
     bool finished = false;
     while (!finished)
     {
@@ -244,17 +382,11 @@ void Streamable::execute(StreamPointTable& table,
             }
             s->startLogging();
 
+            // Evaluate the where expression for the whole batch up front.
             const expr::ConditionalExpression* where = s->whereExpr();
-            for (PointId idx = 0; idx < pointLimit; idx++)
-            {
-                point.setPointId(idx);
-                if (table.skip(idx))
-                    continue;
-                if (where && !where->eval(point))
-                    continue;
-                if (!s->processOne(point))
-                    table.setSkip(idx);
-            }
+            if (where)
+                where->eval(table, 0, pointLimit, pass);
+            s->processBatch(table, pointLimit, where ? &pass : nullptr);
             const SpatialReference& tempSrs = s->getSpatialReference();
             if (!tempSrs.empty())
             {
@@ -268,5 +400,173 @@ void Streamable::execute(StreamPointTable& table,
     }
 }
 
+
+// Each stage runs in its own thread.  The reader pulls empty buffers from
+// a free queue and each following stage pulls from the queue filled by the
+// stage before it.  The last stage copies each buffer to the caller's
+// table, clears the caller's table and returns the buffer to the free queue.
+// Stages are only run from one thread at a time, but the stage log leader
+// is a stack shared by the stages, so stage logging isn't started for
+// each batch as it is in serial execution.
+void Streamable::executePipelined(StreamPointTable& table,
+    std::list<Streamable *>& stages, SrsMap& srsMap, size_t numBuffers)
+{
+    Streamable *reader = stages.front();
+    std::vector<Streamable *> filters(std::next(stages.begin()),
+        stages.end());
+
+    point_count_t count = (std::numeric_limits<point_count_t>::max)();
+    if (Reader *r = dynamic_cast<Reader *>(reader))
+        count = r->count();
+
+    std::vector<std::unique_ptr<RingPointTable>> buffers;
+    for (size_t i = 0; i < numBuffers; ++i)
+        buffers.emplace_back(
+            new RingPointTable(*table.layout(), table.capacity()));
+
+    // queues[0] holds free buffers.  queues[i] holds buffers ready for
+    // filters[i - 1].
+    std::vector<std::unique_ptr<BatchQueue>> queues;
+    for (size_t i = 0; i <= filters.size(); ++i)
+        queues.emplace_back(new BatchQueue);
+    for (auto& b : buffers)
+        queues[0]->push({ b.get(), 0, SpatialReference(), false });
+
+    std::mutex errMutex;
+    std::exception_ptr err;
+    auto fail = [&]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(errMutex);
+            if (!err)
+                err = std::current_exception();
+        }
+        for (auto& q : queues)
+            q->close();
+    };
+    // Output queue of the stage that fills queues[q - 1].
+    auto output = [&](size_t q) -> BatchQueue&
+        { return q < queues.size() ? *queues[q] : *queues[0]; };
+    // Pass a finished buffer through the caller's table, as serial
+    // execution does, so that its reset() sees the processed points.
+    // Only the thread of the last stage calls this.
+    auto finish = [&](Batch& b)
+    {
+        if (b.count)
+        {
+            b.table->copyTo(table, b.count);
+            if (!b.srs.empty())
+                table.setSpatialReference(b.srs);
+            table.clear(b.count);
+            table.clearSpatialReferences();
+        }
+        b.table->clear(b.count);
+    };
+
+    // Copy the current spatial reference of each filter so that threads
+    // don't modify the shared map.
+    std::vector<std::pair<bool, SpatialReference>> srsList;
+    for (Streamable *s : filters)
+    {
+        auto si = srsMap.find(s);
+        if (si == srsMap.end())
+            srsList.emplace_back(false, SpatialReference());
+        else
+            srsList.emplace_back(true, si->second);
+    }
+
+    auto runFilter = [&](size_t i)
+    {
+        Streamable *s = filters[i];
+        std::pair<bool, SpatialReference>& curSrs = srsList[i];
+        const expr::ConditionalExpression* where = s->whereExpr();
+        std::vector<char> pass;
+        try
+        {
+            Batch b;
+            while (queues[i + 1]->pop(b))
+            {
+                RingPointTable& t = *b.table;
+                if (!curSrs.first || curSrs.second != b.srs)
+                {
+                    s->spatialReferenceChanged(b.srs);
+                    curSrs = { true, b.srs };
+                }
+
+                if (where)
+                    where->eval(t, 0, b.count, pass);
+                s->processBatch(t, b.count, where ? &pass : nullptr);
+                const SpatialReference& tempSrs = s->getSpatialReference();
+                if (!tempSrs.empty())
+                {
+                    b.srs = tempSrs;
+                    t.setSpatialReference(b.srs);
+                }
+                bool last = b.last;
+                if (i + 1 == filters.size())
+                    finish(b);
+                output(i + 2).push(b);
+                if (last)
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < filters.size(); ++i)
+        threads.emplace_back(runFilter, i);
+
+    // The reader runs in the calling thread.
+    try
+    {
+        Batch b;
+        bool finished = false;
+        while (!finished && queues[0]->pop(b))
+        {
+            RingPointTable& t = *b.table;
+            t.clearSpatialReferences();
+            PointRef point(t, 0);
+            point_count_t pointLimit = (std::min)(count, t.capacity());
+
+            if (!pointLimit)
+                finished = true;
+            for (PointId idx = 0; idx < pointLimit; idx++)
+            {
+                point.setPointId(idx);
+                finished = !reader->processOne(point);
+                if (finished)
+                    pointLimit = idx;
+            }
+            count -= pointLimit;
+
+            b.srs = reader->getSpatialReference();
+            if (!b.srs.empty())
+                t.setSpatialReference(b.srs);
+            b.count = pointLimit;
+            b.last = finished;
+            if (filters.empty())
+                finish(b);
+            output(1).push(b);
+        }
+    }
+    catch (...)
+    {
+        fail();
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+    if (err)
+        std::rethrow_exception(err);
+
+    for (size_t i = 0; i < filters.size(); ++i)
+        if (srsList[i].first)
+            srsMap[filters[i]] = srsList[i].second;
+}
+
 } // namespace pdal
 
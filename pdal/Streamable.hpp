@@ -67,6 +67,27 @@ public:
     virtual void execute(StreamPointTable& table);
     using Stage::execute;
 
+    /**
+      Execute a prepared pipeline in streaming mode, overlapping the work
+      of its stages.
+
+      The reader and each subsequent stage run in their own thread.  Points
+      are passed from stage to stage in a ring of point buffers, each with
+      the layout and capacity of the provided table, so that a reader can
+      fill one buffer while filters and writers work on others.  Each stage
+      still sees buffers in order and is only called from one thread at
+      a time.  Once the last stage is done with a buffer, its points and
+      skip flags are copied to the provided table, which is then cleared,
+      so tables that consume points in reset() work as in execute().
+      reset() is called from the thread of the last stage.
+
+      \param table  Streaming point table used for stage pipeline.  This must be
+        the same \ref table used in the \ref prepare function.
+      \param numBuffers  Number of point buffers in the ring.  At least two
+        buffers are always used.
+    */
+    void executePipelined(StreamPointTable& table, size_t numBuffers = 2);
+
     /**
       Determine if a pipeline is streamable.
 
@@ -82,6 +103,8 @@ protected:
 
     void execute(StreamPointTable& table, std::list<Streamable *>& stages,
         SrsMap& srsMap);
+    void executePipelined(StreamPointTable& table,
+        std::list<Streamable *>& stages, SrsMap& srsMap, size_t numBuffers);
 
     /**
       Process a single point (streaming mode).  Implement in subclass.
@@ -99,6 +122,20 @@ protected:
     }
     **/
 
+    /**
+      Process a batch of points (streaming mode).  The default calls
+      \ref processOne for each point in the batch.  Override to handle
+      the points of a batch together.
+
+      \param table  Table holding the batch.  Points marked as skipped
+        in the table aren't processed.  Filters mark points that are
+        filtered-out as skipped.
+      \param count  Number of points in the batch.
+      \param pass  If not null, points whose entry is zero aren't processed.
+    */
+    virtual void processBatch(StreamPointTable& table, point_count_t count,
+        const std::vector<char> *pass);
+
     /**
       Notification that the points that will follow in processing are from
       a spatial reference different than the previous spatial reference.
@@ -115,6 +152,9 @@ protected:
         a pointer to the first found stage that's not streamable.
     */
     const Stage *findNonstreamable() const;
+
+private:
+    void executeStages(StreamPointTable& table, size_t numBuffers);
 };
 
 } // namespace pdal
@@ -40,8 +40,15 @@
 #error "LAZperf version 2+ (supporting LAS version 1.4) not found"
 #endif
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include <lazperf/writers.hpp>
+
 #include <pdal/util/IStream.hpp>
 #include <pdal/util/OStream.hpp>
+#include <pdal/util/ThreadPool.hpp>
 #include <io/LasHeader.hpp>
 #include <pdal/pdal_types.hpp>
 
@@ -62,11 +69,34 @@ namespace pdal
 // handled as part of the compression process itself.
 class LazPerfVlrCompressorImpl
 {
+    // A chunk of points waiting to be (or being) compressed on the pool.
+    struct Chunk
+    {
+        std::vector<char> points;
+        uint32_t count;
+        std::vector<unsigned char> compressed;
+        bool done;
+        std::string error;
+    };
+    using ChunkPtr = std::shared_ptr<Chunk>;
+
 public:
-    LazPerfVlrCompressorImpl(std::ostream& stream, int format, int ebCount) :
+    LazPerfVlrCompressorImpl(std::ostream& stream, int format, int ebCount,
+            uint32_t chunksize = 50000, size_t threads = 1) :
         m_stream(stream), m_outputStream(stream), m_format(format), m_ebCount(ebCount),
-        m_chunksize(50000), m_chunkPointsWritten(0), m_chunkInfoPos(0), m_chunkOffset(0)
-    {}
+        m_pointLen(lazperf::baseCount(format) + ebCount), m_chunksize(chunksize),
+        m_chunkPointsWritten(0), m_chunkInfoPos(0), m_chunkOffset(0), m_started(false)
+    {
+        if (threads > 1)
+            m_pool.reset(new ThreadPool(threads));
+    }
+
+    ~LazPerfVlrCompressorImpl()
+    {
+        // Make sure no task refers to our state after we're gone.
+        if (m_pool)
+            m_pool->stop();
+    }
 
     std::vector<char> vlrData() const
     {
@@ -76,14 +106,16 @@ public:
 
     void compress(const char *inbuf)
     {
+        if (m_pool)
+        {
+            compressParallel(inbuf);
+            return;
+        }
+
         // First time through.
         if (!m_compressor)
         {
-            // Get the position
-            m_chunkInfoPos = m_stream.tellp();
-            // Seek over the chunk info offset value
-            m_stream.seekp(sizeof(uint64_t), std::ios::cur);
-            m_chunkOffset = m_stream.tellp();
+            start();
             resetCompressor();
         }
         else if (m_chunkPointsWritten == m_chunksize)
@@ -97,10 +129,22 @@ public:
 
     void done()
     {
-        // Close and clear the point encoder.
-        m_compressor->done();
+        if (m_pool)
+        {
+            if (!m_started)
+                start();
+            if (m_chunkPointsWritten)
+                queueChunk();
+            while (m_pending.size())
+                writeChunk();
+        }
+        else
+        {
+            // Close and clear the point encoder.
+            m_compressor->done();
 
-        newChunk();
+            newChunk();
+        }
 
         // Save our current position.  Go to the location where we need
         // to write the chunk table offset at the beginning of the point data.
@@ -121,6 +165,16 @@ public:
     }
 
 private:
+    void start()
+    {
+        // Get the position
+        m_chunkInfoPos = m_stream.tellp();
+        // Seek over the chunk info offset value
+        m_stream.seekp(sizeof(uint64_t), std::ios::cur);
+        m_chunkOffset = m_stream.tellp();
+        m_started = true;
+    }
+
     void resetCompressor()
     {
         if (m_compressor)
@@ -136,16 +190,100 @@ private:
         m_chunkPointsWritten = 0;
     }
 
+    void compressParallel(const char *inbuf)
+    {
+        if (!m_started)
+            start();
+        if (m_chunkBuf.empty())
+            m_chunkBuf.reserve((size_t)m_chunksize * m_pointLen);
+        m_chunkBuf.insert(m_chunkBuf.end(), inbuf, inbuf + m_pointLen);
+        if (++m_chunkPointsWritten == m_chunksize)
+            queueChunk();
+    }
+
+    // Hand the buffered points to the pool for compression.
+    void queueChunk()
+    {
+        // Bound the number of chunks held in memory.
+        if (m_pending.size() >= 2 * m_pool->numThreads())
+            writeChunk();
+
+        ChunkPtr chunk(new Chunk);
+        chunk->points.swap(m_chunkBuf);
+        chunk->count = m_chunkPointsWritten;
+        chunk->done = false;
+        m_chunkPointsWritten = 0;
+        m_pending.push_back(chunk);
+
+        int format = m_format;
+        int ebCount = m_ebCount;
+        int pointLen = m_pointLen;
+        m_pool->add([this, chunk, format, ebCount, pointLen]()
+        {
+            try
+            {
+                lazperf::writer::chunk_compressor compressor(format, ebCount);
+                const char *pos = chunk->points.data();
+                for (uint32_t i = 0; i < chunk->count; ++i)
+                {
+                    compressor.compress(pos);
+                    pos += pointLen;
+                }
+                chunk->compressed = compressor.done();
+            }
+            catch (const std::exception& err)
+            {
+                chunk->error = err.what();
+            }
+            chunk->points.clear();
+            chunk->points.shrink_to_fit();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            chunk->done = true;
+            m_doneCv.notify_all();
+        });
+    }
+
+    // Wait for the oldest chunk to finish and write it to the stream.
+    void writeChunk()
+    {
+        ChunkPtr chunk = m_pending.front();
+        m_pending.pop_front();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [&chunk](){ return chunk->done; });
+        lock.unlock();
+
+        if (chunk->error.size())
+        {
+            m_pool->stop();
+            throw pdal_error("Error compressing LAZ chunk: " + chunk->error);
+        }
+
+        m_stream.write(reinterpret_cast<const char *>(chunk->compressed.data()),
+            chunk->compressed.size());
+        m_chunkTable.push_back((uint32_t)chunk->compressed.size());
+        m_chunkOffset = m_stream.tellp();
+    }
+
     std::ostream& m_stream;
     lazperf::OutFileStream m_outputStream;
     lazperf::las_compressor::ptr m_compressor;
     int m_format;
     int m_ebCount;
+    int m_pointLen;
     uint32_t m_chunksize;
     uint32_t m_chunkPointsWritten;
     std::streampos m_chunkInfoPos;
     std::streampos m_chunkOffset;
     std::vector<uint32_t> m_chunkTable;
+    bool m_started;
+
+    std::unique_ptr<ThreadPool> m_pool;
+    std::vector<char> m_chunkBuf;
+    std::deque<ChunkPtr> m_pending;
+    std::mutex m_mutex;
+    std::condition_variable m_doneCv;
 };
 
 
@@ -154,6 +292,12 @@ LazPerfVlrCompressor::LazPerfVlrCompressor(std::ostream& stream, int format, int
 {}
 
 
+LazPerfVlrCompressor::LazPerfVlrCompressor(std::ostream& stream, int format, int ebCount,
+        uint32_t chunksize, size_t threads) :
+    m_impl(new LazPerfVlrCompressorImpl(stream, format, ebCount, chunksize, threads))
+{}
+
+
 LazPerfVlrCompressor::~LazPerfVlrCompressor()
 {}
 
@@ -290,6 +434,22 @@ public:
         return true;
     }
 
+    LazPerfChunkList chunks() const
+    {
+        LazPerfChunkList list;
+
+        // Our chunk table has a leading entry for the start of the first
+        // chunk, so each chunk is described by adjacent pairs of entries.
+        for (size_t i = 1; i < m_chunks.size(); ++i)
+        {
+            const lazperf::chunk& prev = m_chunks[i - 1];
+            const lazperf::chunk& cur = m_chunks[i];
+            list.push_back({ prev.offset, cur.offset - prev.offset,
+                prev.count, cur.count - prev.count });
+        }
+        return list;
+    }
+
 private:
     void resetDecompressor()
     {
@@ -359,5 +519,10 @@ bool LazPerfVlrDecompressor::seek(uint64_t record)
     return m_impl->seek(record);
 }
 
+LazPerfChunkList LazPerfVlrDecompressor::chunks() const
+{
+    return m_impl->chunks();
+}
+
 } // namespace pdal
 
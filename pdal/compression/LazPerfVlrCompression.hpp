@@ -33,6 +33,7 @@
 ****************************************************************************/
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -50,13 +51,17 @@ namespace pdal
 // The compressor uses the schema of the point data in order to compress
 // the point stream.  The schema is also stored in a VLR that isn't
 // handled as part of the compression process itself.
+// When more than one thread is requested, points are buffered until a
+// chunk is full and each chunk is compressed on a thread pool.  Chunks are
+// written to the stream in order, so the output is identical to that of
+// the single-threaded compressor.
 class LazPerfVlrCompressorImpl;
 class LazPerfVlrCompressor
 {
 public:
     LazPerfVlrCompressor(std::ostream& stream, int format, int ebCount);
     LazPerfVlrCompressor(std::ostream& stream, int format, int ebCount,
-        uint32_t chunksize);
+        uint32_t chunksize, size_t threads = 1);
     ~LazPerfVlrCompressor();
 
     std::vector<char> vlrData() const;
@@ -67,6 +72,16 @@ private:
     std::unique_ptr<LazPerfVlrCompressorImpl> m_impl;
 };
 
+// Location of a single compressed chunk in a LAZ file.
+struct LazPerfChunk
+{
+    uint64_t offset;  // Absolute position of the chunk in the file.
+    uint64_t size;    // Size of the compressed chunk in bytes.
+    uint64_t start;   // Index of the first point in the chunk.
+    uint64_t count;   // Number of points in the chunk.
+};
+using LazPerfChunkList = std::vector<LazPerfChunk>;
+
 class LazPerfVlrDecompressorImpl;
 class LazPerfVlrDecompressor
 {
@@ -76,6 +91,8 @@ public:
 
     bool seek(uint64_t record);
     bool decompress(char *outbuf);
+    // Each chunk can be decompressed independently of the others.
+    LazPerfChunkList chunks() const;
 
 private:
     std::unique_ptr<LazPerfVlrDecompressorImpl> m_impl;
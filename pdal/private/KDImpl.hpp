@@ -34,11 +34,100 @@
 
 #pragma once
 
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include <nanoflann/nanoflann.hpp>
 
 namespace pdal
 {
 
+// Call fn(begin, end) for contiguous ranges covering [0, count), one range
+// per thread.  The first exception thrown by a thread is rethrown.
+template <typename FN>
+void kdRunRanges(point_count_t count, size_t threads, FN fn)
+{
+    threads = (std::max)((size_t)1, (std::min)(threads, (size_t)count));
+    if (threads == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    std::exception_ptr err;
+    std::mutex errMutex;
+    std::vector<std::thread> threadList;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        PointId begin = t * count / threads;
+        PointId end = (t + 1) * count / threads;
+        threadList.emplace_back([&fn, &err, &errMutex, begin, end]()
+        {
+            try
+            {
+                fn(begin, end);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errMutex);
+                if (!err)
+                    err = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& t : threadList)
+        t.join();
+    if (err)
+        std::rethrow_exception(err);
+}
+
+// Packed copy of point coordinates.  The values of each dimension are
+// stored contiguously, starting on a cache line boundary.
+class KDCoordCache
+{
+public:
+    KDCoordCache() : m_data(nullptr), m_stride(0)
+    {}
+
+    bool empty() const
+        { return m_data == nullptr; }
+
+    double get(PointId idx, int dim) const
+        { return m_data[dim * m_stride + idx]; }
+
+    void load(const PointView& buf, const Dimension::IdList& dims,
+        size_t threads)
+    {
+        const size_t lineSize = 64;
+        const size_t perLine = lineSize / sizeof(double);
+
+        m_stride = ((buf.size() + perLine - 1) / perLine) * perLine;
+        m_storage.resize(m_stride * dims.size() + perLine);
+        uintptr_t base = reinterpret_cast<uintptr_t>(m_storage.data());
+        base = (base + lineSize - 1) & ~(uintptr_t)(lineSize - 1);
+        m_data = reinterpret_cast<double *>(base);
+
+        kdRunRanges(buf.size(), threads,
+            [this, &buf, &dims](PointId begin, PointId end)
+            {
+                for (size_t d = 0; d < dims.size(); ++d)
+                {
+                    double *out = m_data + d * m_stride;
+                    for (PointId i = begin; i < end; ++i)
+                        out[i] = buf.getFieldAs<double>(dims[d], i);
+                }
+            }
+        );
+    }
+
+private:
+    std::vector<double> m_storage;
+    double *m_data;
+    size_t m_stride;
+};
+
 class KD2Impl
 {
 public:
@@ -53,6 +142,9 @@ public:
 
     double kdtree_get_pt(const PointId idx, int dim) const
     {
+        if (!m_cache.empty())
+            return m_cache.get(idx, dim);
+
         using namespace Dimension;
         std::array<Id, 2> ids { Id::X, Id::Y };
         return m_buf.getFieldAs<double>(ids[dim], idx);
@@ -61,8 +153,17 @@ public:
     double kdtree_distance(const double *p1, const PointId p2_idx,
         size_t /*numDims*/) const
     {
-        double d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, p2_idx);
-        double d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, p2_idx);
+        double d0, d1;
+        if (!m_cache.empty())
+        {
+            d0 = p1[0] - m_cache.get(p2_idx, 0);
+            d1 = p1[1] - m_cache.get(p2_idx, 1);
+        }
+        else
+        {
+            d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, p2_idx);
+            d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, p2_idx);
+        }
 
         return (d0 * d0 + d1 * d1);
     }
@@ -87,6 +188,15 @@ public:
         m_index.buildIndex();
     }
 
+    void build(bool cacheCoords, size_t threads)
+    {
+        if (cacheCoords)
+            m_cache.load(m_buf, { Dimension::Id::X, Dimension::Id::Y },
+                threads);
+        m_index.n_thread_build = (unsigned)(std::max)(threads, (size_t)1);
+        m_index.buildIndex();
+    }
+
     PointIdList neighbors(double x, double y, point_count_t k) const
     {
         k = (std::min)(m_buf.size(), k);
@@ -134,6 +244,7 @@ public:
 
 private:
     const PointView& m_buf;
+    KDCoordCache m_cache;
 
     typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<
         double, KD2Impl, double>, KD2Impl, -1, std::size_t> KDTree;
@@ -164,15 +275,27 @@ public:
             throw pdal_error("kdtree_get_pt: Request for invalid dimension "
                 "from nanoflann");
 
+        if (!m_cache.empty())
+            return m_cache.get(idx, dim);
         return m_buf.getFieldAs<double>(ids[dim], idx);
     }
 
     double kdtree_distance(const double *p1, const PointId p2_idx,
         size_t /*numDims*/) const
     {
-        double d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, p2_idx);
-        double d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, p2_idx);
-        double d2 = p1[2] - m_buf.getFieldAs<double>(Dimension::Id::Z, p2_idx);
+        double d0, d1, d2;
+        if (!m_cache.empty())
+        {
+            d0 = p1[0] - m_cache.get(p2_idx, 0);
+            d1 = p1[1] - m_cache.get(p2_idx, 1);
+            d2 = p1[2] - m_cache.get(p2_idx, 2);
+        }
+        else
+        {
+            d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, p2_idx);
+            d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, p2_idx);
+            d2 = p1[2] - m_buf.getFieldAs<double>(Dimension::Id::Z, p2_idx);
+        }
 
         return (d0 * d0 + d1 * d1 + d2 * d2);
     }
@@ -197,6 +320,16 @@ public:
         m_index.buildIndex();
     }
 
+    void build(bool cacheCoords, size_t threads)
+    {
+        if (cacheCoords)
+            m_cache.load(m_buf,
+                { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z },
+                threads);
+        m_index.n_thread_build = (unsigned)(std::max)(threads, (size_t)1);
+        m_index.buildIndex();
+    }
+
     PointIdList neighbors(double x, double y, double z, point_count_t k,
         size_t stride) const
     {
@@ -265,6 +398,7 @@ public:
 
 private:
     const PointView& m_buf;
+    KDCoordCache m_cache;
 
     typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<
         double, KD3Impl, double>, KD3Impl, -1, std::size_t> KDTree;
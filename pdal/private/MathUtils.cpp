@@ -34,7 +34,11 @@
 
 #include <array>
 #include <cfloat>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <numeric>
+#include <thread>
 #include <vector>
 
 #include <pdal/PointView.hpp>
@@ -255,77 +259,212 @@ Eigen::MatrixXd extendedLocalMinimum(const PointView& view, int rows, int cols,
     return ZImin;
 }
 
-void dilateDiamond(std::vector<double>& data, size_t rows, size_t cols, int iterations)
+namespace
 {
-    std::vector<double> out(data.size(), std::numeric_limits<double>::lowest());
-    std::array<size_t, 5> idx;
 
-    for (int iter = 0; iter < iterations; ++iter)
+// Run f(i) for i in [0, count), splitting the range among threads.
+template<typename F>
+void parallelFor(size_t count, size_t threads, F f)
+{
+    threads = (std::min)((std::max)(threads, (size_t)1), count);
+    if (threads <= 1)
     {
-        for (size_t col = 0; col < cols; ++col)
+        for (size_t i = 0; i < count; ++i)
+            f(i);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t)
+        pool.emplace_back([t, threads, count, &f]()
         {
-            size_t index = col*rows;
-            for (size_t row = 0; row < rows; ++row)
+            size_t begin = count * t / threads;
+            size_t end = count * (t + 1) / threads;
+            for (size_t i = begin; i < end; ++i)
+                f(i);
+        });
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// Morphological operations on a raster that has been padded on all sides.
+// Cells of the padding hold the identity value of the operation, so
+// windows that extend past the edge of the raster only see raster cells.
+// Op is std::less<double> for erosion and std::greater<double> for dilation.
+template<typename Op>
+class Morphology
+{
+public:
+    Morphology(std::vector<double>& data, size_t rows, size_t cols,
+            size_t margin, size_t threads) :
+        m_data(data), m_rows(rows), m_cols(cols), m_margin(margin),
+        m_prows(rows + 2 * margin), m_pcols(cols + 2 * margin),
+        m_threads(threads)
+    {
+        // NaN values don't take part in the operation.
+        m_grid.assign(m_prows * m_pcols, identity());
+        for (size_t c = 0; c < m_cols; ++c)
+            for (size_t r = 0; r < m_rows; ++r)
             {
-                // Find the index into the vector of the current cell.  Then
-                // find the index of the cells to the right/left/above/below
-                // if they exist.
-                size_t j = 0;
-                idx[j++] = index+row;
-                if (row > 0)
-                    idx[j++] = idx[0]-1;
-                if (row < rows-1)
-                    idx[j++] = idx[0]+1;
-                if (col > 0)
-                    idx[j++] = idx[0]-rows;
-                if (col < cols-1)
-                    idx[j++] = idx[0]+rows;
-                // If the data at the test cell pos is greater than that
-                // from the last iteration, set the value to the maximum of
-                // the value of those cells.
-                for (size_t i = 0; i < j; ++i)
-                {
-                    if (data[idx[i]] > out[index+row])
-                        out[index+row] = data[idx[i]];
-                }
+                double d = m_data[c * m_rows + r];
+                if (!std::isnan(d))
+                    m_grid[(c + m_margin) * m_prows + r + m_margin] = d;
             }
-        }
-        data.swap(out);
     }
-}
 
-void erodeDiamond(std::vector<double>& data, size_t rows, size_t cols,
-    int iterations)
-{
-    std::vector<double> out(data.size(), (std::numeric_limits<double>::max)());
-    std::array<size_t, 5> idx;
+    // Copy the result back to the raster.  Cells whose window contained no
+    // values are set to the largest finite value for erosion and the lowest
+    // for dilation.
+    void finish()
+    {
+        const double ident = identity();
+        const double empty = Op()(0, 1) ?
+            (std::numeric_limits<double>::max)() :
+            std::numeric_limits<double>::lowest();
+        for (size_t c = 0; c < m_cols; ++c)
+            for (size_t r = 0; r < m_rows; ++r)
+            {
+                double d = m_grid[(c + m_margin) * m_prows + r + m_margin];
+                m_data[c * m_rows + r] = (d == ident) ? empty : d;
+            }
+    }
 
-    for (int iter = 0; iter < iterations; ++iter)
+    // Apply the operation with a square window of the given radius, rotated
+    // by 45 degrees.  Each diagonal is filtered in one pass and then each
+    // antidiagonal, at constant cost per cell.
+    void rotatedSquare(size_t radius)
     {
-        for (size_t col = 0; col < cols; ++col)
+        if (radius == 0)
+            return;
+        const size_t diagonals = m_prows + m_pcols - 1;
+
+        // Diagonals (row and column increase together), starting in the
+        // first column or the first row.
+        parallelFor(diagonals, m_threads, [this, radius](size_t d)
+        {
+            size_t r = (d < m_prows) ? m_prows - 1 - d : 0;
+            size_t c = (d < m_prows) ? 0 : d - m_prows + 1;
+            size_t len = (std::min)(m_prows - r, m_pcols - c);
+            line(c * m_prows + r, m_prows + 1, len, radius);
+        });
+
+        // Antidiagonals (row decreases as column increases), starting in the
+        // first column or the last row.
+        parallelFor(diagonals, m_threads, [this, radius](size_t d)
         {
-            size_t index = col*rows;
-            for (size_t row = 0; row < rows; ++row)
+            size_t r = (d < m_prows) ? d : m_prows - 1;
+            size_t c = (d < m_prows) ? 0 : d - m_prows + 1;
+            size_t len = (std::min)(r + 1, m_pcols - c);
+            line(c * m_prows + r, m_prows - 1, len, radius);
+        });
+    }
+
+    // Apply the operation with a diamond of radius one (the cell and its
+    // four edge neighbors).
+    void diamond()
+    {
+        std::vector<double> out(m_grid.size());
+        parallelFor(m_pcols, m_threads, [this, &out](size_t c)
+        {
+            Op op;
+            for (size_t r = 0; r < m_prows; ++r)
             {
-                size_t j = 0;
-                idx[j++] = index+row;
-                if (row > 0)
-                    idx[j++] = idx[0]-1;
-                if (row < rows-1)
-                    idx[j++] = idx[0]+1;
-                if (col > 0)
-                    idx[j++] = idx[0]-rows;
-                if (col < cols-1)
-                    idx[j++] = idx[0]+rows;
-                for (size_t i = 0; i < j; ++i)
-                {
-                    if (data[idx[i]] < out[index+row])
-                        out[index+row] = data[idx[i]];
-                }
+                size_t i = c * m_prows + r;
+                double v = m_grid[i];
+                if (r > 0 && op(m_grid[i - 1], v))
+                    v = m_grid[i - 1];
+                if (r < m_prows - 1 && op(m_grid[i + 1], v))
+                    v = m_grid[i + 1];
+                if (c > 0 && op(m_grid[i - m_prows], v))
+                    v = m_grid[i - m_prows];
+                if (c < m_pcols - 1 && op(m_grid[i + m_prows], v))
+                    v = m_grid[i + m_prows];
+                out[i] = v;
             }
-        }
-        data.swap(out);
+        });
+        m_grid.swap(out);
     }
+
+private:
+    std::vector<double>& m_data;
+    size_t m_rows;
+    size_t m_cols;
+    size_t m_margin;
+    size_t m_prows;
+    size_t m_pcols;
+    size_t m_threads;
+    std::vector<double> m_grid;
+
+    static double identity()
+    {
+        return Op()(0, 1) ? std::numeric_limits<double>::infinity() :
+            -std::numeric_limits<double>::infinity();
+    }
+
+    // Running min/max over a window of 2 * radius + 1 cells along a line of
+    // the grid (van Herk/Gil-Werman).  The line is extended by 'radius'
+    // identity cells at each end and split into blocks the size of the
+    // window.  'fwd' holds the extreme from the start of each block to a
+    // cell and 'bwd' from a cell to the end of its block, so the extreme of
+    // any window is the combination of one value from each.
+    void line(size_t start, size_t stride, size_t len, size_t radius)
+    {
+        Op op;
+        const size_t w = 2 * radius + 1;
+        const size_t n = len + 2 * radius;
+        const double ident = identity();
+        auto val = [&](size_t j)
+        {
+            return (j < radius || j >= len + radius) ? ident :
+                m_grid[start + (j - radius) * stride];
+        };
+        auto best = [&op](double a, double b)
+            { return op(b, a) ? b : a; };
+
+        std::vector<double> fwd(n);
+        std::vector<double> bwd(n);
+        for (size_t j = 0; j < n; ++j)
+            fwd[j] = (j % w == 0) ? val(j) : best(fwd[j - 1], val(j));
+        for (size_t j = n; j-- > 0;)
+            bwd[j] = (j % w == w - 1 || j == n - 1) ? val(j) :
+                best(bwd[j + 1], val(j));
+        for (size_t i = 0; i < len; ++i)
+            m_grid[start + i * stride] = best(bwd[i], fwd[i + 2 * radius]);
+    }
+};
+
+// A diamond of radius n is the combination of a rotated square of radius
+// (n - 1) / 2 and one or two diamonds of radius one.  The rotated square is
+// filtered along diagonals, so the raster is padded so that the windows of
+// all raster cells are within the grid.
+template<typename Op>
+void diamond(std::vector<double>& data, size_t rows, size_t cols,
+    int iterations, size_t threads)
+{
+    if (iterations <= 0 || data.empty())
+        return;
+
+    const size_t radius = (iterations - 1) / 2;
+    const size_t steps = iterations - 2 * radius;
+    Morphology<Op> m(data, rows, cols, radius + steps, threads);
+    m.rotatedSquare(radius);
+    for (size_t i = 0; i < steps; ++i)
+        m.diamond();
+    m.finish();
+}
+
+} // unnamed namespace
+
+void dilateDiamond(std::vector<double>& data, size_t rows, size_t cols,
+    int iterations, size_t threads)
+{
+    diamond<std::greater<double>>(data, rows, cols, iterations, threads);
+}
+
+void erodeDiamond(std::vector<double>& data, size_t rows, size_t cols,
+    int iterations, size_t threads)
+{
+    diamond<std::less<double>>(data, rows, cols, iterations, threads);
 }
 
 Eigen::MatrixXd pointViewToEigen(const PointView& view)
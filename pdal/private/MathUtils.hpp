@@ -189,35 +189,41 @@ Eigen::MatrixXd extendedLocalMinimum(const PointView& view, int rows,
   Perform a morphological dilation of the input raster.
 
   Performs a morphological dilation of the input raster using a diamond
-  structuring element. Larger structuring elements are approximated by applying
-  multiple iterations of the opening operation. The input and output rasters are
-  stored in column major order.
+  structuring element. The result is the same as applying a diamond of radius
+  one 'iterations' times, but the cost per cell doesn't depend on the size of
+  the structuring element. The input and output rasters are stored in column
+  major order. NaN values are ignored; cells with no values in their window
+  are set to NaN.
 
   \param data the input raster.
   \param rows the number of rows.
   \param cols the number of cols.
-  \param iterations the number of iterations used to approximate a larger
-         structuring element.
+  \param iterations the radius of the structuring element.
+  \param threads the number of threads used.
   \return the morphological dilation of the input raster.
 */
-void dilateDiamond(std::vector<double>& data, size_t rows, size_t cols, int iterations);
+void dilateDiamond(std::vector<double>& data, size_t rows, size_t cols,
+    int iterations, size_t threads = 1);
 
 /**
   Perform a morphological erosion of the input raster.
 
   Performs a morphological erosion of the input raster using a diamond
-  structuring element. Larger structuring elements are approximated by applying
-  multiple iterations of the opening operation. The input and output rasters are
-  stored in column major order.
+  structuring element. The result is the same as applying a diamond of radius
+  one 'iterations' times, but the cost per cell doesn't depend on the size of
+  the structuring element. The input and output rasters are stored in column
+  major order. NaN values are ignored; cells with no values in their window
+  are set to NaN.
 
   \param data the input raster.
   \param rows the number of rows.
   \param cols the number of cols.
-  \param iterations the number of iterations used to approximate a larger
-         structuring element.
+  \param iterations the radius of the structuring element.
+  \param threads the number of threads used.
   \return the morphological erosion of the input raster.
 */
-void erodeDiamond(std::vector<double>& data, size_t rows, size_t cols, int iterations);
+void erodeDiamond(std::vector<double>& data, size_t rows, size_t cols,
+    int iterations, size_t threads = 1);
 
 /**
   Converts a PointView into an Eigen::MatrixXd.
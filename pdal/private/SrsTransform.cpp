@@ -28,6 +28,8 @@
  * OF SUCH DAMAGE.
  ****************************************************************************/
 
+#include <algorithm>
+
 #include "SrsTransform.hpp"
 #include <pdal/SpatialReference.hpp>
 
@@ -132,11 +134,27 @@ bool SrsTransform::transform(double& x, double& y, double& z) const
 bool SrsTransform::transform(std::vector<double>& x, std::vector<double>& y,
     std::vector<double>& z) const
 {
-    if (x.size() != y.size() && y.size() != z.size())
+    if (x.size() != y.size() || y.size() != z.size())
         throw pdal_error("SrsTransform::called with vectors of different "
             "sizes.");
-    int err = m_transform->Transform(x.size(), x.data(), y.data(), z.data());
-    return (err == OGRERR_NONE);
+    return m_transform &&
+        m_transform->Transform((int)x.size(), x.data(), y.data(), z.data());
+}
+
+
+bool SrsTransform::transform(size_t count, double *x, double *y, double *z,
+    int *success) const
+{
+    if (!m_transform)
+    {
+        std::fill(success, success + count, FALSE);
+        return false;
+    }
+
+    // Depending on the GDAL version, the return value indicates that
+    // some or all points were transformed, so check each point.
+    m_transform->Transform((int)count, x, y, z, nullptr, success);
+    return std::find(success, success + count, FALSE) == success + count;
 }
 
 } // namespace pdal
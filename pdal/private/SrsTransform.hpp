@@ -76,6 +76,18 @@ public:
     bool transform(std::vector<double>& x, std::vector<double>& y,
         std::vector<double>& z) const;
 
+    /// Transform a set of points in place, noting which points were
+    /// transformed.  Points that can't be transformed don't prevent the
+    /// transformation of the others.
+    /// \param count  Number of points
+    /// \param x  X coordinates
+    /// \param y  Y coordinates
+    /// \param z  Z coordinates
+    /// \param success  Set to nonzero for each point that was transformed
+    /// \return  True if all the points were transformed
+    bool transform(size_t count, double *x, double *y, double *z,
+        int *success) const;
+
     /// Determine if this represents a valid transform.
     /// \return  Whether the transform is valid or not.
     bool valid() const
@@ -99,8 +99,11 @@ ErrorHandler::~ErrorHandler()
 void ErrorHandler::set(LogPtr log, bool debug)
 {
     // Set an error handler
-    if (m_prevHandler == nullptr)
-        m_prevHandler = CPLSetErrorHandler(&trampoline);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_prevHandler == nullptr)
+            m_prevHandler = CPLSetErrorHandler(&trampoline);
+    }
     setLog(log);
     setDebug(debug);
 }
@@ -111,6 +114,7 @@ void ErrorHandler::set(LogPtr log, bool debug)
 */
 void ErrorHandler::clear()
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
     CPLSetErrorHandler(m_prevHandler);
     m_prevHandler = nullptr;
 }
@@ -38,6 +38,12 @@
 #include <gdal_priv.h>
 #pragma warning(pop)
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <unordered_map>
+
 #include <pdal/util/Algorithm.hpp>
 
 #include "Raster.hpp"
@@ -137,8 +143,166 @@ GDALDataType toGdalType(Dimension::Type t)
     }
 }
 
+// Default size of the block cache (bytes).
+const size_t DefaultCacheSize = 256 * 1024 * 1024;
+
 } // unnamed namespace
 
+
+std::istream& operator>>(std::istream& in, Sampling& sampling)
+{
+    std::string s;
+    in >> s;
+
+    s = Utils::tolower(s);
+    if (s == "nearest")
+        sampling = Sampling::Nearest;
+    else if (s == "bilinear")
+        sampling = Sampling::Bilinear;
+    else
+        in.setstate(std::ios_base::failbit);
+    return in;
+}
+
+
+std::ostream& operator<<(std::ostream& out, const Sampling& sampling)
+{
+    switch (sampling)
+    {
+    case Sampling::Nearest:
+        out << "nearest";
+        break;
+    case Sampling::Bilinear:
+        out << "bilinear";
+        break;
+    }
+    return out;
+}
+
+
+/**
+  Cache of raster blocks, stored as doubles.  When the cache is full,
+  the least-recently-used block is discarded.  Blocks are aligned with
+  the blocks of the first band of the dataset so that each block is read
+  from GDAL with a single, efficient request.
+*/
+class BlockCache
+{
+public:
+    BlockCache(GDALDataset *ds, size_t maxBytes) : m_ds(ds),
+        m_lastKey((std::numeric_limits<uint64_t>::max)()), m_last(nullptr)
+    {
+        GDALRasterBand *band = ds->GetRasterBand(1);
+        if (band)
+            band->GetBlockSize(&m_blockWidth, &m_blockHeight);
+        if (!band || m_blockWidth <= 0 || m_blockHeight <= 0)
+        {
+            m_blockWidth = 256;
+            m_blockHeight = 256;
+        }
+        m_maxBlocks = (std::max)((size_t)1, maxBytes /
+            (sizeof(double) * m_blockWidth * m_blockHeight));
+
+        for (int i = 0; i < ds->GetRasterCount(); ++i)
+        {
+            int hasNoData(0);
+            double noData = GDALGetRasterNoDataValue(
+                GDALGetRasterBand(m_ds, i + 1), &hasNoData);
+            m_noData.push_back(hasNoData ? noData :
+                std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+
+    int blockWidth() const
+        { return m_blockWidth; }
+    int blockHeight() const
+        { return m_blockHeight; }
+    bool isNoData(int band, double v) const
+    {
+        double noData = m_noData[band - 1];
+        return v == noData || (std::isnan(v) && std::isnan(noData));
+    }
+
+    // Get the value of a band at a cell.  Returns false if the block
+    // containing the cell can't be read.
+    bool value(int band, int col, int row, double& v)
+    {
+        const double *data = block(band, col / m_blockWidth,
+            row / m_blockHeight);
+        if (!data)
+            return false;
+        v = data[(row % m_blockHeight) * m_blockWidth + (col % m_blockWidth)];
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        std::vector<double> m_data;
+        std::list<uint64_t>::iterator m_pos;
+    };
+
+    GDALDataset *m_ds;
+    int m_blockWidth;
+    int m_blockHeight;
+    size_t m_maxBlocks;
+    std::vector<double> m_noData;
+    std::unordered_map<uint64_t, Entry> m_blocks;
+    std::list<uint64_t> m_lru;  // Most recently used at the front.
+    uint64_t m_lastKey;
+    const double *m_last;
+
+    const double *block(int band, int bx, int by)
+    {
+        uint64_t key = ((uint64_t)band << 48) | ((uint64_t)by << 24) |
+            (uint64_t)bx;
+        // Consecutive lookups are usually in the same block.
+        if (key == m_lastKey)
+            return m_last;
+
+        auto it = m_blocks.find(key);
+        if (it != m_blocks.end())
+            m_lru.splice(m_lru.begin(), m_lru, it->second.m_pos);
+        else
+        {
+            std::vector<double> data;
+            if (!read(band, bx, by, data))
+                return nullptr;
+            if (m_blocks.size() >= m_maxBlocks)
+            {
+                m_blocks.erase(m_lru.back());
+                m_lru.pop_back();
+            }
+            m_lru.push_front(key);
+            it = m_blocks.insert({key, Entry()}).first;
+            it->second.m_data.swap(data);
+            it->second.m_pos = m_lru.begin();
+        }
+        m_lastKey = key;
+        m_last = it->second.m_data.data();
+        return m_last;
+    }
+
+    bool read(int band, int bx, int by, std::vector<double>& data)
+    {
+        GDALRasterBandH b = GDALGetRasterBand(m_ds, band);
+        if (!b)
+            return false;
+        int x = bx * m_blockWidth;
+        int y = by * m_blockHeight;
+        int width = (std::min)(m_blockWidth, m_ds->GetRasterXSize() - x);
+        int height = (std::min)(m_blockHeight, m_ds->GetRasterYSize() - y);
+
+        // Partial blocks at the edges are stored with the full block
+        // width so that cells are found the same way in every block.
+        data.resize((size_t)m_blockWidth * m_blockHeight);
+        return GDALRasterIO(b, GF_Read, x, y, width, height, data.data(),
+            width, height, GDT_Float64, 0,
+            m_blockWidth * sizeof(double)) == CE_None;
+    }
+};
+
+
 /**
   Create a copy of the raster in memory.
   \return  Pointer to the new raster.
@@ -176,6 +340,7 @@ Raster::Raster(const std::string& filename, const std::string& drivername)
     , m_numBands(0)
     , m_drivername(drivername)
     , m_ds(0)
+    , m_cacheSize(DefaultCacheSize)
 {
     m_forwardTransform.fill(0);
     m_forwardTransform[1] = 1;
@@ -202,6 +367,20 @@ Raster::Raster(const std::string& filename, const std::string& drivername,
     , m_forwardTransform(pixelToPos)
     , m_srs(srs)
     , m_ds(0)
+    , m_cacheSize(DefaultCacheSize)
+{}
+
+
+/**
+  Constructor for a raster from an open dataset.
+  \param ds  GDAL dataset.
+*/
+Raster::Raster(GDALDataset *ds)
+    : m_width(0)
+    , m_height(0)
+    , m_numBands(0)
+    , m_ds(ds)
+    , m_cacheSize(DefaultCacheSize)
 {}
 
 
@@ -526,8 +705,6 @@ GDALError Raster::read(double x, double y, std::vector<double>& data)
     int32_t line(0);
     data.resize(m_numBands);
 
-    std::array<double, 2> pix = { {0.0, 0.0} };
-
     // No data at this x,y if we can't compute a pixel/line location
     // for it.
     if (!getPixelAndLinePosition(x, y, pixel, line))
@@ -536,21 +713,148 @@ GDALError Raster::read(double x, double y, std::vector<double>& data)
         return GDALError::NoData;
     }
 
-    for (int i=0; i < m_numBands; ++i)
-    {
-        GDALRasterBandH b = GDALGetRasterBand(m_ds, i + 1);
-        if (GDALRasterIO(b, GF_Read, pixel, line, 1, 1,
-            &pix[0], 1, 1, GDT_Float64, 0, 0) == CE_None)
+    BlockCache& c = cache();
+    for (int i = 0; i < m_numBands; ++i)
+        if (!c.value(i + 1, pixel, line, data[i]))
         {
-            // we read a pixel put its values in our vector
-            data[i] = pix[0];
+            m_errorMsg = "Unable to read block for raster '" +
+                m_filename + "'.";
+            return GDALError::CantReadBlock;
         }
+
+    return GDALError::None;
+}
+
+
+GDALError Raster::read(const double *x, const double *y, size_t count,
+    std::vector<double>& data, std::vector<char>& valid, Sampling sampling)
+{
+    if (!m_ds)
+    {
+        m_errorMsg = "Raster not open.";
+        return GDALError::NotOpen;
     }
 
+    data.resize(count * m_numBands);
+    valid.assign(count, 0);
+    if (count == 0)
+        return GDALError::None;
+
+    // Pixel/line position of each point as a fraction of a cell.
+    const std::array<double, 6>& t = m_inverseTransform;
+    std::vector<double> px(count);
+    std::vector<double> py(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        px[i] = t[0] + t[1] * x[i] + t[2] * y[i];
+        py[i] = t[3] + t[4] * x[i] + t[5] * y[i];
+    }
+
+    // Only points inside the raster are sampled.  The test is written so
+    // that NaN positions are dropped as well, which keeps the sort below
+    // a strict weak ordering.
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        if (px[i] >= 0 && px[i] < m_width && py[i] >= 0 && py[i] < m_height)
+            order.push_back(i);
+
+    // Visit the points in order of the block that contains them so that
+    // each block is fetched from the cache, or read, once per batch.
+    BlockCache& c = cache();
+    auto blockOf = [&c, &px, &py](size_t i)
+    {
+        double bx = std::floor(px[i] / c.blockWidth());
+        double by = std::floor(py[i] / c.blockHeight());
+        return std::make_pair(by, bx);
+    };
+    std::stable_sort(order.begin(), order.end(),
+        [&blockOf](size_t a, size_t b){ return blockOf(a) < blockOf(b); });
+
+    for (size_t i : order)
+    {
+        if (!sample(px[i], py[i], sampling, data.data() + i * m_numBands))
+        {
+            m_errorMsg = "Unable to read block for raster '" +
+                m_filename + "'.";
+            return GDALError::CantReadBlock;
+        }
+        valid[i] = 1;
+    }
     return GDALError::None;
 }
 
 
+/**
+  Compute the value of each band at a pixel/line position inside the raster.
+  \param px  Pixel (column) position.
+  \param py  Line (row) position.
+  \param sampling  Sampling method.
+  \param[out] out  Value of each band.
+  \return  Whether the necessary blocks could be read.
+*/
+bool Raster::sample(double px, double py, Sampling sampling, double *out)
+{
+    BlockCache& c = cache();
+    int col = (int)std::floor(px);
+    int row = (int)std::floor(py);
+
+    for (int band = 1; band <= m_numBands; ++band)
+        if (!c.value(band, col, row, out[band - 1]))
+            return false;
+    if (sampling == Sampling::Nearest)
+        return true;
+
+    // Cell values are at cell centers.  Cells past the edge of the raster
+    // are replaced by the edge cells.
+    double fx = px - .5;
+    double fy = py - .5;
+    int c0 = (int)std::floor(fx);
+    int r0 = (int)std::floor(fy);
+    double tx = fx - c0;
+    double ty = fy - r0;
+    int c1 = Utils::clamp(c0 + 1, 0, m_width - 1);
+    int r1 = Utils::clamp(r0 + 1, 0, m_height - 1);
+    c0 = Utils::clamp(c0, 0, m_width - 1);
+    r0 = Utils::clamp(r0, 0, m_height - 1);
+
+    for (int band = 1; band <= m_numBands; ++band)
+    {
+        double v00, v10, v01, v11;
+        if (!c.value(band, c0, r0, v00) || !c.value(band, c1, r0, v10) ||
+            !c.value(band, c0, r1, v01) || !c.value(band, c1, r1, v11))
+            return false;
+
+        // Keep the nearest value if any of the cells has no data.
+        if (c.isNoData(band, v00) || c.isNoData(band, v10) ||
+            c.isNoData(band, v01) || c.isNoData(band, v11))
+            continue;
+        double top = v00 + (v10 - v00) * tx;
+        double bottom = v01 + (v11 - v01) * tx;
+        out[band - 1] = top + (bottom - top) * ty;
+    }
+    return true;
+}
+
+
+/**
+  Get the block cache of an open raster, creating it if necessary.
+*/
+BlockCache& Raster::cache()
+{
+    if (!m_cache)
+        m_cache.reset(new BlockCache(m_ds, m_cacheSize));
+    return *m_cache;
+}
+
+
+void Raster::setCacheSize(size_t bytes)
+{
+    m_cacheSize = bytes;
+    m_cache.reset();
+}
+
+
 /**
   Get the spatial reference associated with a raster.
   \return  Associated spatial reference.
@@ -579,6 +883,7 @@ Raster::~Raster()
 */
 void Raster::close()
 {
+    m_cache.reset();
     GDALClose(m_ds);
     m_ds = nullptr;
     m_types.clear();
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 
 #include <pdal/DimUtil.hpp>
 #include <pdal/pdal_types.hpp>
@@ -56,6 +57,19 @@ namespace gdal
 template<typename ITER>
 using ITER_VAL = typename std::iterator_traits<ITER>::value_type;
 
+class BlockCache;
+
+/**
+  How raster values are computed at a position.
+*/
+enum class Sampling
+{
+    Nearest,    /// Value of the cell containing the position.
+    Bilinear    /// Interpolated from the four nearest cell centers.
+};
+PDAL_DLL std::istream& operator>>(std::istream& in, Sampling& sampling);
+PDAL_DLL std::ostream& operator<<(std::ostream& out, const Sampling& sampling);
+
 class Raster;
 
 /*
@@ -311,7 +325,7 @@ public:
       \param pixelToPos  Transformation matrix to convert raster positions to
         geolocations.
     */
-    Raster(GDALDataset *ds) : m_ds (ds) {};
+    Raster(GDALDataset *ds);
 
     /**
       Return a GDAL MEM driver copy of the raster
@@ -470,6 +484,33 @@ public:
     */
     GDALError read(double x, double y, std::vector<double>& data);
 
+    /**
+      Read the data for each band at many positions.  Values are read
+      from a cache of raster blocks rather than from GDAL for each
+      position, and positions are visited in block order.
+
+      \param x  X positions to read.
+      \param y  Y positions to read.
+      \param count  Number of positions.
+      \param[out] data  Values read, bandCount() values for each position.
+      \param[out] valid  Set to 1 for positions inside the raster and 0
+        for positions outside it.  The data of positions outside the
+        raster isn't set.
+      \param sampling  How values are computed from the raster cells.
+        With bilinear sampling, the value of the nearest cell is used
+        where an interpolated cell has no data.
+    */
+    GDALError read(const double *x, const double *y, size_t count,
+        std::vector<double>& data, std::vector<char>& valid,
+        Sampling sampling = Sampling::Nearest);
+
+    /**
+      Set the maximum amount of memory used to cache raster blocks.
+
+      \param bytes  Cache size in bytes.
+    */
+    void setCacheSize(size_t bytes);
+
     /**
       Get a vector of dimensions that map to the bands of a raster.
     */
@@ -545,6 +586,8 @@ private:
     GDALDataset *m_ds;
     Dimension::Type m_bandType;
     double m_dstNoData;
+    size_t m_cacheSize;
+    std::unique_ptr<BlockCache> m_cache;
 
     GDALError wake();
 
@@ -556,6 +599,8 @@ private:
     bool getPixelAndLinePosition(double x, double y,
         int32_t& pixel, int32_t& line);
     GDALError computePDALDimensionTypes();
+    BlockCache& cache();
+    bool sample(double px, double py, Sampling sampling, double *out);
 };
 
 } // namespace gdal
@@ -39,6 +39,7 @@
 
 #include <Eigen/Dense>
 
+#include <cmath>
 #include <limits>
 #include <numeric>
 
@@ -166,6 +167,69 @@ TEST(EigenTest, Morphological)
     EXPECT_EQ(0, Fv2[12]);
 }
 
+// Compare large structuring elements to the minimum/maximum over the cells
+// of the diamond.
+TEST(EigenTest, MorphologicalLarge)
+{
+    const int rows = 37;
+    const int cols = 53;
+    std::vector<double> data(rows * cols);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (double)((i * 7919) % 101);
+
+    for (int radius : { 3, 8, 15 })
+    {
+        std::vector<double> eroded(data);
+        math::erodeDiamond(eroded, rows, cols, radius, 3);
+        std::vector<double> dilated(data);
+        math::dilateDiamond(dilated, rows, cols, radius, 3);
+
+        for (int c = 0; c < cols; ++c)
+            for (int r = 0; r < rows; ++r)
+            {
+                double lo = (std::numeric_limits<double>::max)();
+                double hi = std::numeric_limits<double>::lowest();
+                for (int cc = 0; cc < cols; ++cc)
+                    for (int rr = 0; rr < rows; ++rr)
+                        if (std::abs(cc - c) + std::abs(rr - r) <= radius)
+                        {
+                            lo = (std::min)(lo, data[cc * rows + rr]);
+                            hi = (std::max)(hi, data[cc * rows + rr]);
+                        }
+                EXPECT_EQ(lo, eroded[c * rows + r]);
+                EXPECT_EQ(hi, dilated[c * rows + r]);
+            }
+    }
+}
+
+// Cells whose window holds only NaN get the lowest value when dilated and
+// the largest value when eroded.
+TEST(EigenTest, MorphologicalEmpty)
+{
+    const size_t rows = 7;
+    const size_t cols = 9;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (int radius : { 1, 2, 5 })
+    {
+        std::vector<double> eroded(rows * cols, nan);
+        eroded[0] = 5;
+        std::vector<double> dilated(eroded);
+        math::erodeDiamond(eroded, rows, cols, radius, 2);
+        math::dilateDiamond(dilated, rows, cols, radius, 2);
+
+        for (size_t c = 0; c < cols; ++c)
+            for (size_t r = 0; r < rows; ++r)
+            {
+                bool inWindow = (int)(r + c) <= radius;
+                EXPECT_EQ(inWindow ? 5 : (std::numeric_limits<double>::max)(),
+                    eroded[c * rows + r]);
+                EXPECT_EQ(inWindow ? 5 : std::numeric_limits<double>::lowest(),
+                    dilated[c * rows + r]);
+            }
+    }
+}
+
 TEST(EigenTest, RoundtripString)
 {
     Eigen::MatrixXd identity = Eigen::MatrixXd::Identity(4, 4);
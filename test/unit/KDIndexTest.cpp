@@ -378,3 +378,57 @@ TEST(KDIndex, radius3D)
     EXPECT_EQ(ids[2], 2u);
 }
 
+
+// Check that indexes using cached coordinates and built with several threads
+// answer single and batched queries the same as the default index.
+TEST(KDIndex, cached)
+{
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+    PointView view(table);
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    const point_count_t count = 20000;
+    for (PointId i = 0; i < count; ++i)
+    {
+        view.setField(Dimension::Id::X, i, (i * 7919) % 1000);
+        view.setField(Dimension::Id::Y, i, (i * 104729) % 1000);
+        view.setField(Dimension::Id::Z, i, (i * 1299709) % 100);
+    }
+
+    KD3Index index(view);
+    index.build();
+    KD3Index cached(view);
+    cached.build(true, 4);
+    KD2Index index2(view);
+    index2.build();
+    KD2Index cached2(view);
+    cached2.build(true, 4);
+
+    PointIdList ids;
+    for (PointId i = 0; i < count; i += 97)
+        ids.push_back(i);
+
+    std::vector<PointIdList> indices;
+    std::vector<std::vector<double>> dists;
+    cached.knnSearch(ids, 8, &indices, &dists, 4);
+    std::vector<PointIdList> radius = cached.radius(ids, 30, 4);
+    std::vector<PointIdList> radius2 = cached2.radius(ids, 30, 4);
+    ASSERT_EQ(indices.size(), ids.size());
+    ASSERT_EQ(radius.size(), ids.size());
+    ASSERT_EQ(radius2.size(), ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        PointIdList expIndices(8);
+        std::vector<double> expDists(8);
+        index.knnSearch(ids[i], 8, &expIndices, &expDists);
+        EXPECT_EQ(expDists, dists[i]);
+
+        EXPECT_EQ(index.radius(ids[i], 30).size(), radius[i].size());
+        EXPECT_EQ(index2.radius(ids[i], 30).size(), radius2[i].size());
+        EXPECT_EQ(index2.neighbors(ids[i], 4), cached2.neighbors(ids[i], 4));
+    }
+}
@@ -68,6 +68,44 @@ TEST(PipelineManagerTest, basic)
     FileUtils::deleteFile(outfile);
 }
 
+// Make sure that points dropped by a filter are released and that the
+// remaining points are still found by the views passed between stages.
+TEST(PipelineManagerTest, compact)
+{
+    PipelineManager mgr;
+    mgr.setCompact(true);
+
+    Options optsR;
+    optsR.add("mode", "ramp");
+    optsR.add("count", 200000);
+    optsR.add("bounds", "([0,199999],[0,199999],[0,199999])");
+    Stage& reader = mgr.addReader("readers.faux");
+    reader.setOptions(optsR);
+
+    Options optsD;
+    optsD.add("step", 10);
+    Stage& decimate = mgr.addFilter("filters.decimation");
+    decimate.setInput(reader);
+    decimate.setOptions(optsD);
+
+    Options optsRange;
+    optsRange.add("limits", "X[0:100000]");
+    Stage& range = mgr.addFilter("filters.range");
+    range.setInput(decimate);
+    range.setOptions(optsRange);
+
+    point_count_t np = mgr.execute();
+    EXPECT_EQ(np, 10001U);
+    EXPECT_EQ(mgr.pointTable().storedPoints(), 20000U);
+
+    PointViewPtr view = *mgr.views().begin();
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::X, i), (int)(i * 10));
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Y, i), (int)(i * 10));
+    }
+}
+
 // Make sure that when we add an option at the command line, it overrides
 // a pipeline option.
 TEST(PipelineManagerTest, OptionOrder)
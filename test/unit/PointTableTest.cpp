@@ -34,7 +34,12 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <thread>
+
 #include <pdal/PointTable.hpp>
+#include <filters/DecimationFilter.hpp>
+#include <filters/RangeFilter.hpp>
+#include <io/FauxReader.hpp>
 #include <io/LasReader.hpp>
 #include "Support.hpp"
 
@@ -303,4 +308,173 @@ TEST(PointTable, layoutLimit)
     }
 }
 
+namespace
+{
+
+// Add points to a table from several threads at once, each thread using
+// its own view.
+void concurrentTest(SimplePointTable& t)
+{
+    PointLayoutPtr layout = t.layout();
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Intensity);
+    t.finalize();
+
+    const PointId count = 200000;
+    std::vector<PointViewPtr> views;
+    for (int i = 0; i < 4; ++i)
+        views.emplace_back(new PointView(t));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&views, count, i]()
+        {
+            PointView& v = *views[i];
+            for (PointId id = 0; id < count; id++)
+            {
+                v.setField(Dimension::Id::X, id, id);
+                v.setField(Dimension::Id::Intensity, id, i);
+            }
+        });
+    for (std::thread& th : threads)
+        th.join();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        PointView& v = *views[i];
+        ASSERT_EQ(count, v.size());
+        for (PointId id = 0; id < count; id++)
+        {
+            EXPECT_EQ(id, v.getFieldAs<PointId>(Dimension::Id::X, id));
+            EXPECT_EQ(i, v.getFieldAs<int>(Dimension::Id::Intensity, id));
+        }
+    }
+}
+
+} // unnamed namespace
+
+TEST(PointTable, concurrentRow)
+{
+    RowPointTable t;
+    concurrentTest(t);
+}
+
+TEST(PointTable, concurrentColumn)
+{
+    ColumnPointTable t;
+    concurrentTest(t);
+}
+
+TEST(PointTable, paged)
+{
+    PagedPointTable t(0);
+    simpleTest(t);
+}
+
+TEST(PointTable, concurrentPaged)
+{
+    PagedPointTable t(0);
+    concurrentTest(t);
+}
+
+// Write more blocks than can be held in memory and read them back, both in
+// order and out of order.
+TEST(PointTable, pagedLimit)
+{
+    PagedPointTable t(1024 * 1024, Support::temppath());
+    PointLayoutPtr layout = t.layout();
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    t.finalize();
+
+    const PointId count = 1000000;
+    PointView v(t);
+    for (PointId id = 0; id < count; id++)
+    {
+        v.setField(Dimension::Id::X, id, id);
+        v.setField(Dimension::Id::Y, id, count - id);
+    }
+    EXPECT_LE(t.residentBlocks(), 2u);
+
+    for (PointId id = 0; id < count; id++)
+    {
+        EXPECT_EQ(id, v.getFieldAs<PointId>(Dimension::Id::X, id));
+        EXPECT_EQ(count - id, v.getFieldAs<PointId>(Dimension::Id::Y, id));
+    }
+    for (PointId id = 0; id < count; id += 9973)
+    {
+        PointId rev = count - 1 - id;
+        EXPECT_EQ(rev, v.getFieldAs<PointId>(Dimension::Id::X, rev));
+        EXPECT_EQ(id + 1, v.getFieldAs<PointId>(Dimension::Id::Y, rev));
+    }
+    EXPECT_LE(t.residentBlocks(), 2u);
+}
+
+namespace
+{
+
+// Drop most of the points with a filter and check that the table is
+// compacted before the following stage and that the views still find
+// their points.
+void compactTest(SimplePointTable& t)
+{
+    Options ro;
+    ro.add("mode", "ramp");
+    ro.add("count", 300000);
+    ro.add("bounds", "([0,299999],[0,299999],[0,299999])");
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options dop;
+    dop.add("step", 3);
+    DecimationFilter d;
+    d.setOptions(dop);
+    d.setInput(r);
+
+    Options rop;
+    rop.add("limits", "X[150000:]");
+    RangeFilter f;
+    f.setOptions(rop);
+    f.setInput(d);
+
+    t.setAutoCompact(true);
+    f.prepare(t);
+    PointViewSet s = f.execute(t);
+    EXPECT_EQ(t.storedPoints(), 100000u);
+
+    ASSERT_EQ(s.size(), 1u);
+    PointViewPtr v = *s.begin();
+    ASSERT_EQ(v->size(), 50000u);
+    for (PointId i = 0; i < v->size(); ++i)
+    {
+        EXPECT_EQ(v->getFieldAs<int>(Dimension::Id::X, i), (int)(150000 + i * 3));
+        EXPECT_EQ(v->getFieldAs<int>(Dimension::Id::Z, i), (int)(150000 + i * 3));
+    }
+
+    // Points added after compaction are cleared.
+    PointId id = v->size();
+    v->setField(Dimension::Id::X, id, 1);
+    EXPECT_EQ(v->getFieldAs<int>(Dimension::Id::Y, id), 0);
+}
+
+} // unnamed namespace
+
+TEST(PointTable, compactRow)
+{
+    RowPointTable t;
+    compactTest(t);
+}
+
+TEST(PointTable, compactColumn)
+{
+    ColumnPointTable t;
+    compactTest(t);
+}
+
+TEST(PointTable, compactPaged)
+{
+    PagedPointTable t(0);
+    compactTest(t);
+}
+
 } // namespace
@@ -290,6 +290,105 @@ TEST(PointViewTest, getFloatNan)
     EXPECT_NO_THROW(view->getFieldAs<float>(Dimension::Id::ScanAngleRank, 0));
 }
 
+template<typename TABLE>
+void testBulk()
+{
+    using namespace Dimension;
+
+    TABLE table;
+    table.layout()->registerDims({ Id::X, Id::Intensity, Id::Classification });
+    table.finalize();
+    PointViewPtr view(new PointView(table));
+
+    // Enough points to cross block boundaries in the tables.
+    const point_count_t cnt = 100000;
+    std::vector<double> x(cnt);
+    std::vector<int> intensity(cnt);
+    for (PointId i = 0; i < cnt; ++i)
+    {
+        x[i] = i * .5;
+        intensity[i] = i % 60000;
+    }
+    view->setFields(Id::X, 0, cnt, x.data());
+    view->setFields(Id::Intensity, 0, cnt, intensity.data());
+    ASSERT_EQ(view->size(), cnt);
+    for (PointId i = 0; i < cnt; ++i)
+    {
+        EXPECT_EQ(view->getFieldAs<double>(Id::X, i), i * .5);
+        EXPECT_EQ(view->getFieldAs<int>(Id::Intensity, i), (int)(i % 60000));
+    }
+
+    // Points of a reordered view aren't stored consecutively.
+    PointViewPtr reordered = view->makeNew();
+    for (PointId i = 0; i < cnt; i += 3)
+        reordered->appendPoint(*view, i);
+    for (PointId i = 1; i < cnt; i += 3)
+        reordered->appendPoint(*view, i);
+    const point_count_t size = reordered->size();
+
+    std::vector<float> xf(size);
+    reordered->getFieldsAs(Id::X, 0, size, xf.data());
+    for (PointId i = 0; i < size; ++i)
+        EXPECT_EQ(xf[i], reordered->getFieldAs<float>(Id::X, i));
+
+    std::vector<uint8_t> cls(size);
+    for (PointId i = 0; i < size; ++i)
+        cls[i] = i % 7;
+    reordered->setFields(Id::Classification, 0, size, cls.data());
+    std::vector<int> clsOut(size);
+    reordered->getFieldsAs(Id::Classification, 0, size, clsOut.data());
+    for (PointId i = 0; i < size; ++i)
+    {
+        EXPECT_EQ(clsOut[i], (int)(i % 7));
+        EXPECT_EQ(reordered->getFieldAs<int>(Id::Classification, i),
+            (int)(i % 7));
+    }
+
+    // Values that don't fit the requested type throw, as with getFieldAs().
+    std::vector<uint8_t> small(size);
+    EXPECT_THROW(reordered->getFieldsAs(Id::Intensity, 0, size, small.data()),
+        pdal_error);
+    std::vector<double> big(10, 1e10);
+    EXPECT_THROW(view->setFields(Id::Intensity, 0, 10, big.data()),
+        pdal_error);
+
+    // Zero-copy access is only possible for a matching type.
+    point_count_t count = 10;
+    EXPECT_EQ(view->fieldData<float>(Id::X, 0, count), nullptr);
+}
+
+TEST(PointViewTest, bulkRow)
+{
+    testBulk<PointTable>();
+}
+
+TEST(PointViewTest, bulkColumn)
+{
+    testBulk<ColumnPointTable>();
+
+    ColumnPointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.finalize();
+    PointViewPtr view(new PointView(table));
+    const point_count_t cnt = 50000;
+    for (PointId i = 0; i < cnt; ++i)
+        view->setField(Dimension::Id::X, i, (double)i);
+
+    PointId begin = 0;
+    while (begin < cnt)
+    {
+        point_count_t count = cnt - begin;
+        double *x = view->fieldData<double>(Dimension::Id::X, begin, count);
+        ASSERT_NE(x, nullptr);
+        ASSERT_GT(count, 0u);
+        for (point_count_t i = 0; i < count; ++i)
+            x[i] *= 2;
+        begin += count;
+    }
+    for (PointId i = 0; i < cnt; ++i)
+        EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i), i * 2.0);
+}
+
 // Per discussions with @abellgithub (https://github.com/gadomski/PDAL/commit/c1d54e56e2de841d37f2a1b1c218ed723053f6a9#commitcomment-14415138)
 // we only do bounds checking on `PointView`s when in debug mode.
 #ifndef NDEBUG
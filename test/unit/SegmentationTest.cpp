@@ -40,6 +40,7 @@
 
 #include <filters/private/Segmentation.hpp>
 
+#include <algorithm>
 #include <vector>
 
 using namespace pdal;
@@ -155,6 +156,69 @@ TEST(SegmentationTest, Clustering2D)
     EXPECT_EQ(1u, clusters[0].size());
 }
 
+TEST(SegmentationTest, ParallelClustering)
+{
+    using namespace Segmentation;
+
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr src(new PointView(table));
+
+    // Points along lines of various spacing, so that some lines are
+    // single clusters and others are split.
+    PointId id = 0;
+    for (int line = 0; line < 20; ++line)
+        for (int i = 0; i < 50; ++i)
+        {
+            double step = 0.5 + (line % 5) * 0.15 + (i % 7) * 0.02;
+            src->setField(Dimension::Id::X, id, i * step);
+            src->setField(Dimension::Id::Y, id, line * 3.0 + (i % 3) * 0.1);
+            src->setField(Dimension::Id::Z, id, (line % 2) * i * 0.3);
+            id++;
+        }
+
+    // Points spaced exactly at the tolerance aren't joined.
+    const PointId exactBegin = id;
+    for (int i = 0; i < 10; ++i)
+    {
+        src->setField(Dimension::Id::X, id, i * 1.0);
+        src->setField(Dimension::Id::Y, id, 100.0);
+        src->setField(Dimension::Id::Z, id, 0.0);
+        id++;
+    }
+
+    for (uint64_t minPoints : { 1, 5 })
+        for (uint64_t maxPoints : { 10, 1000 })
+        {
+            std::deque<PointIdList> serial =
+                extractClusters<KD3Index>(*src, minPoints, maxPoints, 1.0);
+            for (PointIdList& c : serial)
+                std::sort(c.begin(), c.end());
+            EXPECT_EQ(serial, extractClusters(*src, minPoints, maxPoints,
+                1.0, true, 4));
+
+            serial =
+                extractClusters<KD2Index>(*src, minPoints, maxPoints, 1.0);
+            for (PointIdList& c : serial)
+                std::sort(c.begin(), c.end());
+            EXPECT_EQ(serial, extractClusters(*src, minPoints, maxPoints,
+                1.0, false, 4));
+        }
+
+    std::deque<PointIdList> clusters =
+        extractClusters(*src, 1, 1000, 1.0, true, 4);
+    for (PointId i = exactBegin; i < id; ++i)
+        EXPECT_EQ(std::count(clusters.begin(), clusters.end(),
+            PointIdList { i }), 1);
+
+    EXPECT_THROW(extractClusters(*src, 1, 1000, 0.0, true, 4), pdal_error);
+}
+
 TEST(SegmentationTest, SegmentReturns)
 {
     using namespace Segmentation;
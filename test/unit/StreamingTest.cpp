@@ -110,6 +110,96 @@ TEST(Streaming, filter)
 namespace
 {
 
+// Table that checks the points passed through it when it's reset.
+class CheckTable : public StreamPointTable
+{
+public:
+    CheckTable(point_count_t capacity) : StreamPointTable(m_layout, capacity),
+        m_cnt(0), m_x(0)
+    {}
+
+    virtual void finalize()
+    {
+        if (!m_layout.finalized())
+        {
+            BasePointTable::finalize();
+            m_buf.resize(pointsToBytes(capacity() + 1));
+        }
+    }
+
+    int m_cnt;
+
+protected:
+    virtual void reset()
+    {
+        PointRef point(*this, 0);
+        for (PointId idx = 0; idx < numPoints(); ++idx)
+        {
+            if (skip(idx))
+                continue;
+            point.setPointId(idx);
+            EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::X), m_x);
+            m_x += 2;
+            m_cnt++;
+        }
+        std::fill(m_buf.begin(), m_buf.end(), 0);
+    }
+
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+
+private:
+    std::vector<char> m_buf;
+    PointLayout m_layout;
+    int m_x;
+};
+
+} // unnamed namespace
+
+// Check that pipelined execution processes points in order across
+// buffer boundaries, honors skips set by earlier stages and passes the
+// processed points through the caller's table.
+TEST(Streaming, pipelined)
+{
+    Options ro;
+    ro.add("bounds", BOX3D(0, 0, 0, 999, 999, 999));
+    ro.add("mode", "ramp");
+    ro.add("count", 1000);
+    FauxReader r;
+    r.setOptions(ro);
+
+    // Filter out odd points.
+    StreamCallbackFilter f1;
+    auto cb1 = [](PointRef& point)
+    {
+        return point.getFieldAs<int>(Dimension::Id::X) % 2 == 0;
+    };
+    f1.setCallback(cb1);
+    f1.setInput(r);
+
+    StreamCallbackFilter f2;
+    int cnt = 0;
+    int x = 0;
+    auto cb2 = [&cnt, &x](PointRef& point)
+    {
+        EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::X), x);
+        x += 2;
+        cnt++;
+        return true;
+    };
+    f2.setCallback(cb2);
+    f2.setInput(f1);
+
+    CheckTable t(7);
+    f2.prepare(t);
+    f2.executePipelined(t, 3);
+    EXPECT_EQ(cnt, 500);
+    EXPECT_EQ(t.m_cnt, 500);
+}
+
+namespace
+{
+
 class R : public Reader, public Streamable
 {
 
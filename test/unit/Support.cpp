@@ -36,6 +36,7 @@
 
 #include "Support.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -43,6 +44,8 @@
 
 #include <pdal/Options.hpp>
 #include <pdal/PDALUtils.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
 #include <pdal/Stage.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -389,6 +392,119 @@ void compareBounds(const BOX3D& p, const BOX3D& q)
     EXPECT_DOUBLE_EQ(p.maxz, q.maxz);
 }
 
+std::vector<char> packedPoints(Stage& stage, point_count_t *count)
+{
+    PointTable table;
+    stage.prepare(table);
+    PointViewSet viewSet = stage.execute(table);
+
+    const DimTypeList dims = table.layout()->dimTypes();
+    const size_t pointSize = table.layout()->pointSize();
+    std::vector<char> data;
+    for (const PointViewPtr& view : viewSet)
+    {
+        size_t pos = data.size();
+        data.resize(pos + view->size() * pointSize);
+        for (PointId i = 0; i < view->size(); ++i)
+            view->getPackedPoint(dims, i, data.data() + pos + i * pointSize);
+    }
+    if (count)
+        *count = data.size() / pointSize;
+    return data;
+}
+
+namespace
+{
+
+// Sum of the bits of the X, Y and Z values of points.
+class XyzSum
+{
+public:
+    XyzSum() : m_count(0), m_sum(0)
+    {}
+
+    void add(const PointRef& point)
+    {
+        using namespace Dimension;
+
+        for (Id id : { Id::X, Id::Y, Id::Z })
+        {
+            double d = point.getFieldAs<double>(id);
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            m_sum += bits * ((uint64_t)id + 1);
+        }
+        m_count++;
+    }
+
+    std::pair<point_count_t, uint64_t> result() const
+        { return std::make_pair(m_count, m_sum); }
+
+private:
+    point_count_t m_count;
+    uint64_t m_sum;
+};
+
+class XyzSumTable : public StreamPointTable
+{
+public:
+    XyzSumTable(XyzSum& sum) : StreamPointTable(m_layout, 1000), m_sum(sum)
+    {}
+
+    virtual void finalize()
+    {
+        if (!m_layout.finalized())
+        {
+            BasePointTable::finalize();
+            m_buf.resize(pointsToBytes(capacity() + 1));
+        }
+    }
+
+protected:
+    virtual void reset()
+    {
+        PointRef point(*this, 0);
+        for (PointId idx = 0; idx < numPoints(); ++idx)
+        {
+            if (skip(idx))
+                continue;
+            point.setPointId(idx);
+            m_sum.add(point);
+        }
+        std::fill(m_buf.begin(), m_buf.end(), 0);
+    }
+
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+
+private:
+    XyzSum& m_sum;
+    std::vector<char> m_buf;
+    PointLayout m_layout;
+};
+
+} // unnamed namespace
+
+std::pair<point_count_t, uint64_t> xyzChecksum(Stage& stage, bool stream)
+{
+    XyzSum sum;
+    if (stream)
+    {
+        XyzSumTable table(sum);
+        stage.prepare(table);
+        stage.execute(table);
+    }
+    else
+    {
+        PointTable table;
+        stage.prepare(table);
+        for (const PointViewPtr& view : stage.execute(table))
+            for (PointId idx = 0; idx < view->size(); ++idx)
+                sum.add(view->point(idx));
+    }
+    return sum.result();
+}
+
 // This provides no guarantees but is highly likely to work, and it's just for test purposes.
 Tempfile::Tempfile()
 {
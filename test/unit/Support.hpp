@@ -38,6 +38,8 @@
 
 #include <pdal/pdal_types.hpp>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace pdal
 {
@@ -122,6 +124,20 @@ void check_p100_p101_p102(const pdal::PointView& data);
 
 void compareBounds(const pdal::BOX3D& p, const pdal::BOX3D& q);
 
+// Execute a stage with a table of its own and return the packed data of
+// the points of its output views, so that the results of runs can be
+// compared after their tables are gone.  If 'count' isn't null, it's set
+// to the number of points.
+std::vector<char> packedPoints(pdal::Stage& stage,
+    pdal::point_count_t *count = nullptr);
+
+// Execute a stage with a table of its own and return the number of points
+// and a checksum of their X, Y and Z values that doesn't depend on the
+// order of the points.  If 'stream' is true, the stage is executed in
+// streaming mode.
+std::pair<pdal::point_count_t, uint64_t> xyzChecksum(pdal::Stage& stage,
+    bool stream);
+
 // This provides a reasonable temp filename. The file will be deleted (if it exists) when
 // the instance goes out of scope.
 class Tempfile
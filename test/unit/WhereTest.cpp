@@ -39,6 +39,9 @@
 #include <pdal/StageFactory.hpp>
 #include <pdal/Streamable.hpp>
 #include <pdal/util/Bounds.hpp>
+#include <filters/private/expr/ConditionalExpression.hpp>
+#include <filters/private/expr/MathExpression.hpp>
+#include <filters/private/expr/MathParser.hpp>
 
 namespace pdal
 {
@@ -288,4 +291,62 @@ TEST(WhereTest, writer)
     exec5("X<50 && Y < 2.5", 25);
 }
 
+// Make sure that evaluating expressions for blocks of points gives the
+// same result as evaluating them point by point.
+TEST(WhereTest, batch)
+{
+    StageFactory factory;
+
+    Stage *r = factory.createStage("readers.faux");
+    Options ro;
+    ro.add("count", 1000);
+    ro.add("bounds", BOX3D(0, 0, 100, 99, 9.9, 199));
+    ro.add("mode", "ramp");
+    r->setOptions(ro);
+
+    PointTable t;
+    r->prepare(t);
+    PointViewSet s = r->execute(t);
+    PointViewPtr v = *s.begin();
+
+    for (std::string text : { "X<50", "X<50 && Y < 2.5",
+        "!(Z >= 150) || X == 3", "-X + 2 * Y / (Z - 100) > 1",
+        "X != 4 && (Y <= 7 || !(Z > 2 + X))" })
+    {
+        expr::ConditionalExpression e;
+        EXPECT_TRUE((bool)Utils::fromString(text, e)) << text;
+        EXPECT_TRUE((bool)e.prepare(t.layout())) << text;
+
+        std::vector<char> pass;
+        e.eval(*v, 0, v->size(), pass);
+        ASSERT_EQ(pass.size(), v->size());
+        for (PointRef p : *v)
+            EXPECT_EQ((bool)pass[p.pointId()], e.eval(p)) << text;
+    }
+
+    for (std::string text : { "X * 2 - Y / (Z - 100)", "-(X + Y) * 3",
+        "5 - 2" })
+    {
+        expr::MathExpression e;
+        expr::Lexer lexer(text);
+        expr::MathParser parser(lexer);
+        EXPECT_TRUE(parser.expression(e) && parser.checkEnd()) << text;
+        EXPECT_TRUE((bool)e.prepare(t.layout())) << text;
+
+        std::vector<double> values;
+        e.eval(*v, 100, 700, values);
+        ASSERT_EQ(values.size(), 700u);
+        PointRef p(*v);
+        for (PointId i = 0; i < values.size(); ++i)
+        {
+            p.setPointId(i + 100);
+            double d = e.eval(p);
+            if (std::isnan(d))
+                EXPECT_TRUE(std::isnan(values[i])) << text;
+            else
+                EXPECT_DOUBLE_EQ(values[i], d) << text;
+        }
+    }
+}
+
 } // namespace pdal
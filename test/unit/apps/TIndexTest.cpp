@@ -31,8 +31,10 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include <pdal/pdal_test_main.hpp>
 
@@ -147,3 +149,71 @@ TEST(TIndex, test3)
 #endif
 }
 
+
+// Index with several threads, then index again.  Unchanged files shouldn't
+// be added a second time.
+TEST(TIndex, threads)
+{
+    std::string inSpec(Support::datapath("tindex/*.txt"));
+    std::string outSpec(Support::temppath("tindex.out"));
+    std::string outPoints(Support::temppath("points.txt"));
+
+    std::string cmd = Support::binpath("pdal") + " tindex create " +
+        outSpec + " \"" + inSpec + "\" --threads=2";
+
+    FileUtils::deleteDirectory(outSpec);
+
+    std::string output;
+    Utils::run_shell_command(cmd, output);
+    Utils::run_shell_command(cmd, output);
+
+    cmd = Support::binpath("pdal") + " --verbose=info tindex merge " +
+        outSpec + " " + outPoints + " --log=stdout "
+        "--bounds=\"([1.25, 3],[1.25, 3])\"";
+
+    FileUtils::deleteFile(outPoints);
+    Utils::run_shell_command(cmd, output);
+    std::string::size_type pos = output.find("Merge filecount: 3");
+    EXPECT_NE(pos, std::string::npos);
+
+    // A file that's modified on the same day is indexed again.  The
+    // default shapefile driver stores only the date in the modified field.
+    std::string dir(Support::temppath("tindex_mod"));
+    FileUtils::deleteDirectory(dir);
+    FileUtils::createDirectory(dir);
+    auto writeFile = [&dir](const std::string& name, int offset)
+    {
+        std::ostream *out = FileUtils::createFile(dir + "/" + name);
+        *out << "X Y Z\n";
+        for (int i = 0; i < 4; ++i)
+            *out << (offset + i % 2) << " " << (offset + i / 2) << " 0\n";
+        FileUtils::closeFile(out);
+    };
+    writeFile("a.txt", 1);
+    writeFile("b.txt", 5);
+
+    cmd = Support::binpath("pdal") + " --verbose=info tindex create " +
+        outSpec + " \"" + dir + "/*.txt\" --threads=2 --log=stdout";
+    FileUtils::deleteDirectory(outSpec);
+    Utils::run_shell_command(cmd, output);
+    EXPECT_NE(output.find("a.txt"), std::string::npos);
+    EXPECT_NE(output.find("b.txt"), std::string::npos);
+
+    Utils::run_shell_command(cmd, output);
+    EXPECT_EQ(output.find("Indexed file"), std::string::npos);
+
+    // Make sure the modification time changes.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    writeFile("a.txt", 2);
+    Utils::run_shell_command(cmd, output);
+    EXPECT_NE(output.find("a.txt"), std::string::npos);
+    EXPECT_EQ(output.find("b.txt"), std::string::npos);
+
+    // Only the new boundary of the modified file is in the bounds.
+    cmd = Support::binpath("pdal") + " --verbose=info tindex merge " +
+        outSpec + " " + outPoints + " --log=stdout "
+        "--bounds=\"([2.5, 3],[2.5, 3])\"";
+    FileUtils::deleteFile(outPoints);
+    Utils::run_shell_command(cmd, output);
+    EXPECT_NE(output.find("Merge filecount: 1"), std::string::npos);
+}
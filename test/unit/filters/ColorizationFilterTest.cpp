@@ -232,4 +232,81 @@ TEST(ColorizationFilterTest, test5)
     // expect input points that were translated out of the raster image area are not filtered out.
     EXPECT_NE(pointCount, 23u);
     EXPECT_EQ(pointCount, 106u);
-}
\ No newline at end of file
+}
+
+namespace
+{
+
+std::vector<uint16_t> colorize(const Options& filterOps, bool stream)
+{
+    Options readerOps;
+    readerOps.add("filename",
+        Support::datapath("autzen/autzen-point-format-3.las"));
+
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    ColorizationFilter filter;
+    filter.setOptions(filterOps);
+    filter.setInput(reader);
+
+    std::vector<uint16_t> reds;
+    if (stream)
+    {
+        StreamCallbackFilter f2;
+        f2.setInput(filter);
+        f2.setCallback([&reds](PointRef& point)
+        {
+            reds.push_back(point.getFieldAs<uint16_t>(Dimension::Id::Red));
+            return true;
+        });
+        FixedPointTable table(50);
+        f2.prepare(table);
+        f2.execute(table);
+    }
+    else
+    {
+        PointTable table;
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        PointViewPtr view = *viewSet.begin();
+        for (PointId i = 0; i < view->size(); ++i)
+            reds.push_back(view->getFieldAs<uint16_t>(Dimension::Id::Red, i));
+    }
+    return reds;
+}
+
+} // unnamed namespace
+
+// Points looked up in batches get the same values as points looked up
+// one at a time.
+TEST(ColorizationFilterTest, batch)
+{
+    Options options;
+    options.add("raster", Support::datapath("autzen/autzen.jpg"));
+
+    std::vector<uint16_t> batch = colorize(options, false);
+    std::vector<uint16_t> single = colorize(options, true);
+    EXPECT_EQ(batch.size(), 106u);
+    EXPECT_EQ(batch, single);
+}
+
+TEST(ColorizationFilterTest, bilinear)
+{
+    Options options;
+    options.add("raster", Support::datapath("autzen/autzen.jpg"));
+    std::vector<uint16_t> nearest = colorize(options, false);
+
+    options.add("sampling", "bilinear");
+    std::vector<uint16_t> bilinear = colorize(options, false);
+    EXPECT_EQ(bilinear, colorize(options, true));
+    ASSERT_EQ(nearest.size(), bilinear.size());
+    EXPECT_NE(nearest, bilinear);
+    EXPECT_EQ(nearest[0], 210u);
+    EXPECT_EQ(bilinear[0], 207u);
+    EXPECT_EQ(nearest[1], 76u);
+    EXPECT_EQ(bilinear[1], 74u);
+
+    options.replace("sampling", "cubic");
+    EXPECT_THROW(colorize(options, false), pdal_error);
+}
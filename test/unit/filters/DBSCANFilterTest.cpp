@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+ *       names of its contributors may be used to endorse or promote
+ *       products derived from this software without specific prior
+ *       written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#include <algorithm>
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <filters/DBSCANFilter.hpp>
+#include <io/BufferReader.hpp>
+#include <io/FauxReader.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+// Cluster points on a line along X.
+std::vector<int64_t> cluster(const std::vector<double>& xs, int threads)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({Id::X, Id::Y, Id::Z});
+
+    BufferReader br;
+    PointViewPtr src(new PointView(table));
+    for (PointId idx = 0; idx < xs.size(); ++idx)
+    {
+        src->setField(Id::X, idx, xs[idx]);
+        src->setField(Id::Y, idx, 0.0);
+        src->setField(Id::Z, idx, 0.0);
+    }
+    br.addView(src);
+
+    Options opts;
+    opts.add("min_points", 4);
+    opts.add("eps", 1.0);
+    opts.add("threads", threads);
+    DBSCANFilter filter;
+    filter.setInput(br);
+    filter.setOptions(opts);
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    std::vector<int64_t> labels;
+    for (PointId idx = 0; idx < view->size(); ++idx)
+        labels.push_back(view->getFieldAs<int64_t>(Id::ClusterID, idx));
+    return labels;
+}
+
+} // unnamed namespace
+
+TEST(DBSCANFilterTest, labels)
+{
+    // Two clusters of core points, a border point within reach of both
+    // clusters and noise.  The cluster at 2.7 has the smallest PointId,
+    // so it's numbered first and gets the border point.
+    std::vector<double> xs {
+        2.7, 3.0, 3.3, 3.6,     // Cluster 0
+        10.0,                   // Noise
+        1.8,                    // Border of both clusters
+        0.0, 0.3, 0.6, 0.9,     // Cluster 1
+        -5.0                    // Noise
+    };
+    std::vector<int64_t> expected { 0, 0, 0, 0, -1, 0, 1, 1, 1, 1, -1 };
+
+    EXPECT_EQ(cluster(xs, 1), expected);
+    EXPECT_EQ(cluster(xs, 4), expected);
+}
+
+TEST(DBSCANFilterTest, threads)
+{
+    auto run = [](int threads)
+    {
+        Options ro;
+        ro.add("mode", "random");
+        ro.add("bounds", BOX3D(0, 0, 0, 10, 10, 10));
+        ro.add("count", 5000);
+        ro.add("seed", 1234);
+        FauxReader r;
+        r.setOptions(ro);
+
+        Options fo;
+        fo.add("min_points", 5);
+        fo.add("eps", 0.6);
+        fo.add("threads", threads);
+        DBSCANFilter f;
+        f.setInput(r);
+        f.setOptions(fo);
+
+        PointTable table;
+        f.prepare(table);
+        PointViewSet viewSet = f.execute(table);
+        PointViewPtr view = *viewSet.begin();
+
+        std::vector<int64_t> labels;
+        for (PointId idx = 0; idx < view->size(); ++idx)
+            labels.push_back(
+                view->getFieldAs<int64_t>(Dimension::Id::ClusterID, idx));
+        return labels;
+    };
+
+    std::vector<int64_t> serial = run(1);
+    EXPECT_EQ(serial.size(), 5000u);
+    EXPECT_NE(std::count(serial.begin(), serial.end(), -1), 5000);
+    EXPECT_EQ(serial, run(4));
+}
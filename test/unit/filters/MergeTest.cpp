@@ -94,3 +94,30 @@ TEST(MergeTest, test6)
     PointViewPtr view = *viewSet.begin();
     EXPECT_EQ(2130u, view->size());
 }
+
+TEST(MergeTest, concurrent)
+{
+    using namespace pdal;
+
+    PipelineManager mgr;
+    mgr.readPipeline(Support::configuredpath("filters/merge.json"));
+    mgr.execute();
+    PointViewPtr view = *mgr.views().begin();
+
+    PipelineManager mgr2;
+    mgr2.setThreads(4);
+    mgr2.readPipeline(Support::configuredpath("filters/merge.json"));
+    mgr2.execute();
+
+    PointViewSet viewSet = mgr2.views();
+    EXPECT_EQ(1u, viewSet.size());
+    PointViewPtr view2 = *viewSet.begin();
+    ASSERT_EQ(view->size(), view2->size());
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+            view2->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::GpsTime, i),
+            view2->getFieldAs<double>(Dimension::Id::GpsTime, i));
+    }
+}
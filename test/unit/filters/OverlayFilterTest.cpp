@@ -36,6 +36,7 @@
 
 #include <pdal/StageFactory.hpp>
 #include <pdal/util/FileUtils.hpp>
+#include <io/BufferReader.hpp>
 
 #include "Support.hpp"
 
@@ -162,3 +163,62 @@ TEST(OverlayFilterTest, stream)
 {
     testOverlay(10, true);
 }
+
+// Points covered by more than one polygon take the value of the first.
+TEST(OverlayFilterTest, order)
+{
+    std::string datasource(Support::temppath("overlay_order.geojson"));
+    FileUtils::deleteFile(datasource);
+    std::ostream *out = FileUtils::createFile(datasource);
+    *out << R"({
+        "type": "FeatureCollection",
+        "features": [
+            { "type": "Feature", "properties": { "cls": 2 },
+              "geometry": { "type": "Polygon", "coordinates":
+                [[[0, 0], [6, 0], [6, 6], [0, 6], [0, 0]]] } },
+            { "type": "Feature", "properties": { "cls": 5 },
+              "geometry": { "type": "Polygon", "coordinates":
+                [[[4, 4], [10, 4], [10, 10], [4, 10], [4, 4]]] } }
+        ]
+    })";
+    FileUtils::closeFile(out);
+
+    const std::vector<std::pair<double, int>> expected
+        { { 1, 2 }, { 5, 2 }, { 9, 5 }, { 20, 0 } };
+
+    PointTable table;
+    table.layout()->registerDims({ Dimension::Id::X, Dimension::Id::Y,
+        Dimension::Id::Classification });
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < expected.size(); ++i)
+    {
+        view->setField(Dimension::Id::X, i, expected[i].first);
+        view->setField(Dimension::Id::Y, i, expected[i].first);
+    }
+    // Inside the extent of the polygons but not inside either.
+    view->setField(Dimension::Id::X, expected.size(), 9);
+    view->setField(Dimension::Id::Y, expected.size(), 1);
+
+    BufferReader r;
+    r.addView(view);
+
+    Options fo;
+    fo.add("dimension", "Classification");
+    fo.add("column", "cls");
+    fo.add("datasource", datasource);
+
+    StageFactory factory;
+    Stage& f = *(factory.createStage("filters.overlay"));
+    f.setInput(r);
+    f.setOptions(fo);
+    f.prepare(table);
+    PointViewSet s = f.execute(table);
+    PointViewPtr v = *s.begin();
+    ASSERT_EQ(v->size(), expected.size() + 1);
+    for (PointId i = 0; i < expected.size(); ++i)
+        EXPECT_EQ(v->getFieldAs<int>(Dimension::Id::Classification, i),
+            expected[i].second);
+    EXPECT_EQ(v->getFieldAs<int>(Dimension::Id::Classification,
+        expected.size()), 0);
+    FileUtils::deleteFile(datasource);
+}
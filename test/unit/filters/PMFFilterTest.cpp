@@ -33,6 +33,7 @@
  ****************************************************************************/
 
 #include <filters/PMFFilter.hpp>
+#include <io/LasReader.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/pdal_test_main.hpp>
 
@@ -102,3 +103,50 @@ TEST(PMFFilterTest, classOneAndTwoOnly)
     EXPECT_EQ(v->size(), 110000u);
     EXPECT_EQ(classZero, 0u);
 }
+
+TEST(PMFFilterTest, tiles)
+{
+    auto classify = [](const Options& fOpts)
+    {
+        Options rOpts;
+        rOpts.add("filename", Support::datapath("las/autzen_trim.las"));
+        LasReader r;
+        r.setOptions(rOpts);
+
+        PMFFilter f;
+        f.setOptions(fOpts);
+        f.setInput(r);
+
+        PointTable t;
+        f.prepare(t);
+        PointViewSet s = f.execute(t);
+        PointViewPtr v = *s.begin();
+
+        std::vector<uint8_t> classes;
+        for (PointId idx = 0; idx < v->size(); ++idx)
+            classes.push_back(
+                v->getFieldAs<uint8_t>(Dimension::Id::Classification, idx));
+        return classes;
+    };
+
+    std::vector<uint8_t> whole = classify(Options());
+
+    // Raster operations split over threads give the same results.
+    Options threadOpts;
+    threadOpts.add("threads", 3);
+    EXPECT_EQ(whole, classify(threadOpts));
+
+    // A single tile sees all the points.
+    Options opts;
+    opts.add("tile_size", 100000.0);
+    EXPECT_EQ(whole, classify(opts));
+
+    // Results don't depend on the order in which tiles are processed.
+    Options tileOpts;
+    tileOpts.add("tile_size", 500.0);
+    tileOpts.add("tile_buffer", 100.0);
+    std::vector<uint8_t> tiled = classify(tileOpts);
+    EXPECT_EQ(tiled.size(), whole.size());
+    tileOpts.add("threads", 3);
+    EXPECT_EQ(tiled, classify(tileOpts));
+}
@@ -36,6 +36,7 @@
 
 #include <pdal/SpatialReference.hpp>
 #include <pdal/PointView.hpp>
+#include <io/BufferReader.hpp>
 #include <io/LasReader.hpp>
 #include <filters/ReprojectionFilter.hpp>
 #include <filters/StreamCallbackFilter.hpp>
@@ -227,3 +228,55 @@ TEST(ReprojectionFilterTest, stream_test_2)
     f.prepare(table3);
     f.execute(table3);
 }
+
+
+// Make sure that splitting a view between threads gives the same result
+// as transforming it in one thread.
+TEST(ReprojectionFilterTest, threads)
+{
+    // The returned view refers to the table, so the caller keeps it.
+    auto run = [](PointTable& table, int threads)
+    {
+        table.layout()->registerDims(
+            { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z });
+        PointViewPtr view(new PointView(table));
+        for (PointId i = 0; i < 250000; ++i)
+        {
+            view->setField(Dimension::Id::X, i, 470000 + (i % 1000));
+            view->setField(Dimension::Id::Y, i, 4600000 + (i / 1000));
+            view->setField(Dimension::Id::Z, i, (double)(i % 100));
+        }
+
+        BufferReader reader;
+        reader.addView(view);
+
+        Options opts;
+        opts.add("in_srs", "EPSG:26915");
+        opts.add("out_srs", "EPSG:4326");
+        opts.add("threads", threads);
+        ReprojectionFilter filter;
+        filter.setOptions(opts);
+        filter.setInput(reader);
+
+        filter.prepare(table);
+        PointViewSet s = filter.execute(table);
+        EXPECT_EQ(s.size(), 1u);
+        return *s.begin();
+    };
+
+    PointTable t1;
+    PointTable t2;
+    PointViewPtr v1 = run(t1, 1);
+    PointViewPtr v2 = run(t2, 3);
+    ASSERT_EQ(v1->size(), 250000u);
+    ASSERT_EQ(v2->size(), v1->size());
+    for (PointId i = 0; i < v1->size(); ++i)
+    {
+        EXPECT_EQ(v1->getFieldAs<double>(Dimension::Id::X, i),
+            v2->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_EQ(v1->getFieldAs<double>(Dimension::Id::Y, i),
+            v2->getFieldAs<double>(Dimension::Id::Y, i));
+        EXPECT_EQ(v1->getFieldAs<double>(Dimension::Id::Z, i),
+            v2->getFieldAs<double>(Dimension::Id::Z, i));
+    }
+}
@@ -35,6 +35,7 @@
 #include <pdal/pdal_test_main.hpp>
 #include <pdal/StageFactory.hpp>
 #include <filters/SMRFilter.hpp>
+#include <io/LasReader.hpp>
 
 #include "Support.hpp"
 
@@ -94,3 +95,52 @@ TEST(SMRFFilterTest, noreturns)
     EXPECT_EQ(classCount.size(), 1U);
     EXPECT_EQ(classCount[ClassLabel::Ground], 10);
 }
+
+TEST(SMRFFilterTest, tiles)
+{
+    auto classify = [](const Options& fOpts)
+    {
+        Options rOpts;
+        rOpts.add("filename", Support::datapath("las/autzen_trim.las"));
+        LasReader r;
+        r.setOptions(rOpts);
+
+        SMRFilter f;
+        f.setOptions(fOpts);
+        f.setInput(r);
+
+        PointTable t;
+        f.prepare(t);
+        PointViewSet s = f.execute(t);
+        PointViewPtr v = *s.begin();
+
+        std::vector<uint8_t> classes;
+        for (PointId idx = 0; idx < v->size(); ++idx)
+            classes.push_back(
+                v->getFieldAs<uint8_t>(Dimension::Id::Classification, idx));
+        return classes;
+    };
+
+    std::vector<uint8_t> whole = classify(Options());
+
+    // A single tile sees all the points.
+    Options opts;
+    opts.add("tile_size", 100000.0);
+    EXPECT_EQ(whole, classify(opts));
+
+    // Results don't depend on the order in which tiles are processed.
+    Options tileOpts;
+    tileOpts.add("tile_size", 500.0);
+    tileOpts.add("tile_buffer", 100.0);
+    std::vector<uint8_t> tiled = classify(tileOpts);
+    tileOpts.add("threads", 3);
+    EXPECT_EQ(tiled, classify(tileOpts));
+
+    // Tiles only differ from the whole near their edges.
+    ASSERT_EQ(whole.size(), tiled.size());
+    size_t same = 0;
+    for (size_t i = 0; i < whole.size(); ++i)
+        if (whole[i] == tiled[i])
+            same++;
+    EXPECT_GT(same, whole.size() * 9 / 10);
+}
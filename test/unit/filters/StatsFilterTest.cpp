@@ -34,7 +34,10 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <random>
+#include <vector>
 
 #include <pdal/PDALUtils.hpp>
 #include <pdal/StageFactory.hpp>
@@ -504,3 +507,121 @@ TEST(Stats, merge)
             EXPECT_EQ(wm[(double)i], pm[(double)i]);
     }
 }
+
+TEST(Stats, sketch)
+{
+    BOX3D bounds(0.0, 0.0, 0.0, 100.0, 1000.0, 10000.0);
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("count", 100001);
+    ops.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    Options filterOps;
+    filterOps.add("dimensions", "X, Y, Z");
+    filterOps.add("global", "X");
+    filterOps.add("sketch", "Y, Z");
+    filterOps.add("sketch_error", .005);
+    filterOps.add("quantiles", "0.1, 0.9");
+
+    StatsFilter filter;
+    filter.setInput(reader);
+    filter.setOptions(filterOps);
+
+    PointTable table;
+    filter.prepare(table);
+    filter.execute(table);
+
+    // Values are evenly spaced, so a rank error translates directly to
+    // a fraction of the range.
+    const stats::Summary& statsX = filter.getStats(Dimension::Id::X);
+    EXPECT_NEAR(statsX.median(), 50.0, 1e-9);
+    EXPECT_NEAR(statsX.mad(), 25.0, 1e-9);
+    EXPECT_NEAR(statsX.quantile(.1), 10.0, 1e-9);
+    EXPECT_NEAR(statsX.quantile(.9), 90.0, 1e-9);
+
+    const stats::Summary& statsZ = filter.getStats(Dimension::Id::Z);
+    EXPECT_EQ(statsZ.count(), 100001u);
+    EXPECT_NEAR(statsZ.median(), 5000.0, 100.0);
+    EXPECT_NEAR(statsZ.mad(), 2500.0, 100.0);
+    EXPECT_NEAR(statsZ.quantile(.1), 1000.0, 100.0);
+    EXPECT_NEAR(statsZ.quantile(.9), 9000.0, 100.0);
+
+    MetadataNode y;
+    for (MetadataNode& n : filter.getMetadata().children("statistic"))
+        if (n.findChild("name").value() == "Y")
+            y = n;
+    std::vector<MetadataNode> quantiles = y.children("quantiles");
+    ASSERT_EQ(quantiles.size(), 2u);
+    EXPECT_DOUBLE_EQ(quantiles[0].findChild("quantile").value<double>(), 0.1);
+    EXPECT_NEAR(quantiles[0].findChild("value").value<double>(), 100.0, 10.0);
+}
+
+// The median absolute deviation of data that isn't symmetric about its
+// median.
+TEST(Stats, globalMad)
+{
+    auto mad = [](const std::vector<double>& data)
+    {
+        stats::Summary s("test", stats::Summary::Global, false);
+        for (double d : data)
+            s.insert(d);
+        s.computeGlobalStats();
+        return s.mad();
+    };
+
+    EXPECT_DOUBLE_EQ(mad({ 11, 1, 10, 3, 2 }), 2.0);
+    EXPECT_DOUBLE_EQ(mad({ 20, 1, 2, 11, 3, 10 }), 8.0);
+    EXPECT_DOUBLE_EQ(mad({ 5 }), 0.0);
+
+    // Compare with the deviations computed and sorted directly.
+    std::mt19937 gen(2718);
+    std::exponential_distribution<double> dis(.1);
+    for (size_t count : { 2, 7, 100, 1001 })
+    {
+        std::vector<double> data;
+        for (size_t i = 0; i < count; ++i)
+            data.push_back(std::floor(dis(gen)));
+        std::vector<double> sorted(data);
+        std::sort(sorted.begin(), sorted.end());
+        double median = sorted[count / 2];
+        std::vector<double> devs;
+        for (double d : data)
+            devs.push_back(std::fabs(d - median));
+        std::sort(devs.begin(), devs.end());
+        EXPECT_DOUBLE_EQ(mad(data), devs[count / 2]);
+    }
+}
+
+TEST(Stats, sketchMerge)
+{
+    std::mt19937 gen(314159);
+    std::normal_distribution<double> dis(100, 15);
+
+    using SummaryPtr = std::unique_ptr<stats::Summary>;
+    std::array<SummaryPtr, 10> parts;
+    for (SummaryPtr& part : parts)
+        part.reset(new stats::Summary("test", stats::Summary::Sketch, false));
+    stats::Summary whole("test", stats::Summary::Global, false);
+
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        double d = dis(gen);
+        whole.insert(d);
+        parts[i % 10]->insert(d);
+    }
+    for (size_t i = 1; i < 10; ++i)
+        parts[0]->merge(*parts[i]);
+
+    stats::Summary& p = *parts[0];
+    whole.computeGlobalStats();
+    p.computeGlobalStats();
+
+    EXPECT_EQ(whole.count(), p.count());
+    EXPECT_NEAR(whole.median(), p.median(), .5);
+    EXPECT_NEAR(whole.mad(), p.mad(), .5);
+    EXPECT_NEAR(whole.quantile(.05), p.quantile(.05), 1.0);
+    EXPECT_NEAR(whole.quantile(.95), p.quantile(.95), 1.0);
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+ *       names of its contributors may be used to endorse or promote
+ *       products derived from this software without specific prior
+ *       written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <io/private/ContentCache.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "Support.hpp"
+
+namespace pdal
+{
+
+TEST(ContentCacheTest, lru)
+{
+    const std::string dir(Support::temppath("contentcache"));
+    FileUtils::deleteDirectory(dir);
+
+    auto item = [](char c)
+        { return std::vector<char>(400, c); };
+    std::vector<char> data;
+
+    {
+        ContentCache cache(dir, 1000);
+        cache.put("a", item('a'));
+        cache.put("b", item('b'));
+        EXPECT_TRUE(cache.get("a", data));
+        EXPECT_EQ(data, item('a'));
+
+        // "b" is the least recently used item, so it's evicted.
+        cache.put("c", item('c'));
+        EXPECT_FALSE(cache.get("b", data));
+        EXPECT_TRUE(cache.get("a", data));
+        EXPECT_TRUE(cache.get("c", data));
+        EXPECT_LE(cache.size(), 1000u);
+
+        // Too large to cache.
+        cache.put("d", std::vector<char>(2000, 'd'));
+        EXPECT_FALSE(cache.get("d", data));
+    }
+
+    // The items and their order persist.
+    {
+        ContentCache cache(dir, 1000);
+        EXPECT_TRUE(cache.get("a", data));
+        EXPECT_EQ(data, item('a'));
+        cache.put("e", item('e'));
+        EXPECT_FALSE(cache.get("c", data));
+        EXPECT_TRUE(cache.get("a", data));
+        EXPECT_TRUE(cache.get("e", data));
+        EXPECT_EQ(data, item('e'));
+    }
+
+    // A smaller limit evicts items when the cache is opened.
+    {
+        ContentCache cache(dir, 500);
+        EXPECT_TRUE(cache.get("e", data));
+        EXPECT_FALSE(cache.get("a", data));
+    }
+    FileUtils::deleteDirectory(dir);
+}
+
+} // namespace pdal
@@ -39,6 +39,7 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <io/CopcReader.hpp>
+#include <io/private/copc/Connector.hpp>
 #include <io/LasReader.hpp>
 #include <filters/CropFilter.hpp>
 #include <filters/ReprojectionFilter.hpp>
@@ -678,4 +679,55 @@ TEST(CopcReaderTest, ogrCrop)
     EXPECT_LE(v->size(), 90u);
 }
 
+TEST(CopcReaderTest, memoryLimit)
+{
+    // Read with a limit of 1MB, smaller than the larger tiles, so that
+    // at most one tile is pending at a time, and without a practical
+    // limit.
+    auto read = [](size_t limit, bool stream)
+    {
+        Options options;
+        options.add("filename", copcPath);
+        options.add("memory_limit", limit);
+        CopcReader reader;
+        reader.setOptions(options);
+        return Support::xyzChecksum(reader, stream);
+    };
+
+    for (bool stream : { false, true })
+    {
+        std::pair<point_count_t, uint64_t> limited = read(1, stream);
+        std::pair<point_count_t, uint64_t> unlimited = read(100000, stream);
+        EXPECT_EQ(limited.first, numPoints);
+        EXPECT_EQ(limited, unlimited);
+    }
+}
+
+TEST(CopcReaderTest, getBinaryRanges)
+{
+    copc::Connector connector(copcPath, StringMap(), StringMap());
+    const uint64_t gap = copc::Connector::MaxGap;
+
+    // Ranges out of order, separated by gaps below, at and above the
+    // largest gap that's read, overlapping, and empty.
+    std::vector<copc::ByteRange> ranges {
+        { 1000, 500 },
+        { 0, 400 },
+        { 1600, 300 },
+        { 1900 + gap, 100 },
+        { 2000 + 3 * gap, 1000 },
+        { 2500 + 3 * gap, 1000 },
+        { 100000 + 4 * gap, 0 },
+        { 100000 + 5 * gap, 20 }
+    };
+    std::vector<std::vector<char>> bufs = connector.getBinary(ranges);
+    ASSERT_EQ(bufs.size(), ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        const copc::ByteRange& r = ranges[i];
+        EXPECT_EQ(bufs[i].size(), (size_t)r.m_size);
+        EXPECT_EQ(bufs[i], connector.getBinary(r.m_offset, r.m_size));
+    }
+}
+
 } // namespace pdal
@@ -0,0 +1,211 @@
+/******************************************************************************
+ * Copyright (c) 2021, Hobu Inc. (info@hobu.co)
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+ *       names of its contributors may be used to endorse or promote
+ *       products derived from this software without specific prior
+ *       written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+
+#include <algorithm>
+#include <tuple>
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <io/CopcReader.hpp>
+#include <io/CopcWriter.hpp>
+#include <io/FauxReader.hpp>
+#include <io/LasReader.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "Support.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+using PointTuple = std::tuple<int, int, int, int, int, int, double>;
+
+// Collect rounded coordinates and some attributes of the points of a view
+// in an order that doesn't depend on the order of the points.
+std::vector<PointTuple> sortedPoints(const PointViewPtr& view)
+{
+    std::vector<PointTuple> points;
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        PointRef p(*view, i);
+        auto get = [&p](Dimension::Id id)
+            { return p.hasDim(id) ? p.getFieldAs<double>(id) : 0.0; };
+        points.push_back(std::make_tuple(
+            (int)std::lround(get(Dimension::Id::X) * 100),
+            (int)std::lround(get(Dimension::Id::Y) * 100),
+            (int)std::lround(get(Dimension::Id::Z) * 100),
+            (int)get(Dimension::Id::Intensity),
+            (int)get(Dimension::Id::ReturnNumber),
+            (int)get(Dimension::Id::Red),
+            get(Dimension::Id::GpsTime)));
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+}
+
+// The view refers to the caller's table, which must outlive it.
+PointViewPtr readCopc(PointTableRef table, const std::string& filename)
+{
+    Options opts;
+    opts.add("filename", filename);
+
+    CopcReader reader;
+    reader.setOptions(opts);
+
+    reader.prepare(table);
+    PointViewSet s = reader.execute(table);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+} // unnamed namespace
+
+TEST(CopcWriterTest, roundtrip)
+{
+    const std::string outfile(Support::temppath("copc_roundtrip.copc.laz"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("threads", 3);
+    CopcWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    PointTable table;
+    writer.prepare(table);
+    PointViewSet s = writer.execute(table);
+    PointViewPtr in = *s.begin();
+
+    PointTable outTable;
+    PointViewPtr out = readCopc(outTable, outfile);
+    EXPECT_EQ(out->size(), in->size());
+    EXPECT_EQ(out->layout()->hasDim(Dimension::Id::Red), true);
+    EXPECT_TRUE(sortedPoints(in) == sortedPoints(out));
+
+    FileUtils::deleteFile(outfile);
+}
+
+// Use a small memory limit so that points are spilled to disk while the
+// tree is built.
+TEST(CopcWriterTest, spill)
+{
+    const std::string outfile(Support::temppath("copc_spill.copc.laz"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("count", 200000);
+    readerOps.add("mode", "uniform");
+    readerOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 100));
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("memory_limit", 2);
+    writerOps.add("temp_dir", Support::temppath());
+    CopcWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    PointTable table;
+    writer.prepare(table);
+    PointViewSet s = writer.execute(table);
+    PointViewPtr in = *s.begin();
+
+    PointTable outTable;
+    PointViewPtr out = readCopc(outTable, outfile);
+    EXPECT_EQ(out->size(), in->size());
+    EXPECT_TRUE(sortedPoints(in) == sortedPoints(out));
+    EXPECT_FALSE(FileUtils::fileExists(
+        Support::temppath("copc_spill.copc.laz.tmp")));
+
+    FileUtils::deleteFile(outfile);
+}
+
+TEST(CopcWriterTest, stream)
+{
+    const std::string outfile(Support::temppath("copc_stream.copc.laz"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/autzen_trim.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    CopcWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    FixedPointTable table(1000);
+    writer.prepare(table);
+    writer.execute(table);
+
+    QuickInfo qi = reader.preview();
+    PointTable outTable;
+    PointViewPtr out = readCopc(outTable, outfile);
+    EXPECT_EQ(out->size(), qi.m_pointCount);
+
+    FileUtils::deleteFile(outfile);
+}
+
+TEST(CopcWriterTest, options)
+{
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/simple.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", Support::temppath("copc_options.copc.laz"));
+    writerOps.add("pdrf", 3);
+    CopcWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    PointTable table;
+    EXPECT_THROW(writer.prepare(table), pdal_error);
+}
+
+} // namespace pdal
@@ -557,6 +557,30 @@ void streamTest(const std::string src)
     }
 }
 
+TEST(EptReaderTest, memoryLimit)
+{
+    // Read with a limit of 1MB, smaller than the larger tiles, so that
+    // at most one tile is pending at a time, and without a practical
+    // limit.
+    auto read = [](size_t limit, bool stream)
+    {
+        Options options;
+        options.add("filename", eptLaszipPath);
+        options.add("memory_limit", limit);
+        EptReader reader;
+        reader.setOptions(options);
+        return Support::xyzChecksum(reader, stream);
+    };
+
+    for (bool stream : { false, true })
+    {
+        std::pair<point_count_t, uint64_t> limited = read(1, stream);
+        std::pair<point_count_t, uint64_t> unlimited = read(100000, stream);
+        EXPECT_EQ(limited.first, expNumPoints);
+        EXPECT_EQ(limited, unlimited);
+    }
+}
+
 TEST(EptReaderTest, binaryStream)
 {
     streamTest(ellipsoidEptBinaryPath);
@@ -940,4 +940,93 @@ TEST(GDALWriterTest, testMetadata)
 
 }
 
+// Make sure that a grid that spills its tiles to a scratch file gives the
+// same result as one held in memory.
+TEST(GDALWriterTest, tiles)
+{
+    std::string scratch = Support::temppath("grid.tmp");
+
+    {
+        // Tiles of 3x3 cells and a tiny memory limit force tiles to be
+        // written and read back.
+        GDALGrid g1(0, 0, 20, 15, 1, 1.5, ~0, 2, 1.0);
+        GDALGrid g2(0, 0, 20, 15, 1, 1.5, ~0, 2, 1.0, 3, 1, scratch);
+        for (int i = 0; i < 2000; ++i)
+        {
+            double x = (i * 37 % 200) / 10.0;
+            double y = (i * 53 % 150) / 10.0;
+            double z = i % 17;
+
+            // Leave a hole to be filled from neighboring cells.
+            if (x >= 5 && x < 8 && y >= 5 && y < 8)
+                continue;
+            g1.addPoint(x, y, z);
+            g2.addPoint(x, y, z);
+        }
+        g1.finalize();
+        g2.finalize();
+        EXPECT_TRUE(FileUtils::fileExists(scratch));
+
+        for (const char *name : { "min", "max", "mean", "idw", "count",
+            "stdev" })
+        {
+            ASSERT_TRUE(g1.hasBand(name));
+            ASSERT_TRUE(g2.hasBand(name));
+            GDALGrid::BandIterator i1 = g1.band(name);
+            GDALGrid::BandIterator i2 = g2.band(name);
+            for (int i = 0; i < 20 * 15; ++i, ++i1, ++i2)
+            {
+                if (std::isnan(*i1))
+                    EXPECT_TRUE(std::isnan(*i2));
+                else
+                    EXPECT_NEAR(*i1, *i2, 1e-9) << name << " " << i;
+            }
+        }
+    }
+    EXPECT_FALSE(FileUtils::fileExists(scratch));
+}
+
+// Make sure that adding points and finalizing with several threads gives
+// the same result as a single thread.
+TEST(GDALWriterTest, threads)
+{
+    const point_count_t count = 300000;
+    auto get = [](PointId begin, point_count_t n, double *x, double *y,
+        double *z)
+    {
+        for (point_count_t i = 0; i < n; ++i)
+        {
+            PointId id = begin + i;
+            x[i] = (id * 7919 % 100000) / 1000.0;
+            y[i] = (id * 104729 % 80000) / 1000.0;
+            z[i] = (double)(id % 101);
+            // Leave a hole to be filled from neighboring cells.
+            if (x[i] >= 40 && x[i] < 45 && y[i] >= 40 && y[i] < 45)
+                x[i] = 0;
+        }
+    };
+
+    GDALGrid g1(0, 0, 100, 80, 1, 1.2, ~0, 3, 2.0, 16);
+    GDALGrid g2(0, 0, 100, 80, 1, 1.2, ~0, 3, 2.0, 16);
+    g2.setThreads(3);
+    g1.addPoints(count, get);
+    g2.addPoints(count, get);
+    g1.finalize();
+    g2.finalize();
+
+    for (const char *name : { "min", "max", "mean", "idw", "count", "stdev" })
+    {
+        GDALGrid::BandIterator i1 = g1.band(name);
+        GDALGrid::BandIterator i2 = g2.band(name);
+        for (int i = 0; i < 100 * 80; ++i, ++i1, ++i2)
+        {
+            if (std::isnan(*i1))
+                EXPECT_TRUE(std::isnan(*i2));
+            else
+                EXPECT_NEAR(*i1, *i2, 1e-7 * (1 + std::fabs(*i1))) <<
+                    name << " " << i;
+        }
+    }
+}
+
 } // namespace pdal
@@ -413,8 +413,67 @@ TEST(LasReaderTest, lazperf)
        EXPECT_EQ(memcmp(buf1.get(), buf2.get(), pointSize), 0);
     }
 }
+
+TEST(LasReaderTest, lazperfThreads)
+{
+    auto readPoints = [](int threads, int start, point_count_t& count)
+    {
+        Options opts;
+        opts.add("filename", Support::datapath("laz/autzen_trim.laz"));
+        opts.add("compression", "lazperf");
+        opts.add("threads", threads);
+        opts.add("start", start);
+
+        LasReader reader;
+        reader.setOptions(opts);
+        return Support::packedPoints(reader, &count);
+    };
+
+    for (int start : { 0, 49999, 50000, 75000 })
+    {
+        point_count_t serialCount;
+        point_count_t parallelCount;
+        std::vector<char> serial = readPoints(1, start, serialCount);
+        std::vector<char> parallel = readPoints(4, start, parallelCount);
+        EXPECT_EQ(serialCount, (point_count_t)(110000 - start));
+        EXPECT_EQ(serialCount, parallelCount);
+        EXPECT_TRUE(serial == parallel);
+    }
+}
 #endif
 
+TEST(LasReaderTest, mmap)
+{
+    auto readPoints = [](bool useMmap, int threads, int start,
+        point_count_t& count)
+    {
+        Options opts;
+        opts.add("filename", Support::datapath("las/autzen_trim.las"));
+        opts.add("use_mmap", useMmap);
+        opts.add("threads", threads);
+        opts.add("start", start);
+
+        LasReader reader;
+        reader.setOptions(opts);
+        return Support::packedPoints(reader, &count);
+    };
+
+    for (int start : { 0, 12345 })
+    {
+        point_count_t c1;
+        point_count_t c2;
+        point_count_t c3;
+        std::vector<char> v1 = readPoints(false, 1, start, c1);
+        std::vector<char> v2 = readPoints(true, 1, start, c2);
+        std::vector<char> v3 = readPoints(true, 3, start, c3);
+        EXPECT_EQ(c1, (point_count_t)(110000 - start));
+        EXPECT_EQ(c1, c2);
+        EXPECT_EQ(c1, c3);
+        EXPECT_TRUE(v1 == v2);
+        EXPECT_TRUE(v1 == v3);
+    }
+}
+
 void streamTest(const std::string src, const std::string compression)
 {
     Options ops1;
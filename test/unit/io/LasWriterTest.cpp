@@ -1106,6 +1106,53 @@ TEST(LasWriterTest, stream)
     compareFiles(infile, outfile);
 }
 
+#ifdef PDAL_HAVE_LAZPERF
+// Output from the threaded compressor should be identical to that of the
+// serial compressor.
+TEST(LasWriterTest, lazperfThreads)
+{
+    std::string infile(Support::datapath("las/autzen_trim.las"));
+
+    auto write = [&infile](const std::string& outfile, int threads)
+    {
+        FileUtils::deleteFile(outfile);
+
+        Options readerOps;
+        readerOps.add("filename", infile);
+
+        LasReader r;
+        r.setOptions(readerOps);
+
+        Options writerOps;
+        writerOps.add("filename", outfile);
+        writerOps.add("compression", "lazperf");
+        writerOps.add("chunk_size", 7000);
+        writerOps.add("threads", threads);
+        writerOps.add("creation_doy", 100);
+        writerOps.add("creation_year", 2021);
+
+        LasWriter w;
+        w.setOptions(writerOps);
+        w.setInput(r);
+
+        PointTable t;
+        w.prepare(t);
+        w.execute(t);
+    };
+
+    std::string serial(Support::temppath("serial.laz"));
+    std::string parallel(Support::temppath("parallel.laz"));
+    write(serial, 1);
+    write(parallel, 4);
+
+    EXPECT_TRUE(Support::compare_files(serial, parallel));
+    compareFiles(infile, parallel);
+
+    FileUtils::deleteFile(serial);
+    FileUtils::deleteFile(parallel);
+}
+#endif
+
 TEST(LasWriterTest, streamhashwrite)
 {
     std::string infile(Support::datapath("las/autzen_trim.las"));